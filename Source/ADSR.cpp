@@ -121,6 +121,74 @@ float ::ADSR::Value(double time) const
    return ofLerp(stageStartValue, mStages[stage].target * mMult, lerp);
 }
 
+bool ::ADSR::Process(double time, float* out, int bufferSize) const
+{
+   int pos = 0;
+   while (pos < bufferSize)
+   {
+      double stageStartTime;
+      int stage = GetStage(time, stageStartTime);
+      if (stage == mNumStages)  //done, and stays done until the next Start()
+      {
+         float value = mStages[stage-1].target;
+         for (; pos<bufferSize; ++pos)
+            out[pos] = value;
+         return false;
+      }
+      
+      //same start and target as Value()
+      float stageStartValue;
+      if (stage == 0)
+         stageStartValue = mStartBlendFromValue;
+      else if (mHasSustainStage && stage == mSustainStage + 1)
+         stageStartValue = mStopBlendFromValue;
+      else
+         stageStartValue = mStages[stage-1].target * mMult;
+      float target = mStages[stage].target * mMult;
+      float curve = mStages[stage].curve * ((stageStartValue < target) ? 1 : -1);
+      float curveExponent = powf(5, -curve);   //MathUtils::Curve(), with the exponent worked out once per stage
+      
+      //run this stage until it times out, or the release cuts in
+      bool isSustain = mHasSustainStage && stage == mSustainStage;
+      bool canRelease = mHasSustainStage && stage <= mSustainStage && mStopTime > mStartTime;
+      double stageEndTime = stageStartTime + mStages[stage].time;
+      double lerp = (time - stageStartTime) / mStages[stage].time;
+      double lerpStep = gInvSampleRateMs / mStages[stage].time;
+      int stageStartPos = pos;
+      for (; pos<bufferSize; ++pos)
+      {
+         if (canRelease && time >= mStopTime)
+            break;
+         if (time > stageEndTime)
+         {
+            if (!isSustain)
+               break;
+            out[pos] = target;   //holding at the sustain level
+         }
+         else if (curve != 0)
+         {
+            out[pos] = ofLerp(stageStartValue, target, powf(lerp, curveExponent));
+         }
+         else
+         {
+            out[pos] = ofLerp(stageStartValue, target, lerp);
+         }
+         
+         time += gInvSampleRateMs;
+         lerp += lerpStep;
+      }
+      
+      if (pos == stageStartPos && pos < bufferSize)  //shouldn't happen, but never spin
+      {
+         out[pos] = Value(time);
+         time += gInvSampleRateMs;
+         ++pos;
+      }
+   }
+   
+   return !IsDone(time - gInvSampleRateMs);
+}
+
 int ::ADSR::GetStage(double time, double& stageStartTimeOut) const
 {
    if (mStartTime < 0)
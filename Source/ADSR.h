@@ -35,6 +35,9 @@ public:
    void Start(double time, float target, const ADSR& adsr);
    void Stop(double time, bool warn = true);
    float Value(double time) const;
+   //Value() for every sample of a block, stepping through each stage instead of looking it up per sample.
+   //returns false if the envelope is done by the end of the block
+   bool Process(double time, float* out, int bufferSize) const;
    void Set(float a, float d, float s, float r, float h = -1);
    void Set(const ADSR& other);
    void Clear() { mMult = 0; mStartTime = -10000; mStopTime = -10000; mStartBlendFromValue = 0; mStopBlendFromValue = 0; }
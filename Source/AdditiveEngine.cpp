@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    AdditiveEngine.cpp
+    Created: 17 Oct 2026 7:48:12pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "AdditiveEngine.h"
+#include "Float4.h"
+#include "ScratchArena.h"
+
+const float AdditiveEngine::kAudibleThreshold = .00001f;
+
+AdditiveEngine::AdditiveEngine(int maxPartials)
+: mPhases(maxPartials)
+, mLastAmplitudes(maxPartials, 0.0f)
+, mNumRendered(0)
+{
+}
+
+void AdditiveEngine::Reset()
+{
+   for (size_t i=0; i<mPhases.size(); ++i)
+   {
+      mPhases[i].Reset();
+      mLastAmplitudes[i] = 0;
+   }
+}
+
+void AdditiveEngine::Process(const float* freqs, const float* ratios, const float* amplitudes, int numPartials, float* out, int bufferSize)
+{
+   assert(numPartials <= (int)mPhases.size());
+   
+   float maxFreq = 0;
+   float freqSum = 0;
+   for (int i=0; i<bufferSize; ++i)
+   {
+      maxFreq = MAX(maxFreq, freqs[i]);
+      freqSum += freqs[i];
+   }
+   
+   ScratchArena::Scope scratch;
+   float* partial = scratch.GetBuffer();
+   float rampStep = 1.0f / bufferSize;
+   const Float4 rampOffsets = Float4::Set(1, 2, 3, 4);
+   
+   mNumRendered = 0;
+   for (int p=0; p<numPartials; ++p)
+   {
+      float start = mLastAmplitudes[p];
+      float end = amplitudes[p];
+      
+      if (maxFreq * ratios[p] >= gNyquistLimit)
+      {
+         mLastAmplitudes[p] = 0;   //fade back in if the pitch comes down again
+         continue;
+      }
+      mLastAmplitudes[p] = end;
+      
+      if (fabsf(start) < kAudibleThreshold && fabsf(end) < kAudibleThreshold)
+      {
+         mPhases[p].Advance(freqSum, ratios[p]);
+         continue;
+      }
+      
+      RenderSine(mPhases[p], freqs, ratios[p], partial, bufferSize);
+      ++mNumRendered;
+      
+      //gain ramps to land on end at the last sample
+      float step = (end - start) * rampStep;
+      int i = 0;
+      for (; i+4<=bufferSize; i+=4)
+      {
+         Float4 gain = Float4::Set(start + step * i) + rampOffsets * Float4::Set(step);
+         (Float4::Load(out + i) + Float4::Load(partial + i) * gain).Store(out + i);
+      }
+      for (; i<bufferSize; ++i)
+         out[i] += partial[i] * (start + step * (i+1));
+   }
+}
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    AdditiveEngine.h
+    Created: 17 Oct 2026 7:48:12pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OscillatorKernels.h"
+#include <vector>
+
+//bank of sine partials over a common fundamental, for additive synths.
+//partial amplitudes are control rate: set once per block, and ramped linearly from the previous block's values.
+//partials that are inaudible for the whole block only advance their phase, partials above nyquist are skipped.
+class AdditiveEngine
+{
+public:
+   AdditiveEngine(int maxPartials);
+
+   void Reset();
+
+   //adds partials at freqs[i] * ratios[p] hz into out. amplitudes[p] is where partial p should be by the end of the block
+   void Process(const float* freqs, const float* ratios, const float* amplitudes, int numPartials, float* out, int bufferSize);
+
+   int GetNumRenderedPartials() const { return mNumRendered; }
+
+   static const float kAudibleThreshold;   //-100dB
+
+private:
+   std::vector<PhaseAccumulator> mPhases;
+   std::vector<float> mLastAmplitudes;
+   int mNumRendered;
+};
@@ -9,6 +9,7 @@
 #include "Amplifier.h"
 #include "ModularSynth.h"
 #include "Profiler.h"
+#include "ScratchArena.h"
 
 Amplifier::Amplifier()
 : IAudioProcessor(gBufferSize)
@@ -39,16 +40,18 @@ void Amplifier::Process(double time)
    
    if (GetTarget())
    {
+      ScratchArena::Scope scratch;
+      float* workBuffer = scratch.GetBuffer();
       ChannelBuffer* out = GetTarget()->GetBuffer();
       for (int ch=0; ch<GetBuffer()->NumActiveChannels(); ++ch)
       {
          for (int i=0; i<bufferSize; ++i)
          {
             ComputeSliders(i);
-            gWorkBuffer[i] = GetBuffer()->GetChannel(ch)[i] * mGain;
+            workBuffer[i] = GetBuffer()->GetChannel(ch)[i] * mGain;
          }
-         Add(out->GetChannel(ch), gWorkBuffer, GetBuffer()->BufferSize());
-         GetVizBuffer()->WriteChunk(gWorkBuffer, GetBuffer()->BufferSize(), ch);
+         Add(out->GetChannel(ch), workBuffer, GetBuffer()->BufferSize());
+         GetVizBuffer()->WriteChunk(workBuffer, GetBuffer()->BufferSize(), ch);
       }
    }
    
@@ -0,0 +1,317 @@
+/*
+  ==============================================================================
+
+    AudioGraphScheduler.cpp
+    Created: 17 Oct 2026 10:12:41am
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "AudioGraphScheduler.h"
+#include "IAudioSource.h"
+#include "IAudioReceiver.h"
+#include "ScratchArena.h"
+#include "IDrawableModule.h"
+#include "Profiler.h"
+
+namespace
+{
+   void ProcessSource(IAudioSource* source, double time)
+   {
+      if (!Profiler::IsEnabled())
+      {
+         source->Process(time);
+         return;
+      }
+
+      //track each module instance separately
+      IDrawableModule* module = dynamic_cast<IDrawableModule*>(source);
+      Profiler profilerScopeHolder(module ? module->Name() : "audio source", Profiler::HashInstance(source), true);
+      source->Process(time);
+   }
+}
+
+AudioGraphScheduler::AudioGraphScheduler()
+: mPlan(nullptr)
+, mCurrentStage(nullptr)
+, mBusyWorkers(0)
+, mTime(0)
+, mProfilerScope(-1)
+, mJobInUse(0)
+, mJob(nullptr)
+, mJobCount(0)
+, mNextJobIndex(0)
+, mJobIndicesRemaining(0)
+, mJobHelpers(0)
+, mJobProfilerScope(-1)
+{
+}
+
+AudioGraphScheduler::~AudioGraphScheduler()
+{
+   StopWorkers();
+}
+
+void AudioGraphScheduler::SetNumWorkerThreads(int numThreads)
+{
+   numThreads = CLAMP(numThreads, 0, kMaxWorkerThreads);
+   if (numThreads == (int)mWorkers.size())
+      return;
+
+   StopWorkers();
+   for (int i=0; i<numThreads; ++i)
+   {
+      Worker* worker = new Worker(this, i);
+      worker->startThread(10);   //highest priority, same class as the device callback
+      mWorkers.push_back(worker);
+   }
+
+   ofLog() << "audio graph using " << numThreads << " worker threads";
+}
+
+void AudioGraphScheduler::StopWorkers()
+{
+   for (auto* worker : mWorkers)
+      worker->Stop();
+   for (auto* worker : mWorkers)
+      delete worker;
+   mWorkers.clear();
+}
+
+AudioGraphScheduler::Plan::Plan(const vector<SourceDepInfo>& sortedSources)
+{
+   for (const auto& info : sortedSources)
+      mSources.push_back(info.mMe);
+
+   //stage index is the length of the longest dependency chain leading into a source
+   std::map<IAudioSource*, int> stageIndex;
+   int numStages = 0;
+   for (const auto& info : sortedSources)
+   {
+      int index = 0;
+      for (auto* dep : info.mDeps)
+      {
+         auto iter = stageIndex.find(dep);
+         if (iter != stageIndex.end())   //circular dependencies are missing here, run them after what we know about
+            index = MAX(index, iter->second + 1);
+      }
+      stageIndex[info.mMe] = index;
+      numStages = MAX(numStages, index + 1);
+   }
+
+   for (int i=0; i<numStages; ++i)
+      mStages.push_back(new Stage());
+
+   for (int s=0; s<numStages; ++s)
+   {
+      //sources that share a receiver are summed into the same buffer, keep them on one thread in graph order
+      vector<IAudioSource*> sources;
+      for (const auto& info : sortedSources)
+      {
+         if (stageIndex[info.mMe] == s)
+            sources.push_back(info.mMe);
+      }
+
+      vector<int> group(sources.size());
+      for (int i=0; i<(int)sources.size(); ++i)
+         group[i] = i;
+      for (int i=0; i<(int)sources.size(); ++i)
+      {
+         for (int j=0; j<i; ++j)
+         {
+            bool sharesReceiver = false;
+            for (int a=0; a<sources[i]->GetNumTargets() && !sharesReceiver; ++a)
+            {
+               IAudioReceiver* target = sources[i]->GetTarget(a);
+               if (target == nullptr)
+                  continue;
+               for (int b=0; b<sources[j]->GetNumTargets(); ++b)
+               {
+                  if (sources[j]->GetTarget(b) == target)
+                     sharesReceiver = true;
+               }
+            }
+
+            if (sharesReceiver && group[i] != group[j])
+            {
+               int from = MAX(group[i], group[j]);
+               int to = MIN(group[i], group[j]);
+               for (int k=0; k<=i; ++k)
+               {
+                  if (group[k] == from)
+                     group[k] = to;
+               }
+            }
+         }
+      }
+
+      vector<int> taskForGroup(sources.size(), -1);
+      for (int i=0; i<(int)sources.size(); ++i)
+      {
+         if (taskForGroup[group[i]] == -1)
+         {
+            taskForGroup[group[i]] = (int)mStages[s]->mTasks.size();
+            mStages[s]->mTasks.push_back(Task());
+         }
+         mStages[s]->mTasks[taskForGroup[group[i]]].mSources.push_back(sources[i]);
+      }
+   }
+}
+
+AudioGraphScheduler::Plan::~Plan()
+{
+   for (auto* stage : mStages)
+      delete stage;
+}
+
+void AudioGraphScheduler::Process(double time)
+{
+   if (mPlan == nullptr)
+      return;
+
+   if (mWorkers.empty())
+   {
+      for (auto* source : mPlan->mSources)
+         ProcessSource(source, time);
+      return;
+   }
+
+   mTime = time;
+   mProfilerScope = Profiler::GetCurrentScope();
+
+   for (auto* stage : mPlan->mStages)
+   {
+      int numTasks = (int)stage->mTasks.size();
+      if (numTasks == 1)
+      {
+         for (auto& task : stage->mTasks)
+         {
+            for (auto* source : task.mSources)
+               ProcessSource(source, time);
+         }
+         continue;
+      }
+
+      stage->mTasksRemaining.set(numTasks);
+      stage->mNextTask.set(0);
+      mCurrentStage.set(stage);
+
+      int numToWake = MIN((int)mWorkers.size(), numTasks - 1);
+      for (int i=0; i<numToWake; ++i)
+         mWorkers[i]->Wake();
+
+      RunStage(stage);
+
+      //join. spin rather than block, the remaining tasks are already running
+      while (stage->mTasksRemaining.get() > 0)
+         Thread::yield();
+
+      mCurrentStage.set(nullptr);
+   }
+}
+
+void AudioGraphScheduler::RunStage(Stage* stage)
+{
+   int numTasks = (int)stage->mTasks.size();
+   while (true)
+   {
+      int taskIndex = ++stage->mNextTask - 1;
+      if (taskIndex >= numTasks)
+         break;
+
+      ScratchArena::ForThisThread().Reset();
+      for (auto* source : stage->mTasks[taskIndex].mSources)
+         ProcessSource(source, mTime);
+
+      --stage->mTasksRemaining;
+   }
+}
+
+void AudioGraphScheduler::RunParallel(ParallelJob* job, int count)
+{
+   if (mWorkers.empty() || count <= 1 || !mJobInUse.compareAndSetBool(1, 0))
+   {
+      for (int i=0; i<count; ++i)
+         job->Run(i);
+      return;
+   }
+
+   mJobCount = count;
+   mNextJobIndex.set(0);
+   mJobIndicesRemaining.set(count);
+   mJobProfilerScope = Profiler::GetCurrentScope();
+   mJob.set(job);
+
+   //workers that are in the middle of a graph stage pick the job up when they finish their task
+   int numToWake = MIN((int)mWorkers.size(), count - 1);
+   for (int i=0; i<numToWake; ++i)
+      mWorkers[i]->Wake();
+
+   RunJob();
+
+   while (mJobIndicesRemaining.get() > 0)
+      Thread::yield();
+
+   //don't let the job go until every worker that saw it has let go of it too
+   mJob.set(nullptr);
+   while (mJobHelpers.get() > 0)
+      Thread::yield();
+
+   mJobInUse.set(0);
+}
+
+void AudioGraphScheduler::RunJob()
+{
+   ++mJobHelpers;
+   ParallelJob* job = mJob.get();
+   if (job != nullptr)
+   {
+      Profiler::InheritScope profilerScope(mJobProfilerScope);
+      while (true)
+      {
+         int index = ++mNextJobIndex - 1;
+         if (index >= mJobCount)
+            break;
+
+         job->Run(index);
+         --mJobIndicesRemaining;
+      }
+   }
+   --mJobHelpers;
+}
+
+AudioGraphScheduler::Worker::Worker(AudioGraphScheduler* owner, int index)
+: Thread("audio graph worker " + String(index))
+, mOwner(owner)
+{
+}
+
+void AudioGraphScheduler::Worker::Stop()
+{
+   signalThreadShouldExit();
+   mWakeEvent.signal();
+   stopThread(1000);
+}
+
+void AudioGraphScheduler::Worker::run()
+{
+   ScratchArena::ForThisThread();   //allocate this thread's scratch memory up front, rather than in the middle of a block
+   
+   while (!threadShouldExit())
+   {
+      mWakeEvent.wait();
+      if (threadShouldExit())
+         break;
+
+      ++mOwner->mBusyWorkers;
+      Stage* stage = mOwner->mCurrentStage.get();
+      if (stage != nullptr)
+      {
+         Profiler::InheritScope profilerScope(mOwner->mProfilerScope);
+         mOwner->RunStage(stage);
+      }
+      mOwner->RunJob();
+      --mOwner->mBusyWorkers;
+   }
+}
@@ -0,0 +1,119 @@
+/*
+  ==============================================================================
+
+    AudioGraphScheduler.h
+    Created: 17 Oct 2026 10:12:41am
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SynthGlobals.h"
+
+class IAudioSource;
+class IAudioReceiver;
+
+struct SourceDepInfo
+{
+   SourceDepInfo(IAudioSource* me) : mMe(me) {}
+   IAudioSource* mMe;
+   vector<IAudioSource*> mDeps;   //sources patched into us with audio, and audio-rate modulators of our sliders
+};
+
+//runs the sources of the audio graph across a pool of worker threads.
+//sources are grouped into stages by dependency depth, and every stage is a barrier.
+//within a stage, sources that write into the same receiver are kept together in one task
+//and processed in graph order, so the result doesn't depend on the number of threads.
+class AudioGraphScheduler
+{
+   struct Stage;
+public:
+   AudioGraphScheduler();
+   ~AudioGraphScheduler();
+
+   //a sorted graph, ready to run. built off of the audio thread, then handed over with SetPlan()
+   class Plan
+   {
+   public:
+      Plan(const vector<SourceDepInfo>& sortedSources);
+      ~Plan();
+      int GetNumStages() const { return (int)mStages.size(); }
+   private:
+      friend class AudioGraphScheduler;
+      vector<IAudioSource*> mSources;
+      vector<Stage*> mStages;
+   };
+
+   //call with the audio thread locked
+   void SetNumWorkerThreads(int numThreads);
+
+   //audio thread only. doesn't take ownership, the caller frees old plans once IsIdle()
+   void SetPlan(Plan* plan) { mPlan = plan; }
+   const Plan* GetPlan() const { return mPlan; }
+   bool IsIdle() const { return mBusyWorkers.get() == 0; }
+
+   int GetNumWorkerThreads() const { return (int)mWorkers.size(); }
+   bool IsParallel() const { return !mWorkers.empty(); }
+   void Process(double time);
+
+   //work that a single source splits up to spread over the workers, like a synth rendering its voices
+   class ParallelJob
+   {
+   public:
+      virtual ~ParallelJob() {}
+      virtual void Run(int index) = 0;
+   };
+
+   //calls job->Run() for every index in [0, count) and returns once they have all finished.
+   //the calling thread takes part, along with any workers that aren't busy with the graph.
+   //runs everything on the calling thread if there are no workers or another job is already in flight
+   void RunParallel(ParallelJob* job, int count);
+
+   static const int kMaxWorkerThreads = 16;
+
+private:
+   struct Task
+   {
+      vector<IAudioSource*> mSources;
+   };
+
+   struct Stage
+   {
+      vector<Task> mTasks;
+      Atomic<int> mNextTask;
+      Atomic<int> mTasksRemaining;
+   };
+
+   class Worker : public Thread
+   {
+   public:
+      Worker(AudioGraphScheduler* owner, int index);
+      void Wake() { mWakeEvent.signal(); }
+      void Stop();
+      void run() override;
+   private:
+      AudioGraphScheduler* mOwner;
+      WaitableEvent mWakeEvent;
+   };
+
+   void RunStage(Stage* stage);
+   void RunJob();
+   void StopWorkers();
+
+   Plan* mPlan;
+   vector<Worker*> mWorkers;
+   Atomic<Stage*> mCurrentStage;
+   Atomic<int> mBusyWorkers;
+   double mTime;
+   int mProfilerScope;
+
+   Atomic<int> mJobInUse;
+   Atomic<ParallelJob*> mJob;
+   int mJobCount;
+   Atomic<int> mNextJobIndex;
+   Atomic<int> mJobIndicesRemaining;
+   Atomic<int> mJobHelpers;
+   int mJobProfilerScope;
+};
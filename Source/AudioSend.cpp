@@ -12,6 +12,7 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 #include "PatchCableSource.h"
+#include "ScratchArena.h"
 
 AudioSend::AudioSend()
 : IAudioProcessor(gBufferSize)
@@ -57,8 +58,9 @@ void AudioSend::Process(double time)
    SyncBuffers();
    mVizBuffer2.SetNumChannels(GetBuffer()->NumActiveChannels());
    
-   float* amountBuffer = gWorkBuffer;
-   float* dryAmountBuffer = gWorkBuffer+gBufferSize;
+   ScratchArena::Scope scratch;
+   float* amountBuffer = scratch.GetBuffer();
+   float* dryAmountBuffer = scratch.GetBuffer();
    for (int i=0; i<gBufferSize; ++i)
    {
       ComputeSliders(i);
@@ -68,14 +70,15 @@ void AudioSend::Process(double time)
    
    if (GetTarget(0))
    {
-      gWorkChannelBuffer.CopyFrom(GetBuffer(), GetBuffer()->BufferSize());
+      ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+      workBuffer->CopyFrom(GetBuffer(), GetBuffer()->BufferSize());
       for (int ch=0; ch<GetBuffer()->NumActiveChannels(); ++ch)
       {
          ChannelBuffer* out = GetTarget(0)->GetBuffer();
          if (mCrossfade)
-            Mult(gWorkChannelBuffer.GetChannel(ch), dryAmountBuffer, GetBuffer()->BufferSize());
-         Add(out->GetChannel(ch), gWorkChannelBuffer.GetChannel(ch), GetBuffer()->BufferSize());
-         GetVizBuffer()->WriteChunk(gWorkChannelBuffer.GetChannel(ch), GetBuffer()->BufferSize(), ch);
+            Mult(workBuffer->GetChannel(ch), dryAmountBuffer, GetBuffer()->BufferSize());
+         Add(out->GetChannel(ch), workBuffer->GetChannel(ch), GetBuffer()->BufferSize());
+         GetVizBuffer()->WriteChunk(workBuffer->GetChannel(ch), GetBuffer()->BufferSize(), ch);
       }
    }
    
@@ -35,6 +35,7 @@ public:
    
    //IModulator
    float Value(int samplesIn = 0) override;
+   bool IsAudioRate() const override { return true; }
    bool Active() const override { return mEnabled; }
    
    //IFloatSliderListener
@@ -9,6 +9,8 @@
 #include "BandVocoder.h"
 #include "ModularSynth.h"
 #include "Profiler.h"
+#include "ScratchArena.h"
+#include "Float4.h"
 
 BandVocoder::BandVocoder()
 : IAudioProcessor(gBufferSize)
@@ -32,23 +34,17 @@ BandVocoder::BandVocoder()
 , mRingTimeSlider(nullptr)
 , mMaxBand(.3f)
 , mMaxBandSlider(nullptr)
+, mInputBands(VOCODER_MAX_BANDS)
+, mCarrierBands(VOCODER_MAX_BANDS)
 {
    mCarrierInputBuffer = new float[GetBuffer()->BufferSize()];
    Clear(mCarrierInputBuffer, GetBuffer()->BufferSize());
    
-   mWorkBuffer = new float[GetBuffer()->BufferSize()];
-   Clear(mWorkBuffer, GetBuffer()->BufferSize());
-   
    mOutBuffer = new float[GetBuffer()->BufferSize()];
    Clear(mOutBuffer, GetBuffer()->BufferSize());
    
-   for (int i=0; i<VOCODER_MAX_BANDS; ++i)
-   {
-      mPeaks[i].SetDecayTime(mRingTime);
-      mOutputPeaks[i].SetDecayTime(mRingTime);
-      mPeaks[i].SetLimit(mMaxBand);
-      mOutputPeaks[i].SetLimit(mMaxBand);
-   }
+   Clear(mPeaks, VOCODER_MAX_BANDS);
+   Clear(mPrevPeaks, VOCODER_MAX_BANDS);
    
    CalcFilters();
 }
@@ -71,7 +67,7 @@ void BandVocoder::CreateUIControls()
 BandVocoder::~BandVocoder()
 {
    delete[] mCarrierInputBuffer;
-   delete[] mWorkBuffer;
+   delete[] mOutBuffer;
 }
 
 void BandVocoder::SetCarrierBuffer(float *carrier, int bufferSize)
@@ -101,34 +97,23 @@ void BandVocoder::Process(double time)
    Mult(GetBuffer()->GetChannel(0), inputPreampSq, bufferSize);
    Mult(mCarrierInputBuffer, carrierPreampSq, bufferSize);
    
-   for (int i=0; i<mNumBands; ++i)
+   BufferCopy(mPrevPeaks, mPeaks, VOCODER_MAX_BANDS);
+   
+   //get modulator bands and their levels, in chunks that fit every band in a scratch buffer
    {
-      //get modulator band
-      BufferCopy(mWorkBuffer,GetBuffer()->GetChannel(0), bufferSize);
-      mBiquadCarrier[i].Filter(mWorkBuffer, bufferSize);
-      
-      float oldPeak = mPeaks[i].GetPeak();
-      
-      //calculate modulator band level
-      mPeaks[i].Process(mWorkBuffer, bufferSize);
-      
-      //get carrier band
-      BufferCopy(mWorkBuffer,mCarrierInputBuffer, bufferSize);
-      mBiquadOut[i].Filter(mWorkBuffer, bufferSize);
-      
-      //multiply carrier band by modulator band level
-      //Mult(mWorkBuffer, mPeaks[i].GetPeak(), bufferSize);
-      for (int j=0; j<bufferSize; ++j)
-         mWorkBuffer[j] *= ofMap(j,0,bufferSize,oldPeak,mPeaks[i].GetPeak());
-      
-      //don't allow a band to go crazy
-      /*mOutputPeaks[i].Process(mWorkBuffer, bufferSize);
-      if (mOutputPeaks[i].GetPeak() > mMaxBand)
-         Mult(mWorkBuffer, 1/mOutputPeaks[i].GetPeak(), bufferSize);*/
-      
-      //accumulate output band into total output
-      Add(mOutBuffer, mWorkBuffer, bufferSize);
+      ScratchArena::Scope scratch;
+      float* bands = scratch.GetBuffer();
+      int chunkSize = kWorkBufferSize / mInputBands.GetStride();
+      for (int start=0; start<bufferSize; start += chunkSize)
+      {
+         int length = MIN(chunkSize, bufferSize - start);
+         mInputBands.Process(GetBuffer()->GetChannel(0) + start, bands, length);
+         TrackPeaks(bands, length);
+      }
    }
+   
+   //get carrier bands, multiplied by the modulator band levels (ramped across the buffer) and accumulated into the output
+   mCarrierBands.ProcessMix(mCarrierInputBuffer, mPrevPeaks, mPeaks, mOutBuffer, bufferSize);
 
    Mult(GetBuffer()->GetChannel(0), (1-mDryWet)/inputPreampSq * volSq, bufferSize);
    Mult(mOutBuffer, mDryWet * volSq, bufferSize);
@@ -162,36 +147,52 @@ void BandVocoder::DrawModule()
    ofSetColor(0,255,0);
    for (int i=0; i<mNumBands; ++i)
    {
-      ofLine(i*3,0,i*3,-mPeaks[i].GetPeak()*200);
+      ofLine(i*3,0,i*3,-mPeaks[i]*200);
    }
 }
 
 void BandVocoder::CalcFilters()
 {
+   mInputBands.SetNumBands(mNumBands);
+   mCarrierBands.SetNumBands(mNumBands);
+   
    for (int i=0; i<mNumBands; ++i)
    {
       float a = float(i)/mNumBands;
       //float f = Interp(a, mFreqMin, mFreqMax);
       float f = mFreqMin * powf(mFreqMax/mFreqMin, a);
       
+      FilterType type = kFilterType_Bandpass;
       if (i==0)
-      {
-         mBiquadCarrier[i].SetFilterType(kFilterType_Lowpass);
-         mBiquadOut[i].SetFilterType(kFilterType_Lowpass);
-      }
+         type = kFilterType_Lowpass;
       else if (i == mNumBands-1)
+         type = kFilterType_Highpass;
+      
+      mInputBands.SetBand(i, type, f, mQ);
+      mCarrierBands.SetBand(i, type, f, mQ);
+   }
+}
+
+//the PeakTracker follower, run across four bands at a time over interleaved band output
+void BandVocoder::TrackPeaks(const float* bands, int bufferSize)
+{
+   int stride = mInputBands.GetStride();
+   Float4 decay = Float4::Set(powf(0.5f, 1.0f/(mRingTime * gSampleRate)));
+   Float4 limit = Float4::Set(mMaxBand);
+   Float4 epsilon = Float4::Set(FLT_EPSILON);
+   Float4 zero = Float4::Zero();
+   for (int band=0; band<stride; band += 4)
+   {
+      Float4 peak = Float4::Load(mPeaks + band);
+      for (int i=0; i<bufferSize; ++i)
       {
-         mBiquadCarrier[i].SetFilterType(kFilterType_Highpass);
-         mBiquadOut[i].SetFilterType(kFilterType_Highpass);
-      }
-      else
-      {
-         mBiquadCarrier[i].SetFilterType(kFilterType_Bandpass);
-         mBiquadOut[i].SetFilterType(kFilterType_Bandpass);
+         Float4 input = Float4::Abs(Float4::Load(bands + i * stride + band));
+         Float4 decayed = peak * decay;
+         decayed = Float4::Select(Float4::LessThan(decayed, epsilon), zero, decayed);
+         //ride the peak to the top, decay exponentially when the signal is lower
+         peak = Float4::Select(Float4::LessThan(input, peak), decayed, Float4::Min(input, limit));
       }
-      
-      mBiquadCarrier[i].SetFilterParams(f, mQ);
-      mBiquadOut[i].SetFilterParams(f, mQ);
+      peak.Store(mPeaks + band);
    }
 }
 
@@ -213,22 +214,6 @@ void BandVocoder::FloatSliderUpdated(FloatSlider* slider, float oldVal)
    {
       CalcFilters();
    }
-   if (slider == mRingTimeSlider)
-   {
-      for (int i=0; i<VOCODER_MAX_BANDS; ++i)
-      {
-         mPeaks[i].SetDecayTime(mRingTime);
-         mOutputPeaks[i].SetDecayTime(mRingTime);
-      }
-   }
-   if (slider == mMaxBandSlider)
-   {
-      for (int i=0; i<VOCODER_MAX_BANDS; ++i)
-      {
-         mPeaks[i].SetLimit(mMaxBand);
-         mOutputPeaks[i].SetLimit(mMaxBand);
-      }
-   }
 }
 
 void BandVocoder::LoadLayout(const ofxJSONElement& moduleInfo)
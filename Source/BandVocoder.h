@@ -17,7 +17,7 @@
 #include "Slider.h"
 #include "BiquadFilterEffect.h"
 #include "VocoderCarrierInput.h"
-#include "PeakTracker.h"
+#include "BiquadFilterBank.h"
 
 #define VOCODER_MAX_BANDS 64
 
@@ -56,10 +56,10 @@ private:
    bool Enabled() const override { return mEnabled; }
    
    void CalcFilters();
+   void TrackPeaks(const float* bands, int bufferSize);
    
    float* mCarrierInputBuffer;
    
-   float* mWorkBuffer;
    float* mOutBuffer;
    
    float mInputPreamp;
@@ -83,10 +83,10 @@ private:
    float mMaxBand;
    FloatSlider* mMaxBandSlider;
    
-   BiquadFilter mBiquadCarrier[VOCODER_MAX_BANDS];
-   BiquadFilter mBiquadOut[VOCODER_MAX_BANDS];
-   PeakTracker mPeaks[VOCODER_MAX_BANDS];
-   PeakTracker mOutputPeaks[VOCODER_MAX_BANDS];
+   BiquadFilterBank mInputBands;
+   BiquadFilterBank mCarrierBands;
+   float mPeaks[VOCODER_MAX_BANDS];
+   float mPrevPeaks[VOCODER_MAX_BANDS];
 };
 
 
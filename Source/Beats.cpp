@@ -15,6 +15,7 @@
 #include "Profiler.h"
 #include "FillSaveDropdown.h"
 #include "PatchCableSource.h"
+#include "ScratchArena.h"
 
 Beats::Beats()
 : mBank(nullptr)
@@ -244,8 +245,10 @@ void BeatColumn::Process(double time, float* buffer, int bufferSize)
       beat->SetRate(speed);
       
       //TODO(Ryan) multichannel
-      gWorkChannelBuffer.SetNumActiveChannels(1);
-      if (beat->ConsumeData(time, &gWorkChannelBuffer, bufferSize, true))
+      ScratchArena::Scope scratch;
+      ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+      workBuffer->SetNumActiveChannels(1);
+      if (beat->ConsumeData(time, workBuffer, bufferSize, true))
       {
          mFilterRamp.Start(mFilter,10);
          
@@ -262,7 +265,7 @@ void BeatColumn::Process(double time, float* buffer, int bufferSize)
             float lowAmount = ofClamp(-filter/crossfade,0,1);
             float highAmount = ofClamp(filter/crossfade,0,1);
             
-            float normal = gWorkChannelBuffer.GetChannel(0)[i];
+            float normal = workBuffer->GetChannel(0)[i];
             float lowPassed = mLowpass.Filter(normal);
             float highPassed = mHighpass.Filter(normal);
             float sample = normal * normalAmount + lowPassed * lowAmount + highPassed * highAmount;
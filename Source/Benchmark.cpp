@@ -0,0 +1,370 @@
+/*
+  ==============================================================================
+
+    Benchmark.cpp
+    Created: 17 Oct 2026 4:38:50pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "HeadlessRender.h"
+#include "ModularSynth.h"
+#include "IAudioSource.h"
+#include "INoteReceiver.h"
+#include "ModuleContainer.h"
+#include "OutputChannel.h"
+#include "ScratchArena.h"
+#include "Transport.h"
+
+namespace
+{
+   const char* kBenchmarkFlag = "--benchmark";
+   const char* kFullPatchCase = "patch";
+   const double kWarmUpSeconds = .25;
+   const double kRetriggerMs = 250;
+   const char* kChainEffects[] = { "biquad", "delay", "distortion", "compressor", "tremolo", "eq", "butterworth", "dcremover" };
+   
+   struct BenchmarkCase
+   {
+      string mName;
+      string mSpawn;    //what you'd type into the console
+      bool mIsSynth;    //takes notes, and gets run at each voice count. otherwise it's fed by an oscillator
+   };
+   
+   struct BenchmarkResult
+   {
+      string mName;
+      int mBufferSize;
+      int mVoices;
+      double mNsPerSample;
+      double mRealtimeLoad;   //fraction of the block's duration spent processing
+      double mVoicesPerCore;
+   };
+   
+   vector<int> ParseIntList(string list)
+   {
+      vector<int> values;
+      for (auto token : ofSplitString(list, ",", true, true))
+      {
+         int value = ofToInt(token);
+         if (value > 0)
+            values.push_back(value);
+      }
+      return values;
+   }
+   
+   vector<BenchmarkCase> GetCases(int numChainEffects)
+   {
+      string chain = "effectchain";
+      for (int i=0; i<numChainEffects; ++i)
+         chain += string(" ") + kChainEffects[i % (sizeof(kChainEffects) / sizeof(kChainEffects[0]))];
+      
+      vector<BenchmarkCase> cases;
+      cases.push_back({ "oscillator", "oscillator", true });
+      cases.push_back({ "fmsynth", "fmsynth", true });
+      cases.push_back({ "karplusstrong", "karplusstrong", true });
+      cases.push_back({ "drumplayer", "drumplayer", true });
+      cases.push_back({ "granulator", "effectchain granulator", false });
+      cases.push_back({ "vocoder", "vocoder", false });
+      cases.push_back({ "freeverb", "effectchain freeverb", false });
+      cases.push_back({ "effectchain" + ofToString(numChainEffects), chain, false });
+      return cases;
+   }
+   
+   class BenchmarkPatch
+   {
+   public:
+      BenchmarkPatch(ModularSynth* synth) : mSynth(synth), mOutput(nullptr), mLastTriggerTime(-kRetriggerMs) {}
+      ~BenchmarkPatch()
+      {
+         for (auto* module : mModules)
+            module->GetOwningContainer()->DeleteModule(module);
+         mSynth->ArrangeAudioSourceDependencies();
+      }
+      
+      IDrawableModule* Spawn(string spawn)
+      {
+         IDrawableModule* module = mSynth->SpawnModuleOnTheFly(spawn, 0, 0);
+         if (module != nullptr)
+            mModules.push_back(module);
+         return module;
+      }
+      
+      //returns the module under test, patched into the output. effects get an oscillator feeding them
+      IAudioSource* Add(const BenchmarkCase& benchmarkCase, int voices)
+      {
+         if (mOutput == nullptr)
+            mOutput = Spawn("output");
+         
+         IDrawableModule* module = Spawn(benchmarkCase.mSpawn);
+         IAudioSource* source = dynamic_cast<IAudioSource*>(module);
+         if (source == nullptr || mOutput == nullptr)
+            return nullptr;
+         module->SetTarget(mOutput);
+         
+         if (benchmarkCase.mIsSynth)
+         {
+            AddNotes(dynamic_cast<INoteReceiver*>(module), voices);
+         }
+         else
+         {
+            IDrawableModule* input = Spawn("oscillator");
+            if (input == nullptr)
+               return nullptr;
+            input->SetTarget(module);
+            mInputs.push_back(dynamic_cast<IAudioSource*>(input));
+            AddNotes(dynamic_cast<INoteReceiver*>(input), 1);
+         }
+         
+         mSynth->ArrangeAudioSourceDependencies();
+         return source;
+      }
+      
+      //call before every block
+      void Update()
+      {
+         if (gTime - mLastTriggerTime < kRetriggerMs)
+            return;
+         mLastTriggerTime = gTime;
+         for (auto& notes : mNotes)
+         {
+            for (int i=0; i<notes.second; ++i)
+            {
+               int pitch = 48 + (i * 7) % 36;
+               notes.first->PlayNote(gTime, pitch, 0);
+               notes.first->PlayNote(gTime, pitch, 100);
+            }
+         }
+      }
+      
+      const vector<IAudioSource*>& GetInputs() const { return mInputs; }
+      OutputChannel* GetOutput() const { return dynamic_cast<OutputChannel*>(mOutput); }
+      
+   private:
+      void AddNotes(INoteReceiver* receiver, int voices)
+      {
+         if (receiver != nullptr)
+            mNotes.push_back(std::make_pair(receiver, voices));
+      }
+      
+      ModularSynth* mSynth;
+      IDrawableModule* mOutput;
+      vector<IDrawableModule*> mModules;
+      vector<IAudioSource*> mInputs;
+      vector< std::pair<INoteReceiver*, int> > mNotes;
+      double mLastTriggerTime;
+   };
+   
+   void AdvanceTime()
+   {
+      double elapsed = gInvSampleRateMs * gBufferSize;
+      gTime += elapsed;
+      TheTransport->Advance(elapsed);
+   }
+   
+   BenchmarkResult MakeResult(string name, int voices, int64 ticks, int64 numSamples)
+   {
+      double processSeconds = Time::highResolutionTicksToSeconds(ticks);
+      double audioSeconds = numSamples / (double)gSampleRate;
+      
+      BenchmarkResult result;
+      result.mName = name;
+      result.mBufferSize = gBufferSize;
+      result.mVoices = voices;
+      result.mNsPerSample = processSeconds * 1000000000 / numSamples;
+      result.mRealtimeLoad = processSeconds / audioSeconds;
+      result.mVoicesPerCore = voices > 0 && processSeconds > 0 ? voices * audioSeconds / processSeconds : 0;
+      return result;
+   }
+   
+   BenchmarkResult RunModuleCase(ModularSynth* synth, const BenchmarkCase& benchmarkCase, int voices, double seconds)
+   {
+      BenchmarkPatch patch(synth);
+      IAudioSource* source = patch.Add(benchmarkCase, voices);
+      if (source == nullptr)
+      {
+         printf("couldn't spawn %s\n", benchmarkCase.mSpawn.c_str());
+         return MakeResult(benchmarkCase.mName, 0, 0, 1);
+      }
+      
+      int warmUpBlocks = (int)(kWarmUpSeconds * gSampleRate / gBufferSize);
+      int numBlocks = MAX(1, (int)(seconds * gSampleRate / gBufferSize));
+      int64 ticks = 0;
+      for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+      {
+         ScratchArena::ForThisThread().Reset();
+         patch.GetOutput()->ClearBuffer();
+         AdvanceTime();
+         patch.Update();
+         for (auto* input : patch.GetInputs())
+            input->Process(gTime);
+         
+         int64 start = Time::getHighResolutionTicks();
+         source->Process(gTime);
+         if (block >= warmUpBlocks)
+            ticks += Time::getHighResolutionTicks() - start;
+      }
+      
+      return MakeResult(benchmarkCase.mName, benchmarkCase.mIsSynth ? voices : 0, ticks, (int64)numBlocks * gBufferSize);
+   }
+   
+   BenchmarkResult RunPatchCase(ModularSynth* synth, const vector<BenchmarkCase>& cases, int voices, double seconds)
+   {
+      BenchmarkPatch patch(synth);
+      int totalVoices = 0;
+      for (const auto& benchmarkCase : cases)
+      {
+         if (patch.Add(benchmarkCase, voices) != nullptr && benchmarkCase.mIsSynth)
+            totalVoices += voices;
+      }
+      
+      float* output[2];
+      output[0] = new float[gBufferSize];
+      output[1] = new float[gBufferSize];
+      int warmUpBlocks = (int)(kWarmUpSeconds * gSampleRate / gBufferSize);
+      int numBlocks = MAX(1, (int)(seconds * gSampleRate / gBufferSize));
+      int64 ticks = 0;
+      for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+      {
+         patch.Update();
+         
+         int64 start = Time::getHighResolutionTicks();
+         synth->AudioOut(output, gBufferSize, 2);   //advances gTime itself
+         if (block >= warmUpBlocks)
+            ticks += Time::getHighResolutionTicks() - start;
+         
+         if (block % 16 == 0)
+            synth->Poll();   //retire old audio graphs
+      }
+      delete[] output[0];
+      delete[] output[1];
+      
+      return MakeResult(kFullPatchCase, totalVoices, ticks, (int64)numBlocks * gBufferSize);
+   }
+   
+   bool WriteResults(const vector<BenchmarkResult>& results, string path)
+   {
+      if (String(path).endsWithIgnoreCase(".csv"))
+      {
+         string csv = "name,buffer_size,voices,ns_per_sample,realtime_load,voices_per_core\n";
+         for (const auto& result : results)
+         {
+            csv += result.mName + "," + ofToString(result.mBufferSize) + "," + ofToString(result.mVoices) + "," + ofToString(result.mNsPerSample, 3) + "," +
+                   ofToString(result.mRealtimeLoad, 6) + "," + ofToString(result.mVoicesPerCore, 1) + "\n";
+         }
+         return juce::File(path).replaceWithText(csv);
+      }
+      
+      ofxJSONElement json;
+      json["version"] = ProjectInfo::versionString;
+      json["date"] = Time::getCurrentTime().toISO8601(true).toStdString();
+      json["cpu_mhz"] = SystemStats::getCpuSpeedInMegahertz();
+      json["num_cpus"] = SystemStats::getNumCpus();
+      json["samplerate"] = gSampleRate;
+      json["audio_worker_threads"] = TheSynth->GetNumAudioWorkerThreads();
+      for (int i=0; i<(int)results.size(); ++i)
+      {
+         Json::Value& entry = json["results"][i];
+         entry["name"] = results[i].mName;
+         entry["buffer_size"] = results[i].mBufferSize;
+         entry["voices"] = results[i].mVoices;
+         entry["ns_per_sample"] = results[i].mNsPerSample;
+         entry["realtime_load"] = results[i].mRealtimeLoad;
+         entry["voices_per_core"] = results[i].mVoicesPerCore;
+      }
+      return json.save(path, true);
+   }
+}
+
+//static
+bool Benchmark::IsRequested(const StringArray& args)
+{
+   return args.contains(kBenchmarkFlag);
+}
+
+//static
+int Benchmark::Run(const StringArray& args)
+{
+   vector<int> bufferSizes = ParseIntList(HeadlessRender::GetOption(args, "--buffersizes", "64,256,1024"));
+   vector<int> voiceCounts = ParseIntList(HeadlessRender::GetOption(args, "--voices", "1,8,16"));
+   int numChainEffects = MAX(1, ofToInt(HeadlessRender::GetOption(args, "--effects", "4")));
+   double seconds = ofToFloat(HeadlessRender::GetOption(args, "--seconds", "2"));
+   string outputPath = HeadlessRender::GetOption(args, "--output", "");
+   vector<string> only = ofSplitString(HeadlessRender::GetOption(args, "--modules", ""), ",", true, true);
+   
+   vector<BenchmarkCase> cases;
+   for (const auto& benchmarkCase : GetCases(numChainEffects))
+   {
+      if (only.empty() || VectorContains(benchmarkCase.mName, only))
+         cases.push_back(benchmarkCase);
+   }
+   bool runPatch = only.empty() || VectorContains(string(kFullPatchCase), only);
+   
+   for (auto bufferSize : bufferSizes)
+   {
+      if (bufferSize > kWorkBufferSize)
+      {
+         printf("buffer size %d is bigger than the max of %d\n", bufferSize, kWorkBufferSize);
+         return 1;
+      }
+   }
+   for (auto& voices : voiceCounts)
+      voices = MIN(voices, kNumVoices);
+   if (bufferSizes.empty() || voiceCounts.empty() || seconds <= 0)
+   {
+      printf("nothing to run\n");
+      return 1;
+   }
+   
+   GlobalManagers globalManagers;
+   ModularSynth synth;
+   synth.Setup(&globalManagers, nullptr);
+   int sampleRate = gSampleRate;
+   
+   vector<BenchmarkResult> results;
+   printf("%-16s %8s %7s %12s %10s %16s\n", "module", "buffer", "voices", "ns/sample", "load", "voices/core");
+   for (auto bufferSize : bufferSizes)
+   {
+      //modules size their buffers when they're created, so every case spawns its own
+      synth.SetUpHeadless(sampleRate, bufferSize);
+      
+      vector<BenchmarkResult> bufferSizeResults;
+      for (const auto& benchmarkCase : cases)
+      {
+         if (benchmarkCase.mIsSynth)
+         {
+            for (auto voices : voiceCounts)
+               bufferSizeResults.push_back(RunModuleCase(&synth, benchmarkCase, voices, seconds));
+         }
+         else
+         {
+            bufferSizeResults.push_back(RunModuleCase(&synth, benchmarkCase, 1, seconds));
+         }
+         synth.Poll();   //free the audio graphs the spawning published
+      }
+      if (runPatch)
+         bufferSizeResults.push_back(RunPatchCase(&synth, GetCases(numChainEffects), voiceCounts.back(), seconds));
+      
+      for (const auto& result : bufferSizeResults)
+      {
+         printf("%-16s %8d %7d %12.2f %9.2f%% %16.1f\n", result.mName.c_str(), result.mBufferSize, result.mVoices,
+                result.mNsPerSample, result.mRealtimeLoad * 100, result.mVoicesPerCore);
+         results.push_back(result);
+      }
+   }
+   
+   if (outputPath != "")
+   {
+      outputPath = File::getCurrentWorkingDirectory().getChildFile(outputPath).getFullPathName().toStdString();
+      if (!WriteResults(results, outputPath))
+      {
+         printf("couldn't write %s\n", outputPath.c_str());
+         return 1;
+      }
+      printf("wrote %s\n", outputPath.c_str());
+   }
+   
+   return 0;
+}
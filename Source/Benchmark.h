@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+    Created: 17 Oct 2026 4:38:50pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+
+//bespoke --benchmark [--modules a,b,...] [--buffersizes 64,256,...] [--voices 1,8,...] [--effects n] [--seconds s] [--output <file.json|file.csv>]
+//
+//spawns modules through the module factory with no window or audio device, and times their Process() calls
+//at each buffer size and voice count. each case is reported as ns per sample, and for synths as how many
+//voices one core could run in real time. the whole-patch case times AudioOut() with every module spawned at once.
+class Benchmark
+{
+public:
+   static bool IsRequested(const StringArray& args);
+   static int Run(const StringArray& args);  //returns the process exit code
+};
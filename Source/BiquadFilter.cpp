@@ -29,20 +29,26 @@ void BiquadFilter::Clear()
 
 void BiquadFilter::UpdateFilterCoeff()
 {
-   if (mF<=0)
+   CalcCoeffs(mType, mF, mQ, mDbGain, mFF0, mFF1, mFF2, mFB1, mFB2);
+}
+
+//static
+void BiquadFilter::CalcCoeffs(FilterType type, float f, float q, float dbGain, float& ff0, float& ff1, float& ff2, float& fb1, float& fb2)
+{
+   if (f<=0)
    {
-      mFF0 = 0;
-      mFF1 = 0;
-      mFF2 = 0;
-      mFB1 = 0;
-      mFB2 = 0;
+      ff0 = 0;
+      ff1 = 0;
+      ff2 = 0;
+      fb1 = 0;
+      fb2 = 0;
       return;
    }
    
-   float w0 = gTwoPiOverSampleRate*mF;
+   float w0 = gTwoPiOverSampleRate*f;
    float cosw0 = cos(w0);
    float sinw0 = sin(w0);
-   float alpha = sinw0/(2*mQ);
+   float alpha = sinw0/(2*q);
    
    float b0 = 0;
    float b1 = 0;
@@ -51,7 +57,7 @@ void BiquadFilter::UpdateFilterCoeff()
    float a1 = 0;
    float a2 = 0;
    
-   if (mType == kFilterType_Lowpass)
+   if (type == kFilterType_Lowpass)
    {
       b0 = (1 - cosw0)/2;
       b1 =  1 - cosw0;
@@ -61,7 +67,7 @@ void BiquadFilter::UpdateFilterCoeff()
       a2 =  1 - alpha;
    }
    
-   if (mType == kFilterType_Highpass)
+   if (type == kFilterType_Highpass)
    {
       b0 = (1 + cosw0)/2;
       b1 =-(1 + cosw0);
@@ -71,7 +77,7 @@ void BiquadFilter::UpdateFilterCoeff()
       a2 =  1 - alpha;
    }
    
-   if (mType == kFilterType_Bandpass)
+   if (type == kFilterType_Bandpass)
    {
       b0 = sinw0/2;
       b1 = 0;
@@ -81,9 +87,9 @@ void BiquadFilter::UpdateFilterCoeff()
       a2 =  1 - alpha;
    }
    
-   if (mType == kFilterType_PeakNotch)
+   if (type == kFilterType_PeakNotch)
    {
-      float A = powf(10,(mDbGain/40));
+      float A = powf(10,(dbGain/40));
       b0 =   1 + alpha*A;
       b1 =  -2*cosw0;
       b2 =   1 - alpha*A;
@@ -92,11 +98,21 @@ void BiquadFilter::UpdateFilterCoeff()
       a2 =   1 - alpha/A;
    }
    
-   mFF0 = b0/a0;
-   mFF1 = b1/a0;
-   mFF2 = b2/a0;
-   mFB1 = a1/a0;
-   mFB2 = a2/a0;
+   if (a0 == 0)   //kFilterType_Off
+   {
+      ff0 = 0;
+      ff1 = 0;
+      ff2 = 0;
+      fb1 = 0;
+      fb2 = 0;
+      return;
+   }
+   
+   ff0 = b0/a0;
+   ff1 = b1/a0;
+   ff2 = b2/a0;
+   fb1 = a1/a0;
+   fb2 = a2/a0;
 }
 
 float BiquadFilter::Filter(float sample)
@@ -31,6 +31,9 @@ public:
    void UpdateFilterCoeff();
    void CopyCoeffFrom(BiquadFilter& other);
    
+   //normalized coefficients (a0 divided out) for the given response, shared with BiquadFilterBank
+   static void CalcCoeffs(FilterType type, float f, float q, float dbGain, float& ff0, float& ff1, float& ff2, float& fb1, float& fb2);
+   
    float Filter(float sample);
    void Filter(float* buffer, int bufferSize);
    
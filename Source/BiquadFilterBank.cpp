@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+    BiquadFilterBank.cpp
+    Created: 17 Oct 2026 6:20:44pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "BiquadFilterBank.h"
+#include "SynthGlobals.h"
+#include "Float4.h"
+
+namespace
+{
+   //same flush as FIX_DENORMAL, four lanes at a time
+   inline Float4 Undenormalise(Float4 x)
+   {
+      const Float4 kOffset = Float4::Set(.1f);
+      return (x + kOffset) - kOffset;
+   }
+}
+
+BiquadFilterBank::BiquadFilterBank(int maxBands)
+: mNumBands(0)
+, mStride(0)
+{
+   int padded = (maxBands + 3) & ~3;
+   BandParams off = { kFilterType_Off, 0, 1, 0 };
+   mParams.assign(padded, off);
+   mFF0.assign(padded, 0);
+   mFF1.assign(padded, 0);
+   mFF2.assign(padded, 0);
+   mFB1.assign(padded, 0);
+   mFB2.assign(padded, 0);
+   mState1.assign(padded, 0);
+   mState2.assign(padded, 0);
+}
+
+void BiquadFilterBank::SetNumBands(int numBands)
+{
+   assert(numBands <= (int)mParams.size());
+   mNumBands = numBands;
+   mStride = (numBands + 3) & ~3;
+
+   //silence the padding and anything past the end, SetBand() will bring them back
+   BandParams off = { kFilterType_Off, 0, 1, 0 };
+   for (int i=numBands; i<(int)mParams.size(); ++i)
+   {
+      mParams[i] = off;
+      mFF0[i] = mFF1[i] = mFF2[i] = mFB1[i] = mFB2[i] = 0;
+      mState1[i] = mState2[i] = 0;
+   }
+}
+
+void BiquadFilterBank::SetBand(int band, FilterType type, float f, float q, float dbGain)
+{
+   assert(band < mNumBands);
+   BandParams& params = mParams[band];
+   if (params.mType == type && params.mF == f && params.mQ == q && params.mDbGain == dbGain)
+      return;
+
+   if (params.mType != type)
+      mState1[band] = mState2[band] = 0;
+   params.mType = type;
+   params.mF = f;
+   params.mQ = q;
+   params.mDbGain = dbGain;
+   BiquadFilter::CalcCoeffs(type, f, q, dbGain, mFF0[band], mFF1[band], mFF2[band], mFB1[band], mFB2[band]);
+}
+
+void BiquadFilterBank::Clear()
+{
+   for (int i=0; i<(int)mState1.size(); ++i)
+      mState1[i] = mState2[i] = 0;
+}
+
+void BiquadFilterBank::Process(const float* input, float* output, int bufferSize)
+{
+   //one group of four bands at a time, so its coefficients and state stay in registers for the whole buffer
+   for (int band=0; band<mStride; band += 4)
+   {
+      Float4 ff0 = Float4::Load(&mFF0[band]);
+      Float4 ff1 = Float4::Load(&mFF1[band]);
+      Float4 ff2 = Float4::Load(&mFF2[band]);
+      Float4 fb1 = Float4::Load(&mFB1[band]);
+      Float4 fb2 = Float4::Load(&mFB2[band]);
+      Float4 state1 = Float4::Load(&mState1[band]);
+      Float4 state2 = Float4::Load(&mState2[band]);
+
+      for (int i=0; i<bufferSize; ++i)
+      {
+         Float4 x = Float4::Set(input[i]);
+         Float4 y = Undenormalise(ff0 * x + state1);
+         state1 = ff1 * x - fb1 * y + state2;
+         state2 = ff2 * x - fb2 * y;
+         y.Store(output + i * mStride + band);
+      }
+
+      state1.Store(&mState1[band]);
+      state2.Store(&mState2[band]);
+   }
+}
+
+void BiquadFilterBank::ProcessMix(const float* input, const float* startGains, const float* endGains, float* output, int bufferSize)
+{
+   float* state1 = mState1.data();
+   float* state2 = mState2.data();
+   float rampStep = 1.0f / bufferSize;
+
+   for (int i=0; i<bufferSize; ++i)
+   {
+      Float4 x = Float4::Set(input[i]);
+      Float4 ramp = Float4::Set(i * rampStep);
+      Float4 sum = Float4::Zero();
+      for (int band=0; band<mStride; band += 4)
+      {
+         Float4 s1 = Float4::Load(state1 + band);
+         Float4 s2 = Float4::Load(state2 + band);
+         Float4 fb1 = Float4::Load(&mFB1[band]);
+         Float4 fb2 = Float4::Load(&mFB2[band]);
+         Float4 y = Undenormalise(Float4::Load(&mFF0[band]) * x + s1);
+         (Float4::Load(&mFF1[band]) * x - fb1 * y + s2).Store(state1 + band);
+         (Float4::Load(&mFF2[band]) * x - fb2 * y).Store(state2 + band);
+
+         Float4 start = Float4::Load(startGains + band);
+         Float4 gain = start + (Float4::Load(endGains + band) - start) * ramp;
+         sum += y * gain;
+      }
+      output[i] += sum.Sum();
+   }
+}
@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    BiquadFilterBank.h
+    Created: 17 Oct 2026 6:20:44pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "BiquadFilter.h"
+#include <vector>
+
+//many biquads fed the same input, for filter banks like the band vocoder.
+//coefficients and state are stored band-by-band in parallel arrays, so four bands are filtered per SIMD operation
+//instead of running one BiquadFilter after another over the same buffer.
+//band coefficients are only recomputed when that band's parameters change.
+class BiquadFilterBank
+{
+public:
+   BiquadFilterBank(int maxBands);
+
+   void SetNumBands(int numBands);
+   int GetNumBands() const { return mNumBands; }
+   //bands are padded out to a multiple of four, unused bands output silence
+   int GetStride() const { return mStride; }
+
+   void SetBand(int band, FilterType type, float f, float q, float dbGain = 0);
+   void Clear();
+
+   //runs every band over input. output is interleaved by band: output[i * GetStride() + band]
+   void Process(const float* input, float* output, int bufferSize);
+   //runs every band over input and adds the bands to output, each scaled by a gain that ramps from startGains to endGains over the buffer
+   void ProcessMix(const float* input, const float* startGains, const float* endGains, float* output, int bufferSize);
+
+private:
+   struct BandParams
+   {
+      FilterType mType;
+      float mF;
+      float mQ;
+      float mDbGain;
+   };
+
+   int mNumBands;
+   int mStride;
+   std::vector<BandParams> mParams;
+
+   //transposed direct form II, one entry per band
+   std::vector<float> mFF0;
+   std::vector<float> mFF1;
+   std::vector<float> mFF2;
+   std::vector<float> mFB1;
+   std::vector<float> mFB2;
+   std::vector<float> mState1;
+   std::vector<float> mState2;
+};
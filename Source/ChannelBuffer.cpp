@@ -33,6 +33,19 @@ ChannelBuffer::ChannelBuffer(float* data, int bufferSize)
    mBufferSize = bufferSize;
 }
 
+ChannelBuffer::ChannelBuffer(float** data, int numChannels, int bufferSize)
+{
+   mActiveChannels = 1;
+   mNumChannels = numChannels;
+   mRecentActiveChannels = 1;
+   mOwnsBuffers = false;
+   
+   mBuffers = new float*[numChannels];
+   for (int i=0; i<numChannels; ++i)
+      mBuffers[i] = data[i];
+   mBufferSize = bufferSize;
+}
+
 ChannelBuffer::~ChannelBuffer()
 {
    if (mOwnsBuffers)
@@ -69,6 +82,12 @@ float* ChannelBuffer::GetChannel(int channel)
    return ret;
 }
 
+const float* ChannelBuffer::GetChannel(int channel) const
+{
+   //a channel that was never written is allocated as silence on first use, which doesn't change what's in the buffer
+   return const_cast<ChannelBuffer*>(this)->GetChannel(channel);
+}
+
 void ChannelBuffer::Clear() const
 {
    for (int i=0; i<mNumChannels; ++i)
@@ -99,7 +118,17 @@ void ChannelBuffer::SetMaxAllowedChannels(int channels)
       mActiveChannels = channels;
 }
 
-void ChannelBuffer::CopyFrom(ChannelBuffer* src, int length /*= -1*/)
+void ChannelBuffer::Swap(ChannelBuffer& other)
+{
+   std::swap(mActiveChannels, other.mActiveChannels);
+   std::swap(mNumChannels, other.mNumChannels);
+   std::swap(mBufferSize, other.mBufferSize);
+   std::swap(mBuffers, other.mBuffers);
+   std::swap(mRecentActiveChannels, other.mRecentActiveChannels);
+   std::swap(mOwnsBuffers, other.mOwnsBuffers);
+}
+
+void ChannelBuffer::CopyFrom(const ChannelBuffer* src, int length /*= -1*/)
 {
    if (length == -1)
       length = mBufferSize;
@@ -118,11 +147,15 @@ void ChannelBuffer::CopyFrom(ChannelBuffer* src, int length /*= -1*/)
          }
          BufferCopy(mBuffers[i], src->mBuffers[i], length);
       }
-      else
+      else if (mOwnsBuffers)
       {
          delete mBuffers[i];
          mBuffers[i] = nullptr;
       }
+      else
+      {
+         ::Clear(mBuffers[i], length);
+      }
    }
 }
 
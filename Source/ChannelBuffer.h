@@ -17,9 +17,11 @@ class ChannelBuffer
 public:
    ChannelBuffer(int bufferSize);
    ChannelBuffer(float* data, int bufferSize);  //intended as a temporary holder for passing raw data to methods that want a ChannelBuffer
+   ChannelBuffer(float** data, int numChannels, int bufferSize);  //wraps memory owned by someone else, like a ScratchArena
    ~ChannelBuffer();
    
    float* GetChannel(int channel);
+   const float* GetChannel(int channel) const;
    
    void Clear() const;
    
@@ -29,10 +31,11 @@ public:
    int RecentNumActiveChannels() const { return mRecentActiveChannels; }
    int NumTotalChannels() const { return mNumChannels; }
    int BufferSize() const { return mBufferSize; }
-   void CopyFrom(ChannelBuffer* src, int length = -1);
+   void CopyFrom(const ChannelBuffer* src, int length = -1);
    void SetChannelPointer(float* data, int channel, bool deleteOldData);
    void Reset() { Clear(); mRecentActiveChannels = mActiveChannels; SetNumActiveChannels(1); }
    void Resize(int bufferSize);
+   void Swap(ChannelBuffer& other);   //trades buffers without copying them
    
    void Save(FileStreamOut& out, int writeLength);
    void Load(FileStreamIn& in, int &readLength, bool setBufferSize);
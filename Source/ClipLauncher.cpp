@@ -15,6 +15,7 @@
 #include "Profiler.h"
 #include "Looper.h"
 #include "FillSaveDropdown.h"
+#include "ScratchArena.h"
 
 ClipLauncher::ClipLauncher()
 : mVolume(1)
@@ -69,17 +70,19 @@ void ClipLauncher::Process(double time)
       sample->SetRate(speed);
    }
    
+   ScratchArena::Scope scratch;
+   ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
    if (sample)
    {
-      gWorkChannelBuffer.SetNumActiveChannels(1);
-      sample->ConsumeData(time, &gWorkChannelBuffer, bufferSize, true);
+      workBuffer->SetNumActiveChannels(1);
+      sample->ConsumeData(time, workBuffer, bufferSize, true);
    }
    
    for (int i=0; i<bufferSize; ++i)
    {
       float samp = 0;
       if (sample)
-         samp = gWorkChannelBuffer.GetChannel(0)[i] * volSq;
+         samp = workBuffer->GetChannel(0)[i] * volSq;
       samp = mJumpBlender.Process(samp, i);
       out[i] += samp;
       GetVizBuffer()->Write(samp, 0);
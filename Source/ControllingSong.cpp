@@ -13,6 +13,7 @@
 #include "Transport.h"
 #include "Scale.h"
 #include "FollowingSong.h"
+#include "ScratchArena.h"
 
 ControllingSong::ControllingSong()
 : mVolume(.8f)
@@ -181,12 +182,14 @@ void ControllingSong::Process(double time)
          TheTransport->SetMeasurePos(measurePos);
       }
       
-      gWorkChannelBuffer.SetNumActiveChannels(1);
-      if (mSample.ConsumeData(time, &gWorkChannelBuffer, bufferSize, true))
+      ScratchArena::Scope scratch;
+      ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+      workBuffer->SetNumActiveChannels(1);
+      if (mSample.ConsumeData(time, workBuffer, bufferSize, true))
       {
          for (int i=0; i<bufferSize; ++i)
          {
-            float sample = gWorkChannelBuffer.GetChannel(0)[i] * volSq;
+            float sample = workBuffer->GetChannel(0)[i] * volSq;
             if (mMute)
                sample = 0;
             out[i] += sample;
@@ -15,6 +15,7 @@
 #include "Profiler.h"
 #include "FillSaveDropdown.h"
 #include "UIControlMacros.h"
+#include "ScratchArena.h"
 
 DrumPlayer::DrumPlayer()
 : mSpeed(1)
@@ -41,6 +42,7 @@ DrumPlayer::DrumPlayer()
 , mGridController(nullptr)
 , mNoteInputBuffer(this)
 , mNeedSetup(true)
+, mSampleFormat(kSampleFormat_Float)
 {
    ReadKits();
    
@@ -207,6 +209,7 @@ void DrumPlayer::DrumHit::SetUIControlsShowing(bool showing)
 
 DrumPlayer::~DrumPlayer()
 {
+   CancelSampleLoads();
    for (int i=0; i<mIndividualOutputs.size(); ++i)
       delete mIndividualOutputs[i];
 }
@@ -218,19 +221,42 @@ void DrumPlayer::LoadKit(int kit)
       // Maschine samples are in /Users/Shared/Maschine Library/Samples
       mLoadedKit = kit;
 
-      LoadSampleLock();
       for (int i=0; i<NUM_DRUM_HITS; ++i)
       {
-         mDrumHits[i].mSample.Read(mKits[kit].mSampleFiles[i].c_str());
+         //pads that are sounding right now get swapped first
+         SampleLoader::Priority priority = mDrumHits[i].mSample.IsPlaying() ? SampleLoader::kPriority_Audible : SampleLoader::kPriority_Normal;
+         LoadHitSample(i, mKits[kit].mSampleFiles[i], priority);
          mDrumHits[i].mLinkId = mKits[kit].mLinkIds[i];
          mDrumHits[i].mVol = mKits[kit].mVols[i];
          mDrumHits[i].mSpeed = mKits[kit].mSpeeds[i];
          mDrumHits[i].mPan = mKits[kit].mPans[i];
       }
-      LoadSampleUnlock();
    }
 }
 
+void DrumPlayer::LoadHitSample(int index, string path, SampleLoader::Priority priority, bool playWhenLoaded /*= false*/)
+{
+   TheSynth->GetSampleLoader()->Load(&mDrumHits[index].mSample, path, priority, [this, index, playWhenLoaded](Sample* loaded)
+   {
+      if (loaded == nullptr)
+         return;
+      LoadSampleLock();
+      mDrumHits[index].mSample.SwapData(*loaded);
+      LoadSampleUnlock();
+      if (playWhenLoaded)
+      {
+         mDrumHits[index].mSample.Play(gTime, mSpeed, 0);
+         mDrumHits[index].mVelocity = .5f;
+      }
+   }, false, false, mSampleFormat);
+}
+
+void DrumPlayer::CancelSampleLoads()
+{
+   for (int i=0; i<NUM_DRUM_HITS; ++i)
+      TheSynth->GetSampleLoader()->Cancel(&mDrumHits[i].mSample);
+}
+
 void DrumPlayer::LoadSampleLock()
 {
    mLoadSamplesAudioMutex.lock();
@@ -315,8 +341,10 @@ void DrumPlayer::Process(double time)
       for (int i=0; i<NUM_DRUM_HITS; ++i)
       {
          int individualOutputIndex = GetIndividualOutputIndex(i);
-         gWorkChannelBuffer.SetNumActiveChannels(numChannels);
-         if (mDrumHits[i].Process(time, mSpeed, volSq, &gWorkChannelBuffer, bufferSize))
+         ScratchArena::Scope scratch;
+         ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+         workBuffer->SetNumActiveChannels(numChannels);
+         if (mDrumHits[i].Process(time, mSpeed, volSq, workBuffer, bufferSize))
          {
             for (int ch=0; ch<numChannels; ++ch)
             {
@@ -324,12 +352,12 @@ void DrumPlayer::Process(double time)
                {
                   int targetIndex = individualOutputIndex + 1;
                   if (GetTarget(targetIndex))
-                     Add(GetTarget(targetIndex)->GetBuffer()->GetChannel(ch), gWorkChannelBuffer.GetChannel(ch), bufferSize);
-                  mIndividualOutputs[individualOutputIndex]->mVizBuffer->WriteChunk(gWorkChannelBuffer.GetChannel(ch), bufferSize, ch);
+                     Add(GetTarget(targetIndex)->GetBuffer()->GetChannel(ch), workBuffer->GetChannel(ch), bufferSize);
+                  mIndividualOutputs[individualOutputIndex]->mVizBuffer->WriteChunk(workBuffer->GetChannel(ch), bufferSize, ch);
                }
                else
                {
-                  Add(mOutputBuffer.GetChannel(ch), gWorkChannelBuffer.GetChannel(ch), bufferSize);
+                  Add(mOutputBuffer.GetChannel(ch), workBuffer->GetChannel(ch), bufferSize);
                }
             }
          }
@@ -484,9 +512,7 @@ void DrumPlayer::FilesDropped(vector<string> files, int x, int y)
             int sampleIdx = GetAssociatedSampleIndex(x+i%4, y+i/4);
             if (sampleIdx != -1)
             {
-               LoadSampleLock();
-               mDrumHits[sampleIdx].mSample.Read(files[i].c_str());
-               LoadSampleUnlock();
+               LoadHitSample(sampleIdx, files[i], SampleLoader::kPriority_Normal);
                mDrumHits[sampleIdx].mLinkId = -1;
                mDrumHits[sampleIdx].mVol = 1;
                mDrumHits[sampleIdx].mSpeed = 1;
@@ -518,6 +544,7 @@ void DrumPlayer::SampleDropped(int x, int y, Sample* sample)
       int sampleIdx = GetAssociatedSampleIndex(x,y);
       if (sampleIdx != -1)
       {
+         TheSynth->GetSampleLoader()->Cancel(&mDrumHits[sampleIdx].mSample);
          LoadSampleLock();
          mDrumHits[sampleIdx].mSample.Create(sample->Data());
          LoadSampleUnlock();
@@ -677,7 +704,9 @@ void DrumPlayer::DrumHit::DrawUIControls()
    if (!mOwner->mLoadingSamples)
    {
       mOwner->mLoadSamplesDrawMutex.lock();
-      DrawAudioBuffer(135, 100, mSample.Data(), 0, displayLength, mSample.GetPlayPosition());
+      const ChannelBuffer* drawData = mSample.GetDrawData();
+      float scale = float(drawData->BufferSize()) / MAX(1, mSample.LengthInSamples());   //compact samples draw from a smaller overview
+      DrawAudioBuffer(135, 100, drawData, 0, displayLength * scale, mSample.GetPlayPosition() * scale);
       mOwner->mLoadSamplesDrawMutex.unlock();
    }
    ofPopMatrix();
@@ -839,13 +868,7 @@ void DrumPlayer::FloatSliderUpdated(FloatSlider* slider, float oldVal)
          
          string file = files[mAuditionSampleIdx].getFullPathName().toStdString();
          if (mAuditionPadIdx >= 0 && mAuditionPadIdx < NUM_DRUM_HITS)
-         {
-            LoadSampleLock();
-            mDrumHits[mAuditionPadIdx].mSample.Read(file.c_str());
-            LoadSampleUnlock();
-            mDrumHits[mAuditionPadIdx].mSample.Play(gTime, mSpeed, 0);
-            mDrumHits[mAuditionPadIdx].mVelocity = .5f;
-         }
+            LoadHitSample(mAuditionPadIdx, file, SampleLoader::kPriority_Audible, true);
       }
    }
 }
@@ -925,11 +948,7 @@ void DrumPlayer::DrumHit::LoadRandomSample()
    {
       string file = files[rand() % files.size()].getFullPathName().toStdString();
       
-      mOwner->LoadSampleLock();
-      mSample.Read(file.c_str());
-      mOwner->LoadSampleUnlock();
-      //mSample.Play(gTime, mSpeed, 0);
-      //mVelocity = .5f;
+      mOwner->LoadHitSample(int(this - mOwner->mDrumHits), file, SampleLoader::kPriority_Normal);
    }
 }
 
@@ -949,6 +968,8 @@ vector<IUIControl*> DrumPlayer::ControlsToNotSetDuringLoadState() const
 void DrumPlayer::LoadLayout(const ofxJSONElement& moduleInfo)
 {
    mModuleSaveData.LoadString("target", moduleInfo);
+   EnumMap formatMap = GetSampleFormatEnumMap();
+   mModuleSaveData.LoadEnum<SampleFormat>("sampleformat", moduleInfo, kSampleFormat_Default, nullptr, &formatMap);
 
    SetUpFromSaveData();
 }
@@ -956,6 +977,10 @@ void DrumPlayer::LoadLayout(const ofxJSONElement& moduleInfo)
 void DrumPlayer::SetUpFromSaveData()
 {
    SetTarget(TheSynth->FindModule(mModuleSaveData.GetString("target")));
+   //applies to hits loaded from here on
+   mSampleFormat = ResolveSampleFormat(mModuleSaveData.GetEnum<SampleFormat>("sampleformat"));
+   for (int i=0; i<NUM_DRUM_HITS; ++i)
+      mDrumHits[i].mSample.SetStorageFormat(mSampleFormat);
    //LoadKit(0);
 }
 
@@ -988,6 +1013,7 @@ void DrumPlayer::LoadState(FileStreamIn& in)
    in >> rev;
    LoadStateValidate(rev <= kSaveStateRev);
    
+   CancelSampleLoads();   //the saved samples win over anything still on its way in
    for (int i=0; i<NUM_DRUM_HITS; ++i)
    {
       mDrumHits[i].mSample.LoadState(in);
@@ -27,6 +27,7 @@
 #include "PatchCableSource.h"
 #include "RollingBuffer.h"
 #include "GridController.h"
+#include "SampleLoader.h"
 
 #define NUM_DRUM_HITS 16
 
@@ -133,9 +134,12 @@ private:
    GridController* mGridController;
    NoteInputBuffer mNoteInputBuffer;
    bool mNeedSetup;
+   SampleFormat mSampleFormat;
    
    void LoadSampleLock();
    void LoadSampleUnlock();
+   void LoadHitSample(int index, string path, SampleLoader::Priority priority, bool playWhenLoaded = false);
+   void CancelSampleLoads();
    
    struct IndividualOutput
    {
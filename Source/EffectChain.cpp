@@ -11,6 +11,7 @@
 #include "SynthGlobals.h"
 #include "ModularSynth.h"
 #include "Profiler.h"
+#include "ScratchArena.h"
 
 const double gSwapLength = 150.0;
 
@@ -120,8 +121,9 @@ void EffectChain::Process(double time)
          
          mEffects[i]->ProcessAudio(time,GetBuffer());
        
-         float* dryWetBuffer = gWorkBuffer;
-         float* invDryWetBuffer = gWorkBuffer + bufferSize;
+         ScratchArena::Scope scratch;
+         float* dryWetBuffer = scratch.GetBuffer();
+         float* invDryWetBuffer = scratch.GetBuffer();
          for (int j = 0; j < bufferSize; ++j)
          {
             ComputeSliders(j);
@@ -10,8 +10,16 @@
 #define __modularSynth__FFT__
 
 #include <iostream>
+#include <vector>
 
-// Variables for FFT routine
+//real FFT, nfft must be a power of two.
+//runs as a complex transform of half the size on split real/imaginary arrays,
+//with the bit reversal and twiddles planned up front and the butterflies done four at a time.
+//
+//the spectrum layout matches the mayer routines this replaced, since modules index into it directly:
+//output_re[k] is bin k, output_im[k] is the (positive sine) imaginary part of bin k+1,
+//and output_im[nfft/2-1] holds the real part of the nyquist bin. Inverse() takes the same layout
+//and returns the signal scaled by nfft.
 class FFT
 {
 public:
@@ -19,10 +27,25 @@ public:
    ~FFT();
    void Forward(float* input, float* output_re, float* output_im);
    void Inverse(float* input_re, float* input_im, float* output);
+   
+   //several channels or analysis windows through the same plan
+   void ForwardBatch(float* const* inputs, float* const* outputs_re, float* const* outputs_im, int count);
+   void InverseBatch(float* const* inputs_re, float* const* inputs_im, float* const* outputs, int count);
+   
+   int GetSize() const { return mNfft; }
 private:
+   void Transform(float* re, float* im) const;
+   
    int mNfft;        // size of FFT
    int mNumfreqs;    // number of frequencies represented (nfft/2 + 1)
-   float* mFft_data; // array for writing/reading to/from FFT function
+   int mHalf;        // size of the complex transform (nfft/2)
+   std::vector<int> mBitReverse;
+   std::vector<float> mTwiddleRe;   //butterflies spanning h use entries [h, 2h)
+   std::vector<float> mTwiddleIm;
+   std::vector<float> mSplitRe;     //e^(-2 pi i k / nfft), to split the half-size result into the real spectrum
+   std::vector<float> mSplitIm;
+   std::vector<float> mWorkRe;
+   std::vector<float> mWorkIm;
 };
 
 struct FFTData
@@ -44,17 +67,4 @@ struct FFTData
    float* mTimeDomain;
 };
 
-
-#ifndef MAYER_H
-#define MAYER_H
-
-#define REAL float
-
-void mayer_realfft(int n, REAL *real);
-void mayer_realifft(int n, REAL *real);
-
-#endif
-
-
-
 #endif /* defined(__modularSynth__FFT__) */
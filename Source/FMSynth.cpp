@@ -230,6 +230,7 @@ void FMSynth::FloatSliderUpdated(FloatSlider* slider, float oldVal)
 void FMSynth::LoadLayout(const ofxJSONElement& moduleInfo)
 {
    mModuleSaveData.LoadString("target", moduleInfo);
+   mModuleSaveData.LoadInt("voicelimit", moduleInfo, -1, -1, kMaxVoicePoolSize);
 
    SetUpFromSaveData();
 }
@@ -237,6 +238,9 @@ void FMSynth::LoadLayout(const ofxJSONElement& moduleInfo)
 void FMSynth::SetUpFromSaveData()
 {
    SetTarget(TheSynth->FindModule(mModuleSaveData.GetString("target")));
+   int voiceLimit = mModuleSaveData.GetInt("voicelimit");
+   if (voiceLimit > 0)
+      mPolyMgr.SetVoiceLimit(voiceLimit);
 }
 
 
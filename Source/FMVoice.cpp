@@ -12,6 +12,8 @@
 #include "Scale.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "OscillatorKernels.h"
+#include "ScratchArena.h"
 
 FMVoice::FMVoice(IDrawableModule* owner)
 : mOscPhase(0)
@@ -33,55 +35,103 @@ bool FMVoice::IsDone(double time)
    return mOsc.GetADSR()->IsDone(time);
 }
 
+float FMVoice::GetLevel(double time)
+{
+   return mOsc.GetADSR()->Value(time);
+}
+
 bool FMVoice::Process(double time, ChannelBuffer* out)
 {
    PROFILER(FMVoice);
 
    if (IsDone(time))
       return false;
-
-   for (int pos=0; pos<out->BufferSize(); ++pos)
+   
+   int bufferSize = out->BufferSize();
+   ScratchArena::Scope scratch;
+   float* oscFreq = scratch.GetBuffer();
+   float* harmFreq = scratch.GetBuffer();
+   float* harmFreq2 = scratch.GetBuffer();
+   float* harmDepth = scratch.GetBuffer();
+   float* harmDepth2 = scratch.GetBuffer();
+   float* oscGain = scratch.GetBuffer();
+   float* phaseOffset0 = scratch.GetBuffer();
+   float* phaseOffset1 = scratch.GetBuffer();
+   float* phaseOffset2 = scratch.GetBuffer();
+   float* phases = scratch.GetBuffer();
+   float* sine = scratch.GetBuffer();
+   float* modIdx = scratch.GetBuffer();
+   float* modIdx2 = scratch.GetBuffer();
+   
+   //envelopes for the block, then params, then the operators are each run over the whole block
+   bool running = mOsc.GetADSR()->Process(time, oscGain, bufferSize);
+   mHarm.GetADSR()->Process(time, harmDepth, bufferSize);
+   mHarm2.GetADSR()->Process(time, harmDepth2, bufferSize);
+   mModIdx.Process(time, modIdx, bufferSize);
+   mModIdx2.Process(time, modIdx2, bufferSize);
+   
+   for (int pos=0; pos<bufferSize; ++pos)
    {
       if (mOwner)
          mOwner->ComputeSliders(pos);
       
-      float oscFreq = TheScale->PitchToFreq(GetPitch(pos));
-      float harmFreq = oscFreq * mHarm.GetADSR()->Value(time) * mVoiceParams->mHarmRatio;
-      float harmFreq2 = harmFreq * mHarm2.GetADSR()->Value(time) * mVoiceParams->mHarmRatio2;
-      
-      float harmPhaseInc2 = GetPhaseInc(harmFreq2);
-      
-      mHarmPhase2 += harmPhaseInc2;
+      float harmEnv = harmDepth[pos];
+      float harmEnv2 = harmDepth2[pos];
+      oscFreq[pos] = TheScale->PitchToFreq(GetPitch(pos));
+      harmFreq[pos] = oscFreq[pos] * harmEnv * mVoiceParams->mHarmRatio;
+      harmFreq2[pos] = harmFreq[pos] * harmEnv2 * mVoiceParams->mHarmRatio2;
+      harmDepth[pos] = harmEnv * harmFreq[pos] * modIdx[pos] * mVoiceParams->mModIdx;
+      harmDepth2[pos] = harmEnv2 * harmFreq2[pos] * modIdx2[pos] * mVoiceParams->mModIdx2;
+      oscGain[pos] *= mVoiceParams->mVol/20.0f;
+      phaseOffset0[pos] = mVoiceParams->mPhaseOffset0;
+      phaseOffset1[pos] = mVoiceParams->mPhaseOffset1;
+      phaseOffset2[pos] = mVoiceParams->mPhaseOffset2;
+   }
+   
+   //second modulator, its output bends the first modulator's frequency
+   for (int pos=0; pos<bufferSize; ++pos)
+   {
+      mHarmPhase2 += GetPhaseInc(harmFreq2[pos]);
       while (mHarmPhase2 > FTWO_PI) { mHarmPhase2 -= FTWO_PI; }
-      
-      float modHarmFreq = harmFreq + mHarm2.Audio(time, mHarmPhase2 + mVoiceParams->mPhaseOffset2) * harmFreq2 * mModIdx2.Value(time) * mVoiceParams->mModIdx2;
-      
-      float harmPhaseInc = GetPhaseInc(modHarmFreq);
-      
-      mHarmPhase += harmPhaseInc;
+      phases[pos] = mHarmPhase2 + phaseOffset2[pos];
+   }
+   FastSinBlock(phases, sine, bufferSize);
+   
+   //first modulator, bending the carrier's frequency
+   for (int pos=0; pos<bufferSize; ++pos)
+   {
+      mHarmPhase += GetPhaseInc(harmFreq[pos] + sine[pos] * harmDepth2[pos]);
       while (mHarmPhase > FTWO_PI) { mHarmPhase -= FTWO_PI; }
-
-      float modOscFreq = oscFreq + mHarm.Audio(time, mHarmPhase + mVoiceParams->mPhaseOffset1) * harmFreq * mModIdx.Value(time) * mVoiceParams->mModIdx;
-      float oscPhaseInc = GetPhaseInc(modOscFreq);
-
-      mOscPhase += oscPhaseInc;
+      phases[pos] = mHarmPhase + phaseOffset1[pos];
+   }
+   FastSinBlock(phases, sine, bufferSize);
+   
+   //carrier
+   for (int pos=0; pos<bufferSize; ++pos)
+   {
+      mOscPhase += GetPhaseInc(oscFreq[pos] + sine[pos] * harmDepth[pos]);
       while (mOscPhase > FTWO_PI) { mOscPhase -= FTWO_PI; }
-
-      float sample = mOsc.Audio(time, mOscPhase + mVoiceParams->mPhaseOffset0) * mVoiceParams->mVol/20.0f;
-      if (out->NumActiveChannels() == 1)
-      {
-         out->GetChannel(0)[pos] += sample;
-      }
-      else
+      phases[pos] = mOscPhase + phaseOffset0[pos];
+   }
+   FastSinBlock(phases, sine, bufferSize);
+   Mult(sine, oscGain, bufferSize);
+   
+   if (out->NumActiveChannels() == 1)
+   {
+      Add(out->GetChannel(0), sine, bufferSize);
+   }
+   else
+   {
+      float leftGain = GetLeftPanGain(GetPan());
+      float rightGain = GetRightPanGain(GetPan());
+      for (int pos=0; pos<bufferSize; ++pos)
       {
-         out->GetChannel(0)[pos] += sample * GetLeftPanGain(GetPan());
-         out->GetChannel(1)[pos] += sample * GetRightPanGain(GetPan());
+         out->GetChannel(0)[pos] += sine[pos] * leftGain;
+         out->GetChannel(1)[pos] += sine[pos] * rightGain;
       }
-
-      time += gInvSampleRateMs;
    }
    
-   return true;
+   return running;
 }
 
 void FMVoice::Start(double time, float target)
@@ -49,6 +49,7 @@ public:
    bool Process(double time, ChannelBuffer* out) override;
    void SetVoiceParams(IVoiceParams* params) override;
    bool IsDone(double time) override;
+   float GetLevel(double time) override;
 private:
    float mOscPhase;
    EnvOscillator mOsc;
@@ -11,111 +11,224 @@
 #include "SynthGlobals.h"
 
 FileStreamOut::FileStreamOut(const char* file)
-: mStream(File(file))
+: mMemory(nullptr)
+, mBuffer(new char[kBufferSize])
+, mBufferUsed(0)
+, mBufferStart(0)
 {
-   mStream.setPosition(0);
-   mStream.truncate();
+   FileOutputStream* stream = new FileOutputStream(File(file));
+   stream->setPosition(0);
+   stream->truncate();
+   mStream = stream;
+}
+
+FileStreamOut::FileStreamOut()
+: mMemory(new MemoryOutputStream())
+, mBuffer(new char[kBufferSize])
+, mBufferUsed(0)
+, mBufferStart(0)
+{
+   mStream = mMemory;
 }
 
 FileStreamOut::~FileStreamOut()
 {
-   mStream.flush();
+   Flush();
+   delete[] mBuffer;
+}
+
+void FileStreamOut::Flush()
+{
+   WriteBuffer();
+   mStream->flush();
+}
+
+void FileStreamOut::WriteBuffer()
+{
+   //just hands it to the stream, Flush() is the one that goes all the way to disk
+   if (mBufferUsed > 0)
+   {
+      mStream->write(mBuffer, mBufferUsed);
+      mBufferStart += mBufferUsed;
+      mBufferUsed = 0;
+   }
+}
+
+void FileStreamOut::WriteLarge(const void* data, int size)
+{
+   WriteBuffer();
+   if (size >= kBufferSize)
+   {
+      mStream->write(data, size);
+      mBufferStart += size;
+   }
+   else
+   {
+      memcpy(mBuffer, data, size);
+      mBufferUsed = size;
+   }
+}
+
+void FileStreamOut::Patch(int64 position, const void* data, int size)
+{
+   assert(position >= 0 && position + size <= GetPosition());
+   if (position >= mBufferStart)   //still in the buffer, which is where it usually is
+   {
+      memcpy(mBuffer + (position - mBufferStart), data, size);
+      return;
+   }
+   
+   WriteBuffer();
+   mStream->setPosition(position);
+   mStream->write(data, size);
+   mStream->setPosition(mBufferStart);
+}
+
+const void* FileStreamOut::GetData()
+{
+   assert(mMemory != nullptr);
+   WriteBuffer();
+   return mMemory->getData();
+}
+
+size_t FileStreamOut::GetDataSize()
+{
+   assert(mMemory != nullptr);
+   WriteBuffer();
+   return mMemory->getDataSize();
+}
+
+bool FileStreamOut::WriteToFile(const char* file)
+{
+   return File(file).replaceWithData(GetData(), GetDataSize());
 }
 
 FileStreamIn::FileStreamIn(const char* file)
-: mStream(File(file))
+: mBuffer(new char[kBufferSize])
+, mBufferPos(0)
+, mBufferLength(0)
+, mBufferStart(0)
+{
+   FileInputStream* stream = new FileInputStream(File(file));
+   mOpenedOk = stream->openedOk();
+   mStream = stream;
+}
+
+FileStreamIn::FileStreamIn(const void* data, size_t size)
+: mStream(new MemoryInputStream(data, size, false))
+, mOpenedOk(true)
+, mBuffer(new char[kBufferSize])
+, mBufferPos(0)
+, mBufferLength(0)
+, mBufferStart(0)
+{
+}
+
+FileStreamIn::~FileStreamIn()
 {
+   delete[] mBuffer;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const int &var)
 {
-   mStream.write((const void*)&var, sizeof(int));
+   WriteBytes(&var, sizeof(int));
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const uint32_t &var)
 {
-   mStream.write((const void*)&var, sizeof(uint32_t));
+   WriteBytes(&var, sizeof(uint32_t));
+   return *this;
+}
+
+FileStreamOut& FileStreamOut::operator<<(const int64 &var)
+{
+   WriteBytes(&var, sizeof(int64));
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const bool &var)
 {
-   mStream.write((const void*)&var, sizeof(bool));
+   WriteBytes(&var, sizeof(bool));
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const float &var)
 {
-   mStream.write((const void*)&var, sizeof(float));
+   WriteBytes(&var, sizeof(float));
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const double &var)
 {
-   mStream.write((const void*)&var, sizeof(double));
+   WriteBytes(&var, sizeof(double));
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const string &var)
 {
    size_t len = var.length();
-   mStream.write((const void*)&len, sizeof(size_t));
-   for (int i=0; i<len; ++i)
-      mStream.write((const void*)&var[i], sizeof(char));
+   WriteBytes(&len, sizeof(size_t));
+   WriteBytes(var.data(), (int)len);
    return *this;
 }
 
 FileStreamOut& FileStreamOut::operator<<(const char &var)
 {
-   mStream.write(&var, sizeof(char));
+   WriteBytes(&var, sizeof(char));
    return *this;
 }
 
 void FileStreamOut::Write(const float* buffer, int size)
 {
-   mStream.write((const void*)buffer, sizeof(float)*size);
+   WriteBytes(buffer, sizeof(float)*size);
 }
 
 void FileStreamOut::WriteGeneric(const void* buffer, int size)
 {
-   mStream.write((const void*)buffer, size);
+   WriteBytes(buffer, size);
 }
 
 FileStreamIn& FileStreamIn::operator>>(int &var)
 {
-   mStream.read((void*)&var, sizeof(int));
+   ReadBytes(&var, sizeof(int));
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(uint32_t &var)
 {
-   mStream.read((void*)&var, sizeof(uint32_t));
+   ReadBytes(&var, sizeof(uint32_t));
+   return *this;
+}
+
+FileStreamIn& FileStreamIn::operator>>(int64 &var)
+{
+   ReadBytes(&var, sizeof(int64));
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(bool &var)
 {
-   mStream.read((void*)&var, sizeof(bool));
+   ReadBytes(&var, sizeof(bool));
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(float &var)
 {
-   mStream.read((void*)&var, sizeof(float));
+   ReadBytes(&var, sizeof(float));
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(double &var)
 {
-   mStream.read((void*)&var, sizeof(double));
+   ReadBytes(&var, sizeof(double));
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(string &var)
 {
    size_t len;
-   mStream.read((void*)&len, sizeof(size_t));
+   ReadBytes(&len, sizeof(size_t));
    
    if (TheSynth->IsLoadingModule())
       LoadStateValidate(len < 99999);   //probably garbage beyond this point
@@ -123,40 +236,84 @@ FileStreamIn& FileStreamIn::operator>>(string &var)
       assert(len < 99999);   //probably garbage beyond this point
    
    var.resize(len);
-   for (int i=0; i<len; ++i)
-      mStream.read((void*)&var[i], sizeof(char));
+   if (len > 0)
+      ReadBytes(&var[0], (int)len);
    return *this;
 }
 
 FileStreamIn& FileStreamIn::operator>>(char &var)
 {
-   mStream.read(&var, sizeof(char));
+   ReadBytes(&var, sizeof(char));
    return *this;
 }
 
 void FileStreamIn::Read(float* buffer, int size)
 {
-   mStream.read((void*)buffer, sizeof(float)*size);
+   ReadBytes(buffer, sizeof(float)*size);
 }
 
 void FileStreamIn::ReadGeneric(void* buffer, int size)
 {
-   mStream.read((void*)buffer, size);
+   ReadBytes(buffer, size);
+}
+
+void FileStreamIn::ReadLarge(void* data, int size)
+{
+   //whatever's left in the buffer, then either straight from the stream or through a refilled buffer
+   char* dest = (char*)data;
+   int buffered = mBufferLength - mBufferPos;
+   memcpy(dest, mBuffer + mBufferPos, buffered);
+   dest += buffered;
+   size -= buffered;
+   mBufferStart += mBufferLength;
+   mBufferPos = 0;
+   mBufferLength = 0;
+   
+   int read;
+   if (size >= kBufferSize)
+   {
+      read = MAX(0, mStream->read(dest, size));
+      mBufferStart += read;
+   }
+   else
+   {
+      mBufferLength = MAX(0, mStream->read(mBuffer, kBufferSize));
+      read = MIN(size, mBufferLength);
+      memcpy(dest, mBuffer, read);
+      mBufferPos = read;
+   }
+   
+   if (read < size)   //ran off the end
+      memset(dest + read, 0, size - read);
+}
+
+void FileStreamIn::Seek(int64 position)
+{
+   if (position >= mBufferStart && position <= mBufferStart + mBufferLength)
+   {
+      mBufferPos = int(position - mBufferStart);
+      return;
+   }
+   
+   mStream->setPosition(position);
+   mBufferStart = position;
+   mBufferPos = 0;
+   mBufferLength = 0;
 }
                         
 void FileStreamIn::Peek(void* buffer, int size)
 {
-   auto pos = mStream.getPosition();
-   mStream.read((void*)buffer, size);
-   mStream.setPosition(pos);
+   int64 pos = GetPosition();
+   ReadBytes(buffer, size);
+   Seek(pos);
 }
 
 bool FileStreamIn::Eof()
 {
-   return mStream.isExhausted();
+   return mBufferPos == mBufferLength && mStream->isExhausted();
 }
 
 int FileStreamIn::GetFilePosition()
 {
-   return (int)mStream.getPosition();
+   return (int)GetPosition();
 }
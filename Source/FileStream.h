@@ -12,13 +12,17 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "OpenFrameworksPort.h"
 
+//small values go through a buffer, so saving state isn't one write call per int.
+//anything as big as the buffer, like a ChannelBuffer's audio, goes straight through in one call
 class FileStreamOut
 {
 public:
    FileStreamOut(const char* file);
+   FileStreamOut();   //writes to memory, see GetData() and WriteToFile()
    ~FileStreamOut();
    FileStreamOut& operator<<(const int& var);
    FileStreamOut& operator<<(const uint32_t &var);
+   FileStreamOut& operator<<(const int64& var);
    FileStreamOut& operator<<(const bool& var);
    FileStreamOut& operator<<(const float& var);
    FileStreamOut& operator<<(const double& var);
@@ -26,16 +30,49 @@ public:
    FileStreamOut& operator<<(const char& var);
    void Write(const float* buffer, int size);
    void WriteGeneric(const void* buffer, int size);
+   int64 GetPosition() const { return mBufferStart + mBufferUsed; }
+   //overwrites size bytes already written at position, for filling in an offset that wasn't known when it was written
+   void Patch(int64 position, const void* data, int size);
+   void Flush();
+
+   //for memory streams
+   const void* GetData();
+   size_t GetDataSize();
+   bool WriteToFile(const char* file);
+
+   static const int kBufferSize = 64 * 1024;
 private:
-   FileOutputStream mStream;
+   void WriteBytes(const void* data, int size)
+   {
+      if (mBufferUsed + size <= kBufferSize)
+      {
+         memcpy(mBuffer + mBufferUsed, data, size);
+         mBufferUsed += size;
+      }
+      else
+      {
+         WriteLarge(data, size);
+      }
+   }
+   void WriteLarge(const void* data, int size);
+   void WriteBuffer();
+
+   ScopedPointer<OutputStream> mStream;
+   MemoryOutputStream* mMemory;   //mStream, if we're writing to memory
+   char* mBuffer;
+   int mBufferUsed;
+   int64 mBufferStart;   //where in the stream the buffer gets written
 };
 
 class FileStreamIn
 {
 public:
    FileStreamIn(const char* file);
+   FileStreamIn(const void* data, size_t size);   //reads from memory, which has to outlive the stream
+   ~FileStreamIn();
    FileStreamIn& operator>>(int& var);
    FileStreamIn& operator>>(uint32_t &var);
+   FileStreamIn& operator>>(int64& var);
    FileStreamIn& operator>>(bool& var);
    FileStreamIn& operator>>(float& var);
    FileStreamIn& operator>>(double& var);
@@ -45,11 +82,34 @@ public:
    void ReadGeneric(void* buffer, int size);
    void Peek(void* buffer, int size);
    int GetFilePosition();
-   bool OpenedOk() { return mStream.openedOk(); }
-   
+   int64 GetPosition() const { return mBufferStart + mBufferPos; }
+   void Seek(int64 position);
+   bool OpenedOk() { return mOpenedOk; }
+
    bool Eof();
+
+   static const int kBufferSize = 64 * 1024;
 private:
-   FileInputStream mStream;
+   void ReadBytes(void* data, int size)
+   {
+      if (mBufferPos + size <= mBufferLength)
+      {
+         memcpy(data, mBuffer + mBufferPos, size);
+         mBufferPos += size;
+      }
+      else
+      {
+         ReadLarge(data, size);
+      }
+   }
+   void ReadLarge(void* data, int size);
+
+   ScopedPointer<InputStream> mStream;
+   bool mOpenedOk;
+   char* mBuffer;
+   int mBufferPos;
+   int mBufferLength;
+   int64 mBufferStart;   //where in the stream the buffer was read from
 };
 
 #endif /* defined(__Bespoke__FileStream__) */
@@ -0,0 +1,235 @@
+/*
+  ==============================================================================
+
+    Float4.h
+    Created: 17 Oct 2026 4:12:40pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//four floats processed together. SSE2 on x86, NEON on ARM, plain floats anywhere else,
+//so code written against this builds everywhere and just runs slower without SIMD.
+//we stick to 128-bit lanes: wider AVX paths would need per-file compile flags in every exporter.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BESPOKE_SIMD_SSE 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BESPOKE_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+//ieee 754 half to float. every step stays in normal floats, so this holds up with denormals flushed to zero.
+//the scalar version of Float4::LoadHalf()
+inline float HalfToFloat(uint16_t half)
+{
+   uint32_t expMant = half & 0x7fff;
+   uint32_t bits = (expMant << 13) + ((127 - 15) << 23);
+   float f;
+   if (expMant > 0x7bff)   //inf or nan
+   {
+      bits += (128 - 16) << 23;
+   }
+   else if ((expMant & 0x7c00) == 0)   //zero or denormal: add the implicit one, then take it back off as a float
+   {
+      bits += 1 << 23;
+      memcpy(&f, &bits, 4);
+      f -= 6.103515625e-05f;
+      memcpy(&bits, &f, 4);
+   }
+   bits |= uint32_t(half & 0x8000) << 16;
+   memcpy(&f, &bits, 4);
+   return f;
+}
+
+struct Float4
+{
+#if BESPOKE_SIMD_SSE
+   __m128 v;
+
+   static Float4 Make(__m128 x) { Float4 r; r.v = x; return r; }
+   static Float4 Load(const float* p) { return Make(_mm_loadu_ps(p)); }
+   static Float4 Set(float x) { return Make(_mm_set1_ps(x)); }
+   static Float4 Set(float a, float b, float c, float d) { return Make(_mm_setr_ps(a, b, c, d)); }
+   static Float4 Zero() { return Make(_mm_setzero_ps()); }
+   void Store(float* p) const { _mm_storeu_ps(p, v); }
+   //four int16s, widened as they are (not scaled)
+   static Float4 LoadInt16(const int16_t* p)
+   {
+      __m128i x = _mm_loadl_epi64((const __m128i*)p);
+      return Make(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16)));
+   }
+   //four ieee halfs, see HalfToFloat()
+   static Float4 LoadHalf(const uint16_t* p)
+   {
+      __m128i half = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)p), _mm_setzero_si128());
+      __m128i expMant = _mm_and_si128(half, _mm_set1_epi32(0x7fff));
+      __m128i sign = _mm_slli_epi32(_mm_xor_si128(half, expMant), 16);
+      __m128i bits = _mm_add_epi32(_mm_slli_epi32(expMant, 13), _mm_set1_epi32((127 - 15) << 23));
+      bits = _mm_add_epi32(bits, _mm_and_si128(_mm_cmpgt_epi32(expMant, _mm_set1_epi32(0x7bff)), _mm_set1_epi32((128 - 16) << 23)));
+      __m128i denormal = _mm_castps_si128(_mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))), _mm_set1_ps(6.103515625e-05f)));
+      __m128i isDenormal = _mm_cmpeq_epi32(_mm_and_si128(expMant, _mm_set1_epi32(0x7c00)), _mm_setzero_si128());
+      bits = _mm_or_si128(_mm_and_si128(isDenormal, denormal), _mm_andnot_si128(isDenormal, bits));
+      return Make(_mm_castsi128_ps(_mm_or_si128(bits, sign)));
+   }
+
+   Float4 operator+(Float4 o) const { return Make(_mm_add_ps(v, o.v)); }
+   Float4 operator-(Float4 o) const { return Make(_mm_sub_ps(v, o.v)); }
+   Float4 operator*(Float4 o) const { return Make(_mm_mul_ps(v, o.v)); }
+   Float4 operator/(Float4 o) const { return Make(_mm_div_ps(v, o.v)); }
+   Float4 operator-() const { return Make(_mm_xor_ps(v, _mm_set1_ps(-0.0f))); }
+
+   static Float4 Min(Float4 a, Float4 b) { return Make(_mm_min_ps(a.v, b.v)); }
+   static Float4 Max(Float4 a, Float4 b) { return Make(_mm_max_ps(a.v, b.v)); }
+   static Float4 Abs(Float4 a) { return Make(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+   //no SSE4.1 round, so truncate and step down for negatives. fine for |x| < 2^31
+   static Float4 Floor(Float4 a)
+   {
+      __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+      return Make(_mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1))));
+   }
+
+   //all bits set in lanes where the comparison holds
+   static Float4 GreaterThan(Float4 a, Float4 b) { return Make(_mm_cmpgt_ps(a.v, b.v)); }
+   static Float4 LessThan(Float4 a, Float4 b) { return Make(_mm_cmplt_ps(a.v, b.v)); }
+   //mask ? a : b, per lane
+   static Float4 Select(Float4 mask, Float4 a, Float4 b) { return Make(_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))); }
+
+   //{a, a+b, a+b+c, a+b+c+d}
+   Float4 PrefixSum() const
+   {
+      __m128 x = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+      return Make(_mm_add_ps(x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), 8))));
+   }
+   float Last() const { return _mm_cvtss_f32(_mm_shuffle_ps(v, v, _MM_SHUFFLE(3,3,3,3))); }
+   float Sum() const
+   {
+      __m128 x = _mm_add_ps(v, _mm_movehl_ps(v, v));
+      return _mm_cvtss_f32(_mm_add_ss(x, _mm_shuffle_ps(x, x, _MM_SHUFFLE(1,1,1,1))));
+   }
+#elif BESPOKE_SIMD_NEON
+   float32x4_t v;
+
+   static Float4 Make(float32x4_t x) { Float4 r; r.v = x; return r; }
+   static Float4 Load(const float* p) { return Make(vld1q_f32(p)); }
+   static Float4 Set(float x) { return Make(vdupq_n_f32(x)); }
+   static Float4 Set(float a, float b, float c, float d) { float f[4] = { a, b, c, d }; return Load(f); }
+   static Float4 Zero() { return Set(0); }
+   void Store(float* p) const { vst1q_f32(p, v); }
+   static Float4 LoadInt16(const int16_t* p) { return Make(vcvtq_f32_s32(vmovl_s16(vld1_s16(p)))); }
+   //not vcvt_f32_f16, armv7 only has that with the fp16 extension
+   static Float4 LoadHalf(const uint16_t* p)
+   {
+      uint32x4_t half = vmovl_u16(vld1_u16(p));
+      uint32x4_t expMant = vandq_u32(half, vdupq_n_u32(0x7fff));
+      uint32x4_t sign = vshlq_n_u32(veorq_u32(half, expMant), 16);
+      uint32x4_t bits = vaddq_u32(vshlq_n_u32(expMant, 13), vdupq_n_u32((127 - 15) << 23));
+      bits = vaddq_u32(bits, vandq_u32(vcgtq_u32(expMant, vdupq_n_u32(0x7bff)), vdupq_n_u32((128 - 16) << 23)));
+      float32x4_t denormal = vsubq_f32(vreinterpretq_f32_u32(vaddq_u32(bits, vdupq_n_u32(1 << 23))), vdupq_n_f32(6.103515625e-05f));
+      uint32x4_t isDenormal = vceqq_u32(vandq_u32(expMant, vdupq_n_u32(0x7c00)), vdupq_n_u32(0));
+      bits = vbslq_u32(isDenormal, vreinterpretq_u32_f32(denormal), bits);
+      return Make(vreinterpretq_f32_u32(vorrq_u32(bits, sign)));
+   }
+
+   Float4 operator+(Float4 o) const { return Make(vaddq_f32(v, o.v)); }
+   Float4 operator-(Float4 o) const { return Make(vsubq_f32(v, o.v)); }
+   Float4 operator*(Float4 o) const { return Make(vmulq_f32(v, o.v)); }
+#if defined(__aarch64__)
+   Float4 operator/(Float4 o) const { return Make(vdivq_f32(v, o.v)); }
+#else
+   Float4 operator/(Float4 o) const
+   {
+      //armv7 has no divide, refine the reciprocal estimate twice
+      float32x4_t recip = vrecpeq_f32(o.v);
+      recip = vmulq_f32(vrecpsq_f32(o.v, recip), recip);
+      recip = vmulq_f32(vrecpsq_f32(o.v, recip), recip);
+      return Make(vmulq_f32(v, recip));
+   }
+#endif
+   Float4 operator-() const { return Make(vnegq_f32(v)); }
+
+   static Float4 Min(Float4 a, Float4 b) { return Make(vminq_f32(a.v, b.v)); }
+   static Float4 Max(Float4 a, Float4 b) { return Make(vmaxq_f32(a.v, b.v)); }
+   static Float4 Abs(Float4 a) { return Make(vabsq_f32(a.v)); }
+   static Float4 Floor(Float4 a)
+   {
+      float32x4_t truncated = vcvtq_f32_s32(vcvtq_s32_f32(a.v));
+      uint32x4_t tooBig = vcgtq_f32(truncated, a.v);
+      return Make(vsubq_f32(truncated, vreinterpretq_f32_u32(vandq_u32(tooBig, vreinterpretq_u32_f32(vdupq_n_f32(1))))));
+   }
+
+   static Float4 GreaterThan(Float4 a, Float4 b) { return Make(vreinterpretq_f32_u32(vcgtq_f32(a.v, b.v))); }
+   static Float4 LessThan(Float4 a, Float4 b) { return Make(vreinterpretq_f32_u32(vcltq_f32(a.v, b.v))); }
+   static Float4 Select(Float4 mask, Float4 a, Float4 b) { return Make(vbslq_f32(vreinterpretq_u32_f32(mask.v), a.v, b.v)); }
+
+   Float4 PrefixSum() const
+   {
+      float32x4_t zero = vdupq_n_f32(0);
+      float32x4_t x = vaddq_f32(v, vextq_f32(zero, v, 3));
+      return Make(vaddq_f32(x, vextq_f32(zero, x, 2)));
+   }
+   float Last() const { return vgetq_lane_f32(v, 3); }
+   float Sum() const
+   {
+      float32x2_t x = vadd_f32(vget_low_f32(v), vget_high_f32(v));
+      return vget_lane_f32(vpadd_f32(x, x), 0);
+   }
+#else
+   float v[4];
+
+   static Float4 Load(const float* p) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = p[i]; return r; }
+   static Float4 Set(float x) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = x; return r; }
+   static Float4 Set(float a, float b, float c, float d) { Float4 r; r.v[0] = a; r.v[1] = b; r.v[2] = c; r.v[3] = d; return r; }
+   static Float4 Zero() { return Set(0); }
+   void Store(float* p) const { for (int i=0; i<4; ++i) p[i] = v[i]; }
+   static Float4 LoadInt16(const int16_t* p) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = p[i]; return r; }
+   static Float4 LoadHalf(const uint16_t* p) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = HalfToFloat(p[i]); return r; }
+
+   Float4 operator+(Float4 o) const { Float4 r; for (int i=0; i<4; ++i) r.v[i] = v[i] + o.v[i]; return r; }
+   Float4 operator-(Float4 o) const { Float4 r; for (int i=0; i<4; ++i) r.v[i] = v[i] - o.v[i]; return r; }
+   Float4 operator*(Float4 o) const { Float4 r; for (int i=0; i<4; ++i) r.v[i] = v[i] * o.v[i]; return r; }
+   Float4 operator/(Float4 o) const { Float4 r; for (int i=0; i<4; ++i) r.v[i] = v[i] / o.v[i]; return r; }
+   Float4 operator-() const { Float4 r; for (int i=0; i<4; ++i) r.v[i] = -v[i]; return r; }
+
+   static Float4 Min(Float4 a, Float4 b) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = a.v[i] < b.v[i] ? a.v[i] : b.v[i]; return r; }
+   static Float4 Max(Float4 a, Float4 b) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = a.v[i] > b.v[i] ? a.v[i] : b.v[i]; return r; }
+   static Float4 Abs(Float4 a) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = fabsf(a.v[i]); return r; }
+   static Float4 Floor(Float4 a) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = floorf(a.v[i]); return r; }
+
+   //masks are stored as 1 or 0 here, Select() only looks at whether a lane is set
+   static Float4 GreaterThan(Float4 a, Float4 b) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = a.v[i] > b.v[i] ? 1 : 0; return r; }
+   static Float4 LessThan(Float4 a, Float4 b) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = a.v[i] < b.v[i] ? 1 : 0; return r; }
+   static Float4 Select(Float4 mask, Float4 a, Float4 b) { Float4 r; for (int i=0; i<4; ++i) r.v[i] = mask.v[i] != 0 ? a.v[i] : b.v[i]; return r; }
+
+   Float4 PrefixSum() const { Float4 r = *this; for (int i=1; i<4; ++i) r.v[i] += r.v[i-1]; return r; }
+   float Last() const { return v[3]; }
+   float Sum() const { return v[0] + v[1] + v[2] + v[3]; }
+#endif
+
+   Float4& operator+=(Float4 o) { *this = *this + o; return *this; }
+   Float4& operator*=(Float4 o) { *this = *this * o; return *this; }
+
+   static Float4 Clamp(Float4 a, Float4 low, Float4 high) { return Min(Max(a, low), high); }
+
+   //sin for x in [-pi, pi]. folds into [-pi/2, pi/2] and runs an odd polynomial, good to a few parts per million
+   static Float4 Sin(Float4 x)
+   {
+      const Float4 halfPi = Set(1.57079632679489661923f);
+      const Float4 pi = Set(3.14159265358979323846f);
+      x = Select(GreaterThan(x, halfPi), pi - x, x);
+      x = Select(LessThan(x, -halfPi), -pi - x, x);
+      Float4 x2 = x * x;
+      Float4 poly = Set(2.7557319e-6f);
+      poly = poly * x2 + Set(-1.98412698e-4f);
+      poly = poly * x2 + Set(8.33333333e-3f);
+      poly = poly * x2 + Set(-1.66666667e-1f);
+      poly = poly * x2 + Set(1);
+      return poly * x;
+   }
+};
@@ -12,6 +12,7 @@
 #include "Profiler.h"
 #include "Transport.h"
 #include "Scale.h"
+#include "ScratchArena.h"
 
 FollowingSong::FollowingSong()
 : mVolume(1)
@@ -68,12 +69,14 @@ void FollowingSong::Process(double time)
    {
       mLoadSongMutex.lock();
       
-      gWorkChannelBuffer.SetNumActiveChannels(1);
-      if (mSample.ConsumeData(time, &gWorkChannelBuffer, bufferSize, true))
+      ScratchArena::Scope scratch;
+      ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+      workBuffer->SetNumActiveChannels(1);
+      if (mSample.ConsumeData(time, workBuffer, bufferSize, true))
       {
          for (int i=0; i<bufferSize; ++i)
          {
-            float sample = gWorkChannelBuffer.GetChannel(0)[i] * volSq;
+            float sample = workBuffer->GetChannel(0)[i] * volSq;
             if (mMute)
                sample = 0;
             out[i] += sample;
@@ -17,8 +17,8 @@ namespace
 
 FreqDomainBoilerplate::FreqDomainBoilerplate()
 : IAudioProcessor(gBufferSize)
+, mAnalyzer(fftWindowSize, STFTAnalyzer::kOverlapPerBlock)
 , mFFT(fftWindowSize)
-, mRollingInputBuffer(fftWindowSize)
 , mRollingOutputBuffer(fftWindowSize)
 , mFFTData(fftWindowSize, fftFreqDomainSize)
 , mInputPreamp(1)
@@ -36,10 +36,6 @@ FreqDomainBoilerplate::FreqDomainBoilerplate()
 , mPhaseOffset(0)
 , mPhaseOffsetSlider(nullptr)
 {
-   // Generate a window with a single raised cosine from N/4 to 3N/4
-   mWindower = new float[fftWindowSize];
-   for (int i=0; i<fftWindowSize; ++i)
-      mWindower[i] = -.5*cos(FTWO_PI*i/fftWindowSize)+.5;
 }
 
 void FreqDomainBoilerplate::CreateUIControls()
@@ -56,7 +52,6 @@ void FreqDomainBoilerplate::CreateUIControls()
 
 FreqDomainBoilerplate::~FreqDomainBoilerplate()
 {
-   delete[] mWindower;
 }
 
 void FreqDomainBoilerplate::Process(double time)
@@ -74,21 +69,13 @@ void FreqDomainBoilerplate::Process(double time)
 
    int bufferSize = GetBuffer()->BufferSize();
 
-   mRollingInputBuffer.WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
-
-   //copy rolling input buffer into working buffer and window it
-   mRollingInputBuffer.ReadChunk(mFFTData.mTimeDomain, fftWindowSize, 0, 0);
-   Mult(mFFTData.mTimeDomain, mWindower, fftWindowSize);
-   Mult(mFFTData.mTimeDomain, inputPreampSq, fftWindowSize);
-
-   mFFT.Forward(mFFTData.mTimeDomain,
-                mFFTData.mRealValues,
-                mFFTData.mImaginaryValues);
+   mAnalyzer.Write(GetBuffer()->GetChannel(0), bufferSize);
+   const STFTFrame& frame = mAnalyzer.GetFrame();
 
    for (int i=0; i<fftFreqDomainSize; ++i)
    {
-      float real = mFFTData.mRealValues[i];
-      float imag = mFFTData.mImaginaryValues[i];
+      float real = frame.mRealValues[i] * inputPreampSq;
+      float imag = frame.mImaginaryValues[i] * inputPreampSq;
 
       //cartesian to polar
       float amp = 2.*sqrtf(real*real + imag*imag);
@@ -114,7 +101,7 @@ void FreqDomainBoilerplate::Process(double time)
 
    //copy rolling input buffer into working buffer and window it
    for (int i=0; i<fftWindowSize; ++i)
-      mRollingOutputBuffer.Accum(fftWindowSize-i-1, mFFTData.mTimeDomain[i] * mWindower[i] * .0001f, 0);
+      mRollingOutputBuffer.Accum(fftWindowSize-i-1, mFFTData.mTimeDomain[i] * mAnalyzer.GetWindow()[i] * .0001f, 0);
 
    Mult(GetBuffer()->GetChannel(0), (1-mDryWet)*inputPreampSq, GetBuffer()->BufferSize());
 
@@ -15,6 +15,7 @@
 #include "Checkbox.h"
 #include "FFT.h"
 #include "RollingBuffer.h"
+#include "STFTAnalyzer.h"
 #include "Slider.h"
 #include "GateEffect.h"
 #include "BiquadFilterEffect.h"
@@ -50,11 +51,9 @@ private:
    bool Enabled() const override { return mEnabled; }
 
    FFTData mFFTData;
-   
-   float* mWindower;
 
+   STFTAnalyzer mAnalyzer;
    ::FFT mFFT;
-   RollingBuffer mRollingInputBuffer;
    RollingBuffer mRollingOutputBuffer;
 
    float mInputPreamp;
@@ -10,14 +10,41 @@
 #include "SynthGlobals.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "ScratchArena.h"
+#include "Float4.h"
+
+namespace
+{
+   const int kWindowTableSize = 1024;
+   
+   //hann window, with one extra entry so lookups can interpolate off the end
+   struct WindowTable
+   {
+      WindowTable()
+      {
+         for (int i=0; i<=kWindowTableSize; ++i)
+            mValues[i] = .5f * (1 - cos(i * TWO_PI / kWindowTableSize));
+      }
+      float mValues[kWindowTableSize+1];
+   };
+   
+   const float* GetWindowTable()
+   {
+      static WindowTable sTable;
+      return sTable.mValues;
+   }
+}
 
 Granulator::Granulator()
 : mNextGrainIdx(0)
 , mLastGrainSpawnMs(0)
+, mSpacingJitter(1)
+, mNumActiveGrains(0)
 , mLiveMode(false)
 , mOctaves(false)
 {
    Reset();
+   GetWindowTable();
 }
 
 void Granulator::Reset()
@@ -31,24 +58,48 @@ void Granulator::Reset()
    mOctaves = false;
 }
 
-void Granulator::Process(double time, ChannelBuffer* buffer, int bufferLength, double offset, float* output)
+void Granulator::Process(double time, const ChannelBuffer* buffer, int bufferLength, const double* offsets, ChannelBuffer* output, int numSamples)
 {
-   if (time >= mLastGrainSpawnMs+mGrainLengthMs*1/mGrainOverlap*ofRandom(1-mSpacingRandomize/2,1+mSpacingRandomize/2))
+   bool stereo = buffer->NumActiveChannels() == 2;
+   double spacingMs = mGrainLengthMs / mGrainOverlap;
+   double sampleTime = time;
+   for (int i=0; i<numSamples; ++i)
    {
-      mLastGrainSpawnMs = time;
-      SpawnGrain(time, offset, buffer->NumActiveChannels() == 2);
+      if (sampleTime >= mLastGrainSpawnMs + spacingMs * mSpacingJitter)
+      {
+         mLastGrainSpawnMs = sampleTime;
+         mSpacingJitter = ofRandom(1-mSpacingRandomize/2,1+mSpacingRandomize/2);
+         SpawnGrain(sampleTime, offsets[i], stereo);
+      }
+      sampleTime += gInvSampleRateMs;
    }
    
-   for (int i=0; i<MAX_GRAINS; ++i)
-      mGrains[i].Process(time, buffer, bufferLength, output);
-   
-   if (mGrainOverlap > 4)
+   float gain = GetDensityGain();
+   for (int i=0; i<mNumActiveGrains; )
    {
-      for (int ch=0; ch<buffer->NumActiveChannels(); ++ch)
-         output[ch] *= ofMap(mGrainOverlap,MAX_GRAINS,4,.5f,1);   //lower volume on dense granulation, starting at 4 overlap
+      Grain& grain = mGrains[mActiveGrains[i]];
+      if (grain.Process(time, buffer, bufferLength, output, numSamples, gain))
+      {
+         ++i;
+      }
+      else
+      {
+         grain.Clear();
+         mActiveGrains[i] = mActiveGrains[--mNumActiveGrains];
+      }
    }
 }
 
+float Granulator::GetDensityGain() const
+{
+   //lower volume on dense granulation, starting at 4 overlap
+   if (mGrainOverlap <= 4)
+      return 1;
+   if (mGrainOverlap <= 32)
+      return ofMap(mGrainOverlap,32,4,.5f,1);
+   return .5f * sqrtf(32 / mGrainOverlap);   //past that, uncorrelated grains add up as the square root
+}
+
 void Granulator::SpawnGrain(double time, double offset, bool stereo)
 {
    if (mLiveMode)
@@ -77,6 +128,8 @@ void Granulator::SpawnGrain(double time, double offset, bool stereo)
       }
    }
    offset += ofRandom(-mPosRandomizeMs, mPosRandomizeMs) / gInvSampleRateMs;
+   if (!mGrains[mNextGrainIdx].IsActive())
+      mActiveGrains[mNumActiveGrains++] = mNextGrainIdx;
    mGrains[mNextGrainIdx].Spawn(time, offset, speed, mGrainLengthMs, vol, stereo);
    
    mNextGrainIdx = (mNextGrainIdx+1) % MAX_GRAINS;
@@ -92,6 +145,13 @@ void Granulator::ClearGrains()
 {
    for (int i=0; i<MAX_GRAINS; ++i)
       mGrains[i].Clear();
+   mNumActiveGrains = 0;
+}
+
+void Granulator::ShiftGrains(double amount)
+{
+   for (int i=0; i<mNumActiveGrains; ++i)
+      mGrains[mActiveGrains[i]].Shift(amount);
 }
 
 void Grain::Spawn(double time, double pos, float speed, float lengthInMs, float vol, bool stereo)
@@ -105,19 +165,115 @@ void Grain::Spawn(double time, double pos, float speed, float lengthInMs, float
    mDrawPos = ofRandom(1);
 }
 
-void Grain::Process(double time, ChannelBuffer* buffer, int bufferLength, float* output)
+//renders the part of this grain that falls in the block. returns false once the grain is over
+bool Grain::Process(double time, const ChannelBuffer* buffer, int bufferLength, ChannelBuffer* output, int numSamples, float gain)
 {
-   if (time >= mStartTime && time <= mEndTime && mVol != 0)
+   double blockEndTime = time + (numSamples - 1) * gInvSampleRateMs;
+   if (mStartTime > blockEndTime)
+      return true;
+   
+   int start = MAX(0, (int)ceil((mStartTime - time) / gInvSampleRateMs));
+   int end = MIN(numSamples, (int)floor((mEndTime - time) / gInvSampleRateMs) + 1);
+   int length = end - start;
+   if (length > 0)
    {
-      float sample = GetInterpolatedSample(mPos, buffer, bufferLength, mStereoPosition);
-      mPos += mSpeed;
-      float window = GetWindow(time);
-      for (int ch=0; ch<buffer->NumActiveChannels(); ++ch)
-         output[ch] += sample * window * mVol * (ch == 0 ? (1-mStereoPosition) : mStereoPosition);
+      ScratchArena::Scope scratch;
+      float* posWhole = scratch.GetBuffer();
+      float* posFrac = scratch.GetBuffer();
+      float* windowWhole = scratch.GetBuffer();
+      float* windowFrac = scratch.GetBuffer();
+      float* left0 = scratch.GetBuffer();
+      float* left1 = scratch.GetBuffer();
+      float* right0 = scratch.GetBuffer();
+      float* right1 = scratch.GetBuffer();
+      float* window0 = scratch.GetBuffer();
+      float* window1 = scratch.GetBuffer();
+      
+      FloatWrap(mPos, bufferLength);
+      double posBase = floor(mPos);
+      float posStart = mPos - posBase;
+      double grainLengthMs = mEndTime - mStartTime;
+      float windowStart = (time + start * gInvSampleRateMs - mStartTime) / grainLengthMs * kWindowTableSize;
+      float windowStep = gInvSampleRateMs / grainLengthMs * kWindowTableSize;
+      int paddedLength = (length + 3) & ~3;
+      
+      //read position and window phase are straight lines across the span
+      const Float4 laneOffsets = Float4::Set(0, 1, 2, 3);
+      for (int i=0; i<paddedLength; i+=4)
+      {
+         Float4 steps = Float4::Set(i) + laneOffsets;
+         Float4 pos = Float4::Set(posStart) + steps * Float4::Set(mSpeed);
+         Float4 whole = Float4::Floor(pos);
+         whole.Store(posWhole + i);
+         (pos - whole).Store(posFrac + i);
+         
+         Float4 windowPos = Float4::Clamp(Float4::Set(windowStart) + steps * Float4::Set(windowStep), Float4::Zero(), Float4::Set(kWindowTableSize - 1));
+         whole = Float4::Floor(windowPos);
+         whole.Store(windowWhole + i);
+         (windowPos - whole).Store(windowFrac + i);
+      }
+      
+      //gather the neighbors for every sample, wrapping around the source buffer
+      const float* window = GetWindowTable();
+      int numChannels = buffer->NumActiveChannels();
+      bool stereo = numChannels > 1;
+      const float* left = buffer->GetChannel(0);
+      const float* right = stereo ? buffer->GetChannel(1) : left;
+      for (int i=0; i<length; ++i)
+      {
+         int idx = (int)posBase + (int)posWhole[i];
+         while (idx >= bufferLength)
+            idx -= bufferLength;
+         while (idx < 0)
+            idx += bufferLength;
+         int next = (idx + 1 == bufferLength) ? 0 : idx + 1;
+         left0[i] = left[idx];
+         left1[i] = left[next];
+         right0[i] = right[idx];
+         right1[i] = right[next];
+         
+         int w = (int)windowWhole[i];
+         window0[i] = window[w];
+         window1[i] = window[w+1];
+      }
+      for (int i=length; i<paddedLength; ++i)
+      {
+         left0[i] = left1[i] = right0[i] = right1[i] = 0;
+         window0[i] = window1[i] = 0;
+      }
+      
+      //then interpolate, blend the source channels and window four at a time. reuses posWhole for the result
+      float* samples = posWhole;
+      float stereoPos = stereo ? mStereoPosition : 0;
+      const Float4 blend = Float4::Set(stereoPos);
+      const Float4 one = Float4::Set(1);
+      const Float4 vol = Float4::Set(mVol * gain);
+      for (int i=0; i<paddedLength; i+=4)
+      {
+         Float4 a = Float4::Load(posFrac + i);
+         Float4 l0 = Float4::Load(left0 + i);
+         Float4 r0 = Float4::Load(right0 + i);
+         Float4 sample = (l0 + a * (Float4::Load(left1 + i) - l0)) * (one - blend) + (r0 + a * (Float4::Load(right1 + i) - r0)) * blend;
+         Float4 w0 = Float4::Load(window0 + i);
+         Float4 w = w0 + Float4::Load(windowFrac + i) * (Float4::Load(window1 + i) - w0);
+         (sample * w * vol).Store(samples + i);
+      }
+      
+      for (int ch=0; ch<numChannels; ++ch)
+      {
+         float pan = (ch == 0) ? (1-stereoPos) : stereoPos;
+         float* out = output->GetChannel(ch) + start;
+         for (int i=0; i<length; ++i)
+            out[i] += samples[i] * pan;
+      }
+      
+      mPos += length * mSpeed;
    }
+   
+   return mEndTime > blockEndTime;
 }
 
-double Grain::GetWindow(double time)
+double Grain::GetWindow(double time) const
 {
    if (time > mStartTime && time < mEndTime)
    {
@@ -129,6 +285,8 @@ double Grain::GetWindow(double time)
 
 void Grain::DrawGrain(int idx, float x, float y, float w, float h, int bufferStart, int bufferLength, bool wrapAround)
 {
+   if (!IsActive())
+      return;
    float a = (mPos - bufferStart) / bufferLength;
    if (wrapAround)
       FloatWrap(a,1);
@@ -138,6 +296,6 @@ void Grain::DrawGrain(int idx, float x, float y, float w, float h, int bufferSta
    ofFill();
    float alpha = GetWindow(gTime);
    ofSetColor(255,0,0,alpha*alpha*255*.5);
-   ofRect(x+a*w, y+mDrawPos*h, MAX(1,w/100), h/MAX_GRAINS);
+   ofRect(x+a*w, y+mDrawPos*h, MAX(1,w/100), MAX(1,h/32));
    ofPopStyle();
 }
@@ -12,7 +12,8 @@
 #include <iostream>
 #include "Ramp.h"
 
-#define MAX_GRAINS 32
+#define MAX_GRAINS 512
+#define MAX_GRAIN_OVERLAP 256
 
 class ChannelBuffer;
 
@@ -21,11 +22,13 @@ class Grain
 public:
    Grain() : mPos(0), mSpeed(0), mStartTime(0), mEndTime(0), mVol(0), mStereoPosition(0) {}
    void Spawn(double time, double pos, float speed, float lengthInMs, float vol, bool stereo);
-   void Process(double time, ChannelBuffer* buffer, int bufferLength, float* output);
+   bool Process(double time, const ChannelBuffer* buffer, int bufferLength, ChannelBuffer* output, int numSamples, float gain);
    void DrawGrain(int idx, float x, float y, float w, float h, int bufferStart, int bufferLength, bool wrapAround);
    void Clear() { mVol = 0; }
+   void Shift(double amount) { mPos += amount; }
+   bool IsActive() const { return mVol != 0; }
 private:
-   double GetWindow(double time);
+   double GetWindow(double time) const;
    double mPos;
    float mSpeed;
    double mStartTime;
@@ -39,10 +42,14 @@ class Granulator
 {
 public:
    Granulator();
-   void Process(double time, ChannelBuffer* buffer, int bufferLength, double offset, float* output);
+   //renders numSamples into output (added, one channel per source channel). offsets has the play position for every sample.
+   //grain parameters are read once per call
+   void Process(double time, const ChannelBuffer* buffer, int bufferLength, const double* offsets, ChannelBuffer* output, int numSamples);
    void Draw(float x, float y, float w, float h, int bufferStart, int bufferLength, bool wrapAround = true);
    void Reset();
    void ClearGrains();
+   //moves live grains by amount samples, for when the buffer they read from is re-based
+   void ShiftGrains(double amount);
    void SetLiveMode(bool live) { mLiveMode = live; }
    
    float mSpeed;
@@ -55,10 +62,14 @@ public:
    
 private:
    void SpawnGrain(double time, double offset, bool stereo);
+   float GetDensityGain() const;
    
    double mLastGrainSpawnMs;
+   float mSpacingJitter;
    int mNextGrainIdx;
    Grain mGrains[MAX_GRAINS];
+   int mActiveGrains[MAX_GRAINS];   //indices into mGrains, so rendering doesn't walk the whole pool
+   int mNumActiveGrains;
    bool mLiveMode;
 };
 
@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+    HeadlessRender.cpp
+    Created: 17 Oct 2026 3:52:18pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "HeadlessRender.h"
+#include "ModularSynth.h"
+#include "Transport.h"
+#include "Profiler.h"
+
+namespace
+{
+   const char* kRenderFlag = "--render";
+   const int kPollsPerSecond = 60;   //how often the ui thread would have polled, in audio time
+   
+   void PrintUsage()
+   {
+      printf("usage: bespoke --render <state.bsk> <output.wav> [--measures n] [--samplerate n] [--buffersize n] [--profile <file.json|file.csv>]\n");
+   }
+}
+
+//static
+bool HeadlessRender::IsRequested(const StringArray& args)
+{
+   return args.contains(kRenderFlag);
+}
+
+//static
+string HeadlessRender::GetOption(const StringArray& args, const char* option, string defaultValue)
+{
+   int index = args.indexOf(option);
+   if (index != -1 && index + 1 < args.size())
+      return args[index + 1].toStdString();
+   return defaultValue;
+}
+
+//static
+int HeadlessRender::Run(const StringArray& args)
+{
+   int flagIndex = args.indexOf(kRenderFlag);
+   if (flagIndex + 2 >= args.size())
+   {
+      PrintUsage();
+      return 1;
+   }
+   
+   string statePath = args[flagIndex + 1].toStdString();
+   string outputPath = File::getCurrentWorkingDirectory().getChildFile(args[flagIndex + 2]).getFullPathName().toStdString();
+   int numMeasures = ofToInt(GetOption(args, "--measures", "8"));
+   string profilePath = GetOption(args, "--profile", "");
+   if (numMeasures <= 0)
+   {
+      PrintUsage();
+      return 1;
+   }
+   
+   GlobalManagers globalManagers;
+   ModularSynth synth;
+   synth.Setup(&globalManagers, nullptr);
+   
+   int sampleRate = ofToInt(GetOption(args, "--samplerate", ofToString(gSampleRate)));
+   int bufferSize = ofToInt(GetOption(args, "--buffersize", ofToString(gBufferSize)));
+   if (sampleRate <= 0 || bufferSize <= 0 || bufferSize > kWorkBufferSize)
+   {
+      printf("invalid sample rate or buffer size\n");
+      return 1;
+   }
+   synth.SetUpHeadless(sampleRate, bufferSize);
+   
+   //relative to the working directory, LoadState() would look in data/
+   if (!File::isAbsolutePath(statePath))
+      statePath = File::getCurrentWorkingDirectory().getChildFile(statePath).getFullPathName().toStdString();
+   if (!synth.LoadState(statePath))
+   {
+      printf("couldn't load %s\n", statePath.c_str());
+      return 1;
+   }
+   synth.GetSampleLoader()->Flush();   //samples the state asked for should be there from the first block
+   
+   File outputFile(outputPath);
+   outputFile.deleteFile();
+   FileOutputStream* outputStream = outputFile.createOutputStream();
+   if (outputStream == nullptr)
+   {
+      printf("couldn't write to %s\n", outputPath.c_str());
+      return 1;
+   }
+   WavAudioFormat wavFormat;
+   ScopedPointer<AudioFormatWriter> writer = wavFormat.createWriterFor(outputStream, gSampleRate, 2, 32, StringPairArray(), 0);
+   if (writer == nullptr)
+   {
+      delete outputStream;
+      printf("couldn't create a wav writer for %s\n", outputPath.c_str());
+      return 1;
+   }
+   
+   if (profilePath != "")
+   {
+      if (String(profilePath).endsWithIgnoreCase(".csv"))
+         Profiler::SetEnabled(true);
+      else
+         Profiler::StartTraceCapture();
+   }
+   
+   float* output[2];
+   output[0] = new float[bufferSize];
+   output[1] = new float[bufferSize];
+   int blocksPerPoll = MAX(1, sampleRate / bufferSize / kPollsPerSecond);
+   int64 numSamplesWritten = 0;
+   double startMs = Time::getMillisecondCounterHiRes();
+   
+   for (int block = 0; ; ++block)
+   {
+      if (block % blocksPerPoll == 0)
+         synth.Poll();
+      
+      synth.AudioOut(output, bufferSize, 2);
+      
+      //stop exactly on the downbeat of the last measure, tempo changes and all
+      int numSamples = bufferSize;
+      double measureTime = TheTransport->GetMeasureTime(gTime);
+      bool done = measureTime >= numMeasures;
+      if (done)
+      {
+         double overshootMs = (measureTime - numMeasures) * TheTransport->MsPerBar();
+         numSamples = CLAMP(bufferSize - (int)(overshootMs * gSampleRateMs + .5), 0, bufferSize);
+      }
+      
+      writer->writeFromFloatArrays(output, 2, numSamples);
+      numSamplesWritten += numSamples;
+      
+      if (done)
+         break;
+   }
+   
+   writer = nullptr;   //flushes and closes the file
+   delete[] output[0];
+   delete[] output[1];
+   
+   double elapsedSeconds = (Time::getMillisecondCounterHiRes() - startMs) / 1000;
+   double renderedSeconds = numSamplesWritten / (double)sampleRate;
+   printf("rendered %d measures (%.2fs) to %s in %.2fs, %.1fx realtime\n", numMeasures, renderedSeconds, outputPath.c_str(),
+          elapsedSeconds, elapsedSeconds > 0 ? renderedSeconds / elapsedSeconds : 0);
+   
+   if (profilePath != "")
+   {
+      profilePath = File::getCurrentWorkingDirectory().getChildFile(profilePath).getFullPathName().toStdString();
+      bool written;
+      if (String(profilePath).endsWithIgnoreCase(".csv"))
+         written = Profiler::WriteCSV(profilePath);
+      else
+         written = Profiler::WriteChromeTrace(profilePath);
+      if (!written)
+      {
+         printf("couldn't write profiler output to %s\n", profilePath.c_str());
+         return 1;
+      }
+   }
+   
+   return 0;
+}
@@ -0,0 +1,28 @@
+/*
+  ==============================================================================
+
+    HeadlessRender.h
+    Created: 17 Oct 2026 3:52:18pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "OpenFrameworksPort.h"
+
+//bespoke --render <state.bsk> <output.wav> [--measures n] [--samplerate n] [--buffersize n] [--profile <file.json|file.csv>]
+//
+//loads a savestate and runs the audio graph as fast as it can with no window, gl context or audio device,
+//streaming the output to a 32-bit float wav. for batch bounces and regression renders on build machines.
+class HeadlessRender
+{
+public:
+   static bool IsRequested(const StringArray& args);
+   static int Run(const StringArray& args);  //returns the process exit code
+   
+   //value following "--option", for the command line modes
+   static string GetOption(const StringArray& args, const char* option, string defaultValue);
+};
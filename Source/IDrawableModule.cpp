@@ -51,6 +51,8 @@ IDrawableModule::IDrawableModule()
 , mHoveringOverResizeHandle(false)
 , mDeleted(false)
 , mDrawDebug(false)
+, mModulatedSlidersGeneration(-1)
+, mModulatedSlidersFrozen(false)
 {
 }
 
@@ -754,6 +756,8 @@ void IDrawableModule::AddUIControl(IUIControl* control)
    {
       mSliderMutex.lock();
       mFloatSliders.push_back(slider);
+      mModulatedSliders.reserve(mFloatSliders.size());   //so the audio thread never has to grow it
+      mModulatedSlidersGeneration = -1;
       mSliderMutex.unlock();
    }
 }
@@ -766,16 +770,41 @@ void IDrawableModule::RemoveUIControl(IUIControl* control)
    {
       mSliderMutex.lock();
       RemoveFromVector(slider, mFloatSliders, K(fail));
+      RemoveFromVector(slider, mModulatedSliders);
+      mModulatedSlidersGeneration = -1;
       mSliderMutex.unlock();
    }
 }
 
 void IDrawableModule::ComputeSliders(int samplesIn)
 {
-   //mSliderMutex.lock(); TODO(Ryan) mutex acquisition is slow, how can I do this faster?
-   for (int i=0; i<mFloatSliders.size(); ++i)
-      mFloatSliders[i]->Compute(samplesIn);
-   //mSliderMutex.unlock();
+   //this gets called per sample (and per voice), so only visit the sliders that have something to compute
+   if (mModulatedSlidersGeneration != FloatSlider::GetModulationGeneration() && !mModulatedSlidersFrozen)
+      UpdateModulatedSliders();
+   
+   for (int i=0; i<mModulatedSliders.size(); ++i)
+      mModulatedSliders[i]->Compute(samplesIn);
+}
+
+bool IDrawableModule::HasModulatedSliders()
+{
+   if (mModulatedSlidersGeneration != FloatSlider::GetModulationGeneration() && !mModulatedSlidersFrozen)
+      UpdateModulatedSliders();
+   return !mModulatedSliders.empty();
+}
+
+void IDrawableModule::UpdateModulatedSliders()
+{
+   mSliderMutex.lock();
+   mModulatedSlidersGeneration = FloatSlider::GetModulationGeneration();
+   mModulatedSliders.clear();
+   for (auto* slider : mFloatSliders)
+   {
+      slider->SetComputedByOwner();
+      if (slider->IsModulated())
+         mModulatedSliders.push_back(slider);
+   }
+   mSliderMutex.unlock();
 }
 
 PatchCableOld IDrawableModule::GetPatchCableOld(IClickable* target)
@@ -100,6 +100,9 @@ public:
    ModuleType GetModuleType() const { return mModuleType; }
    virtual bool IsSingleton() const { return false; }
    void ComputeSliders(int samplesIn);
+   bool HasModulatedSliders();
+   //while frozen, ComputeSliders() keeps the slider list it has rather than rebuilding it, so it can be called from several threads at once
+   void SetModulatedSlidersFrozen(bool frozen) { mModulatedSlidersFrozen = frozen; }
    void SetOwningContainer(ModuleContainer* container) { mOwningContainer = container; }
    ModuleContainer* GetOwningContainer() const { return mOwningContainer; }
    virtual ModuleContainer* GetContainer() { return nullptr; }
@@ -158,10 +161,14 @@ private:
    virtual bool Enabled() const { return true; }
    float GetMinimizedWidth();
    PatchCableOld GetPatchCableOld(IClickable* target);
+   void UpdateModulatedSliders();
 
    vector<IUIControl*> mUIControls;
    vector<IDrawableModule*> mChildren;
    vector<FloatSlider*> mFloatSliders;
+   vector<FloatSlider*> mModulatedSliders;   //subset of mFloatSliders that ComputeSliders() visits
+   int mModulatedSlidersGeneration;
+   bool mModulatedSlidersFrozen;
    static const int mTitleBarHeight = 12;
    string mTypeName;
    static const int sResizeCornerSize = 8;
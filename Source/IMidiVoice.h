@@ -24,8 +24,9 @@ public:
    void SetModulators(ModulationParameters modulators) { mModulators = modulators; }
    virtual void Start(double time, float amount) = 0;
    virtual void Stop(double time) = 0;
-   virtual bool Process(double time, ChannelBuffer* out) = 0;
+   virtual bool Process(double time, ChannelBuffer* out) = 0;   //returns false once the voice has nothing left to play
    virtual bool IsDone(double time) = 0;
+   virtual float GetLevel(double time) = 0;   //envelope level, for picking a voice to steal and culling inaudible ones
    virtual void SetVoiceParams(IVoiceParams* params) = 0;
    void SetPan(float pan) { assert(pan >= -1 && pan <= 1); mPan = pan; }
    float GetPan() const { assert(mPan >= -1 && mPan <= 1); return mPan; }
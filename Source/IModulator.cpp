@@ -22,12 +22,64 @@ IModulator::IModulator()
 , mTarget(nullptr)
 , mUIControlTarget(nullptr)
 {
+   for (int i=0; i<2; ++i)
+   {
+      mBlockValues[i].resize(kWorkBufferSize);
+      mBlockTime[i] = -1;
+   }
+}
+
+float IModulator::GetBlockValue(int samplesIn, bool sampleAccurate)
+{
+   sampleAccurate = sampleAccurate || IsAudioRate();
+   samplesIn = CLAMP(samplesIn, 0, gBufferSize - 1);
+   
+   //a sample accurate block is good enough for a control rate reader too
+   if (mBlockTime[1].load(std::memory_order_acquire) == gTime)
+      return mBlockValues[1][samplesIn];
+   
+   int which = sampleAccurate ? 1 : 0;
+   if (mBlockTime[which].load(std::memory_order_acquire) != gTime)
+   {
+      const SpinLock::ScopedLockType lock(mBlockLock);
+      if (mBlockTime[which].load(std::memory_order_relaxed) != gTime)   //another thread might have filled it while we waited
+      {
+         FillBlock(mBlockValues[which], sampleAccurate);
+         mBlockTime[which].store(gTime, std::memory_order_release);
+      }
+   }
+   return mBlockValues[which][samplesIn];
+}
+
+void IModulator::FillBlock(vector<float>& values, bool sampleAccurate)
+{
+   int bufferSize = MIN(gBufferSize, (int)values.size());
+   
+   if (sampleAccurate)
+   {
+      for (int i=0; i<bufferSize; ++i)
+         values[i] = Value(i);
+      return;
+   }
+   
+   float start = Value(0);
+   for (int i=0; i<bufferSize; i += kControlInterval)
+   {
+      int next = MIN(i + kControlInterval, bufferSize - 1);
+      float end = next > i ? Value(next) : start;
+      int segmentEnd = MIN(i + kControlInterval, bufferSize);
+      float step = next > i ? (end - start) / (next - i) : 0;
+      for (int j=i; j<segmentEnd; ++j)
+         values[j] = start + step * (j - i);
+      start = end;
+   }
 }
 
 void IModulator::OnModulatorRepatch()
 {
    assert(mTargetCable != nullptr);
    
+   FloatSlider* oldTarget = mTarget;
    if (mTargetCable->GetPatchCables().empty() == false)
    {
       IUIControl* newTarget = dynamic_cast<IUIControl*>(mTargetCable->GetPatchCables()[0]->GetTarget());
@@ -56,6 +108,9 @@ void IModulator::OnModulatorRepatch()
       TheSynth->AddExtraPoller(this);
    else
       TheSynth->RemoveExtraPoller(this);
+   
+   if (mTarget != oldTarget)   //the audio graph orders modules after the modulators they read
+      TheSynth->ArrangeAudioSourceDependencies();
 }
 
 void IModulator::Poll()
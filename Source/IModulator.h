@@ -12,6 +12,7 @@
 
 #include "Slider.h"
 #include "IPollable.h"
+#include <atomic>
 
 class PatchCableSource;
 
@@ -22,15 +23,24 @@ public:
    virtual ~IModulator() {}
    virtual float Value(int samplesIn = 0) = 0;
    virtual bool Active() const = 0;
+   virtual bool IsAudioRate() const { return false; }   //changes too fast to be ramped between control points
+   
+   //Value() for the whole block is computed on the first read and cached. control rate evaluates every
+   //kControlInterval samples and ramps between them, audio rate (or a sample accurate target) evaluates every sample
+   float GetBlockValue(int samplesIn, bool sampleAccurate);
+   static const int kControlInterval = 16;
+   
    virtual bool CanAdjustRange() const { return true; }
    virtual bool InitializeWithZeroRange() const { return false; }
    float& GetMin() { return mTarget ? mTarget->GetModulatorMin() : mDummyMin; }
    float& GetMax() { return mTarget ? mTarget->GetModulatorMax() : mDummyMax; }
+   FloatSlider* GetSliderTarget() const { return mTarget; }
    void OnModulatorRepatch();
    void Poll() override;
 protected:
    void InitializeRange();
    bool RequiresManualPolling() { return mUIControlTarget != nullptr && mTarget == nullptr; }
+   void FillBlock(vector<float>& values, bool sampleAccurate);
    
    float mDummyMin;
    float mDummyMax;
@@ -40,4 +50,10 @@ protected:
    FloatSlider* mMaxSlider;
    FloatSlider* mTarget;
    IUIControl* mUIControlTarget;
+   
+   //one block each for control rate and sample accurate, so a block is never refilled while another thread is reading it.
+   //a block's time is only published once it's filled
+   vector<float> mBlockValues[2];
+   std::atomic<double> mBlockTime[2];
+   SpinLock mBlockLock;
 };
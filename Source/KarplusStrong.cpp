@@ -153,7 +153,7 @@ void KarplusStrong::FloatSliderUpdated(FloatSlider* slider, float oldVal)
 void KarplusStrong::LoadLayout(const ofxJSONElement& moduleInfo)
 {
    mModuleSaveData.LoadString("target", moduleInfo);
-   mModuleSaveData.LoadInt("voicelimit", moduleInfo, -1, -1, kNumVoices);
+   mModuleSaveData.LoadInt("voicelimit", moduleInfo, -1, -1, kMaxVoicePoolSize);
 
    SetUpFromSaveData();
 }
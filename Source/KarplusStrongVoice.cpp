@@ -12,14 +12,24 @@
 #include "Scale.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "ScratchArena.h"
+#include "Float4.h"
 
 KarplusStrongVoice::KarplusStrongVoice(IDrawableModule* owner)
 : mOscPhase(0)
 , mOsc(kOsc_Sin)
-, mBuffer(gSampleRate)
 , mFilterSample(0)
 , mOwner(owner)
+, mNoiseState((uint32_t)rand() | 1)
 {
+   //power of two so the write position wraps with a mask, doubled for the mirrored copy, and padded out to align the start
+   mDelaySize = nextPowerOfTwo(gSampleRate);
+   mDelayMask = mDelaySize - 1;
+   mDelayMemory.resize(mDelaySize * 2 + kDelayAlignment / sizeof(float));
+   mDelay = (float*)(((uintptr_t)mDelayMemory.data() + kDelayAlignment - 1) & ~(uintptr_t)(kDelayAlignment - 1));
+   mDelayWritePos = 0;
+   mDelayReadable = 0;
+
    mOsc.Start(0, 1);
    mEnv.SetNumStages(2);
    mEnv.GetHasSustainStage() = false;
@@ -39,6 +49,12 @@ bool KarplusStrongVoice::IsDone(double time)
    return !mActive || mMuteRamp.Value(time) == 0;
 }
 
+float KarplusStrongVoice::GetLevel(double time)
+{
+   //the string rings on its own after the exciter is done, only muting brings it down
+   return mActive ? mMuteRamp.Value(time) : 0;
+}
+
 bool KarplusStrongVoice::Process(double time, ChannelBuffer* out)
 {
    PROFILER(KarplusStrongVoice);
@@ -46,6 +62,8 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out)
    if (IsDone(time))
       return false;
    
+   ScopedNoDenormals noDenormals;   //the string decays toward zero for as long as it rings, flush rather than fixing up every sample
+   
    int bufferSize = out->BufferSize();
    float renderRatio = 1;
    int pitchAdjust = 0;
@@ -57,76 +75,21 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out)
    
    int renderSize = bufferSize/renderRatio;
    
-   for (int pos=0; pos<renderSize; ++pos)
-   {
-      if (mOwner)
-         mOwner->ComputeSliders(pos);
-      
-      float pitch = GetPitch(pos) + pitchAdjust;
-      
-      float filter = ofClamp(ofMap(TheScale->PitchToFreq(pitch),0,880,mVoiceParams->mFilter,0), 0, 1);
-      float freq = TheScale->PitchToFreq(pitch);
-      
-      float oscPhaseInc = 0;
-      if (mVoiceParams->mSourceType == kSourceTypeSaw)
-      {
-         oscPhaseInc = GetPhaseInc(freq);
-         mOsc.SetType(kOsc_Saw);
-      }
-      else
-      {
-         oscPhaseInc = GetPhaseInc(mVoiceParams->mExciterFreq);
-         mOsc.SetType(kOsc_Sin);
-      }
-      mOscPhase += oscPhaseInc;
-      float sample = 0;
-      float sinSample = mOsc.Audio(time, mOscPhase);
-      float noiseSample = RandomSample();
-      float pitchBlend = ofClamp((pitch - 40) / 60.0f,0,1);
-      pitchBlend *= pitchBlend;
-      if (mVoiceParams->mSourceType == kSourceTypeSin)
-         sample = sinSample;
-      else if (mVoiceParams->mSourceType == kSourceTypeNoise)
-         sample = noiseSample;
-      else if (mVoiceParams->mSourceType == kSourceTypeMix)
-         sample = noiseSample*pitchBlend + sinSample*(1-pitchBlend);
-      else if (mVoiceParams->mSourceType == kSourceTypeSaw)
-         sample = mOsc.Audio(time, mOscPhase) / (1+pitchBlend*6);   //quieter at higher pitches
-      sample *= mEnv.Value(time) + mVoiceParams->mExcitation;
-
-      float samplesAgo = gSampleRate/freq;
-      AssertIfDenormal(samplesAgo);
-      float feedbackSample = 0;
-      if (samplesAgo < mBuffer.Size())
-      {
-         //interpolated delay
-         int pos = int(samplesAgo);
-         int posNext = int(samplesAgo)+1;
-         if (pos < mBuffer.Size())
-         {
-            float sample = pos < 0 ? 0 : mBuffer.GetSample(pos, 0);
-            float nextSample = posNext >= mBuffer.Size() ? 0 : mBuffer.GetSample(posNext, 0);
-            float a = samplesAgo - pos;
-            feedbackSample = (1-a)*sample + a*nextSample; //interpolate
-            AssertIfDenormal(feedbackSample);
-         }
-      }
-      feedbackSample = (1-filter) * feedbackSample + filter * mFilterSample;
-      //AssertIfDenormal(feedbackSample);
-      mFilterSample = feedbackSample;
-      FIX_DENORMAL(mFilterSample);
-      //sample += mFeedbackRamp.Value(time) * feedbackSample;
-      sample += feedbackSample * sqrtf(mVoiceParams->mFeedback) * mMuteRamp.Value(time);
-      FIX_DENORMAL(sample);
-
-      mBuffer.Write(sample, 0);
-
-      float output = sample * mVoiceParams->mVol/10.0f * (1 + GetPressure(pos*renderRatio));
-      AssertIfDenormal(output);
-      
-      gWorkBuffer[pos] = output;
-      
-   }
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
+   float* env = scratch.GetBuffer();
+   mEnv.Process(time, env, bufferSize);
+   
+   //with no modulated sliders and the pitch holding still, the delay tap and filter stay put for the whole block
+   float pitch = GetPitch(0) + pitchAdjust;
+   bool constantPitch = true;
+   for (int pos=1; pos<renderSize && constantPitch; ++pos)
+      constantPitch = (GetPitch(pos) + pitchAdjust == pitch);
+   
+   if (constantPitch && !(mOwner && mOwner->HasModulatedSliders()))
+      RenderBlock(time, pitch, env, renderRatio, workBuffer, renderSize);
+   else
+      RenderPerSample(time, pitchAdjust, env, renderRatio, workBuffer, renderSize);
    
    for (int i=0; i<bufferSize; ++i) //stretch half buffer to fill output
    {
@@ -137,7 +100,7 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out)
       }
       else if (i%2 == 1)*/
       {
-         sample = gWorkBuffer[int(i/renderRatio)];
+         sample = workBuffer[int(i/renderRatio)];
       }
       /*else
       {
@@ -155,11 +118,186 @@ bool KarplusStrongVoice::Process(double time, ChannelBuffer* out)
       }
    }
       
-   mLastBufferSample = gWorkBuffer[renderSize-1];
+   mLastBufferSample = workBuffer[renderSize-1];
    
    return true;
 }
 
+void KarplusStrongVoice::RenderBlock(double time, float pitch, const float* env, float renderRatio, float* output, int renderSize)
+{
+   float freq = TheScale->PitchToFreq(pitch);
+   float filter = ofClamp(ofMap(freq,0,880,mVoiceParams->mFilter,0), 0, 1);
+   float samplesAgo = gSampleRate/freq;
+   float feedbackGain = sqrtf(mVoiceParams->mFeedback) * mMuteRamp.Value(time);
+   
+   ScratchArena::Scope scratch;
+   float* excitation = scratch.GetBuffer();
+   RenderExciter(time, freq, pitch, env, renderRatio, excitation, renderSize);
+   
+   int tap = int(samplesAgo);
+   float a = samplesAgo - tap;
+   float b = 1 - filter;
+   float filtered = mFilterSample;
+   int pos = 0;
+   
+   if (tap >= 4 && tap + 1 <= mDelayReadable)
+   {
+      //four samples at a time. every tap a group reads was written before the group started,
+      //and the one-pole filter is unrolled so each group only needs the previous group's last output
+      float f2 = filter * filter;
+      float f3 = f2 * filter;
+      Float4 carry = Float4::Set(filter, f2, f3, f3 * filter);
+      Float4 k0 = Float4::Set(b, filter * b, f2 * b, f3 * b);
+      Float4 k1 = Float4::Set(0, b, filter * b, f2 * b);
+      Float4 k2 = Float4::Set(0, 0, b, filter * b);
+      Float4 k3 = Float4::Set(0, 0, 0, b);
+      Float4 newerWeight = Float4::Set(1 - a);
+      Float4 olderWeight = Float4::Set(a);
+      Float4 gain = Float4::Set(feedbackGain);
+      float taps[4];
+      
+      for (; pos+4<=renderSize; pos+=4)
+      {
+         const float* older = mDelay + ((mDelayWritePos - tap - 1) & mDelayMask);
+         (Float4::Load(older + 1) * newerWeight + Float4::Load(older) * olderWeight).Store(taps);
+         
+         Float4 group = carry * Float4::Set(filtered) +
+                        k0 * Float4::Set(taps[0]) +
+                        k1 * Float4::Set(taps[1]) +
+                        k2 * Float4::Set(taps[2]) +
+                        k3 * Float4::Set(taps[3]);
+         filtered = group.Last();
+         
+         (Float4::Load(excitation + pos) + group * gain).Store(output + pos);
+         for (int i=0; i<4; ++i)
+            WriteDelay(output[pos + i]);
+      }
+   }
+   
+   for (; pos<renderSize; ++pos)
+   {
+      filtered = b * ReadDelay(samplesAgo) + filter * filtered;
+      output[pos] = excitation[pos] + filtered * feedbackGain;
+      WriteDelay(output[pos]);
+   }
+   mFilterSample = filtered;
+   
+   float outGain = mVoiceParams->mVol/10.0f;
+   for (pos=0; pos<renderSize; ++pos)
+      output[pos] *= outGain * (1 + GetPressure(pos*renderRatio));
+}
+
+void KarplusStrongVoice::RenderPerSample(double time, int pitchAdjust, const float* env, float renderRatio, float* output, int renderSize)
+{
+   for (int pos=0; pos<renderSize; ++pos)
+   {
+      if (mOwner)
+         mOwner->ComputeSliders(pos);
+      
+      float pitch = GetPitch(pos) + pitchAdjust;
+      float freq = TheScale->PitchToFreq(pitch);
+      float filter = ofClamp(ofMap(freq,0,880,mVoiceParams->mFilter,0), 0, 1);
+      
+      float oscPhaseInc = SetUpExciterOsc(freq);
+      mOscPhase += oscPhaseInc;
+      float pitchBlend = ofClamp((pitch - 40) / 60.0f,0,1);
+      pitchBlend *= pitchBlend;
+      float sample = ExciterSample(time, pitchBlend) * (env[int(pos*renderRatio)] + mVoiceParams->mExcitation);
+      
+      float samplesAgo = gSampleRate/freq;
+      float feedbackSample = (1-filter) * ReadDelay(samplesAgo) + filter * mFilterSample;
+      mFilterSample = feedbackSample;
+      //sample += mFeedbackRamp.Value(time) * feedbackSample;
+      sample += feedbackSample * sqrtf(mVoiceParams->mFeedback) * mMuteRamp.Value(time);
+      
+      WriteDelay(sample);
+      
+      output[pos] = sample * mVoiceParams->mVol/10.0f * (1 + GetPressure(pos*renderRatio));
+   }
+}
+
+void KarplusStrongVoice::RenderExciter(double time, float freq, float pitch, const float* env, float renderRatio, float* output, int renderSize)
+{
+   float oscPhaseInc = SetUpExciterOsc(freq);
+   
+   //the exciter is only a short burst at the start of the note, after that the string rings on its own
+   bool silent = mVoiceParams->mExcitation == 0;
+   for (int pos=0; pos<renderSize && silent; ++pos)
+      silent = env[int(pos*renderRatio)] == 0;
+   if (silent)
+   {
+      mOscPhase += oscPhaseInc * renderSize;
+      Clear(output, renderSize);
+      return;
+   }
+   
+   float pitchBlend = ofClamp((pitch - 40) / 60.0f,0,1);
+   pitchBlend *= pitchBlend;
+   for (int pos=0; pos<renderSize; ++pos)
+   {
+      mOscPhase += oscPhaseInc;
+      output[pos] = ExciterSample(time, pitchBlend) * (env[int(pos*renderRatio)] + mVoiceParams->mExcitation);
+   }
+}
+
+float KarplusStrongVoice::SetUpExciterOsc(float freq)
+{
+   if (mVoiceParams->mSourceType == kSourceTypeSaw)
+   {
+      mOsc.SetType(kOsc_Saw);
+      return GetPhaseInc(freq);
+   }
+   mOsc.SetType(kOsc_Sin);
+   return GetPhaseInc(mVoiceParams->mExciterFreq);
+}
+
+float KarplusStrongVoice::ExciterSample(double time, float pitchBlend)
+{
+   switch (mVoiceParams->mSourceType)
+   {
+      case kSourceTypeSin:
+         return mOsc.Audio(time, mOscPhase);
+      case kSourceTypeNoise:
+         return NoiseSample();
+      case kSourceTypeMix:
+         return NoiseSample()*pitchBlend + mOsc.Audio(time, mOscPhase)*(1-pitchBlend);
+      case kSourceTypeSaw:
+         return mOsc.Audio(time, mOscPhase) / (1+pitchBlend*6);   //quieter at higher pitches
+   }
+   return 0;
+}
+
+float KarplusStrongVoice::NoiseSample()
+{
+   //xorshift, so voices rendering on different threads don't all queue up on rand()'s lock
+   mNoiseState ^= mNoiseState << 13;
+   mNoiseState ^= mNoiseState >> 17;
+   mNoiseState ^= mNoiseState << 5;
+   return mNoiseState * (2.0f / 4294967296.0f) - 1;
+}
+
+float KarplusStrongVoice::ReadDelay(float samplesAgo) const
+{
+   //interpolated delay
+   int tap = int(samplesAgo);
+   if (tap < 1 || tap + 1 > mDelayReadable)
+      return 0;
+   float a = samplesAgo - tap;
+   float newer = mDelay[(mDelayWritePos - tap) & mDelayMask];
+   float older = mDelay[(mDelayWritePos - tap - 1) & mDelayMask];
+   return (1-a)*newer + a*older;
+}
+
+void KarplusStrongVoice::WriteDelay(float sample)
+{
+   //every sample is written twice, a delay length apart, so any span of the line can be read without wrapping
+   mDelay[mDelayWritePos] = sample;
+   mDelay[mDelayWritePos + mDelaySize] = sample;
+   mDelayWritePos = (mDelayWritePos + 1) & mDelayMask;
+   if (mDelayReadable < mDelayMask)
+      ++mDelayReadable;
+}
+
 void KarplusStrongVoice::Start(double time, float target)
 {
    mOscPhase = FPI/2;   //magic number that seems to keep things DC centered ok
@@ -183,7 +321,9 @@ void KarplusStrongVoice::Stop(double time)
 
 void KarplusStrongVoice::ClearVoice()
 {
-   mBuffer.ClearBuffer();
+   //no need to wipe the line, reads only reach back as far as this note has written
+   mDelayWritePos = 0;
+   mDelayReadable = 0;
    mFilterSample = 0;
    mLastBufferSample = 0;
    mActive = false;
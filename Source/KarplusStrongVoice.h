@@ -10,12 +10,12 @@
 #define __modularSynth__KarplusStrongVoice__
 
 #include <iostream>
+#include <vector>
 #include "OpenFrameworksPort.h"
 #include "IMidiVoice.h"
 #include "IVoiceParams.h"
 #include "ADSR.h"
 #include "EnvOscillator.h"
-#include "RollingBuffer.h"
 #include "Ramp.h"
 
 class IDrawableModule;
@@ -68,17 +68,37 @@ public:
    bool Process(double time, ChannelBuffer* out) override;
    void SetVoiceParams(IVoiceParams* params) override;
    bool IsDone(double time) override;
+   float GetLevel(double time) override;
 private:
+   //pitch, filter and delay tap worked out once, feedback loop four samples at a time
+   void RenderBlock(double time, float pitch, const float* env, float renderRatio, float* output, int renderSize);
+   //everything re-evaluated every sample, for bent pitches and modulated sliders
+   void RenderPerSample(double time, int pitchAdjust, const float* env, float renderRatio, float* output, int renderSize);
+   void RenderExciter(double time, float freq, float pitch, const float* env, float renderRatio, float* output, int renderSize);
+   float SetUpExciterOsc(float freq);
+   float ExciterSample(double time, float pitchBlend);
+   float NoiseSample();
+   float ReadDelay(float samplesAgo) const;
+   void WriteDelay(float sample);
+   
+   static const int kDelayAlignment = 64;
+   
    float mOscPhase;
    EnvOscillator mOsc;
    ::ADSR mEnv;
    KarplusStrongVoiceParams* mVoiceParams;
-   RollingBuffer mBuffer;
+   std::vector<float> mDelayMemory;
+   float* mDelay;
+   int mDelaySize;
+   int mDelayMask;
+   int mDelayWritePos;
+   int mDelayReadable;   //how far back the line holds samples from this note, everything older reads as silence
    float mFilterSample;
    Ramp mMuteRamp;
    float mLastBufferSample;
    bool mActive;
    IDrawableModule* mOwner;
+   uint32_t mNoiseState;
 };
 
 #endif /* defined(__modularSynth__KarplusStrongVoice__) */
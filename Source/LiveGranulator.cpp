@@ -10,6 +10,7 @@
 #include "SynthGlobals.h"
 #include "Profiler.h"
 #include "UIControlMacros.h"
+#include "ScratchArena.h"
 
 LiveGranulator::LiveGranulator()
 : mBufferLength(gSampleRate*5)
@@ -46,7 +47,7 @@ void LiveGranulator::CreateUIControls()
 {
    IDrawableModule::CreateUIControls();
    UIBLOCK(80);
-   FLOATSLIDER(mGranOverlap,"overlap",&mGranulator.mGrainOverlap,.5f,MAX_GRAINS);
+   FLOATSLIDER(mGranOverlap,"overlap",&mGranulator.mGrainOverlap,.5f,MAX_GRAIN_OVERLAP);
    FLOATSLIDER(mGranSpeed,"speed",&mGranulator.mSpeed,-3,3);
    FLOATSLIDER(mGranLengthMs,"len ms",&mGranulator.mGrainLengthMs,1,200);
    CHECKBOX(mAddCheckbox,"add",&mAdd);
@@ -65,6 +66,7 @@ void LiveGranulator::CreateUIControls()
    mAutoCaptureDropdown->AddLabel("8n", kInterval_8n);
    mAutoCaptureDropdown->AddLabel("16n", kInterval_16n);
    
+   mGranOverlap->SetMode(FloatSlider::kSquare);
    mGranPosRandomize->SetMode(FloatSlider::kSquare);
    mGranSpeedRandomize->SetMode(FloatSlider::kSquare);
    mGranLengthMs->SetMode(FloatSlider::kSquare);
@@ -79,8 +81,11 @@ void LiveGranulator::ProcessAudio(double time, ChannelBuffer* buffer)
 {
    PROFILER(LiveGranulator);
    
-   float bufferSize = buffer->BufferSize();
+   int bufferSize = buffer->BufferSize();
    mBuffer.SetNumChannels(buffer->NumActiveChannels());
+   
+   ScratchArena::Scope scratch;
+   double* offsets = scratch.GetDoubleBuffer();
 
    for (int i=0; i<bufferSize; ++i)
    {
@@ -99,25 +104,31 @@ void LiveGranulator::ProcessAudio(double time, ChannelBuffer* buffer)
             mBuffer.Write(buffer->GetChannel(ch)[i], ch);
       }
       
-      if (mEnabled)
+      offsets[i] = mBuffer.GetRawBufferOffset(0)-mFreezeExtraSamples-1+mPos;
+   }
+   
+   if (mEnabled)
+   {
+      ChannelBuffer* grains = scratch.GetChannelBuffer();
+      grains->SetNumActiveChannels(buffer->NumActiveChannels());
+      for (int ch=0; ch<buffer->NumActiveChannels(); ++ch)
+         ::Clear(grains->GetChannel(ch), bufferSize);
+      mGranulator.Process(time, mBuffer.GetRawBuffer(), mBufferLength, offsets, grains, bufferSize);
+      
+      for (int ch=0; ch<buffer->NumActiveChannels(); ++ch)
       {
-         float sample[ChannelBuffer::kMaxNumChannels];
-         Clear(sample, ChannelBuffer::kMaxNumChannels);
-         mGranulator.Process(time, mBuffer.GetRawBuffer(), mBufferLength, mBuffer.GetRawBufferOffset(0)-mFreezeExtraSamples-1+mPos, sample);
-         for (int ch=0; ch<buffer->NumActiveChannels(); ++ch)
+         float* out = buffer->GetChannel(ch);
+         const float* sample = grains->GetChannel(ch);
+         for (int i=0; i<bufferSize; ++i)
          {
-            sample[ch] -= mDCEstimate[ch];
-         
             if (mAdd)
-               buffer->GetChannel(ch)[i] += sample[ch];
+               out[i] += sample[i] - mDCEstimate[ch];
             else
-               buffer->GetChannel(ch)[i] = sample[ch];
+               out[i] = sample[i] - mDCEstimate[ch];
             
-            mDCEstimate[ch] = .999f*mDCEstimate[ch] + .001f*buffer->GetChannel(ch)[i]; //rolling average
+            mDCEstimate[ch] = .999f*mDCEstimate[ch] + .001f*out[i]; //rolling average
          }
       }
-      
-      time += gInvSampleRateMs;
    }
 }
 
@@ -16,7 +16,8 @@
  * http://www.drdobbs.com/parallel/writing-lock-free-code-a-corrected-queue/
  * 
  * This is a linked list, which can expand arbitrarily without losing old data,
- * but which has poor cache locality (I plan to write a ring buffer version soon).
+ * but which has poor cache locality, and produce() allocates. Prefer LockFreeRingQueue
+ * or LockFreeMPSCQueue below when the producer is a real-time thread.
  */
 template<typename T>
 class LockFreeQueue
@@ -85,5 +86,204 @@ private:
     Atomic<Node*> divider, last;
 };
 
+/**
+ * What a fixed capacity queue does when produce() is called while it's full.
+ */
+enum class QueueOverflowPolicy
+{
+    kDrop,       // the new item is discarded and counted in getNumDropped()
+    kOverwrite,  // the oldest item is discarded to make room, and counted (single producer only)
+    kReport      // produce() fails without counting, the producer decides what to do
+};
+
+/**
+ * Padding that keeps the fixed capacity queues' hot fields a cache line apart. It's padding
+ * rather than alignas(64) so the queues can live in objects made with plain new, which
+ * doesn't honour over-alignment before C++17.
+ */
+static const int kQueueCacheLineSize = 64;
+
+/**
+ * Fixed capacity single producer & consumer lock free queue. It never allocates after
+ * construction, so either end can safely be the audio thread.
+ *
+ * Capacity must be a power of two. The read and write positions are kept on separate
+ * cache lines, and each side keeps a cached copy of the other side's position so it only
+ * has to touch the shared one when the queue looks full or empty.
+ */
+template<typename T, int Capacity, QueueOverflowPolicy Policy = QueueOverflowPolicy::kDrop>
+class LockFreeRingQueue
+{
+public:
+    static_assert ((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    
+    LockFreeRingQueue() : writePos(0), cachedReadPos(0), readPos(0), cachedWritePos(0), numDropped(0) {}
+    
+    /**
+     * Add an item to the queue. Should only be called from producer's thread.
+     * Returns false if the item didn't go in.
+     */
+    bool produce (const T& t)
+    {
+        const uint32 write = writePos.get();
+        
+        if (write - cachedReadPos >= (uint32) Capacity)
+        {
+            cachedReadPos = readPos.get();
+            
+            if (write - cachedReadPos >= (uint32) Capacity)
+            {
+                if (Policy != QueueOverflowPolicy::kOverwrite)
+                {
+                    if (Policy == QueueOverflowPolicy::kDrop)
+                        ++numDropped;
+                    return false;
+                }
+                
+                // push the consumer along. if it beats us to it, it took the item instead
+                if (readPos.compareAndSetBool (cachedReadPos + 1, cachedReadPos))
+                    ++numDropped;
+                cachedReadPos = readPos.get();
+            }
+        }
+        
+        items[write & (Capacity - 1)] = t;
+        writePos.set (write + 1);
+        return true;
+    }
+    
+    /**
+     * Consume an item in the queue. Returns false if no items left to consume.
+     */
+    bool consume (T& result)
+    {
+        for (;;)
+        {
+            const uint32 read = readPos.get();
+            
+            if ((int32) (cachedWritePos - read) <= 0)   // the producer can push us past our cached copy when it overwrites
+            {
+                cachedWritePos = writePos.get();
+                if (cachedWritePos == read)
+                    return false;
+            }
+            
+            result = items[read & (Capacity - 1)];
+            
+            if (Policy != QueueOverflowPolicy::kOverwrite)
+            {
+                readPos.set (read + 1);
+                return true;
+            }
+            
+            // the producer may have overwritten this slot while we copied it, try again if so
+            if (readPos.compareAndSetBool (read + 1, read))
+                return true;
+        }
+    }
+    
+    int getNumDropped() const { return numDropped.get(); }
+    
+private:
+    Atomic<uint32> writePos;
+    uint32 cachedReadPos;
+    char writePadding[kQueueCacheLineSize];
+    Atomic<uint32> readPos;
+    uint32 cachedWritePos;
+    char readPadding[kQueueCacheLineSize];
+    Atomic<int> numDropped;
+    char droppedPadding[kQueueCacheLineSize];
+    T items[Capacity];
+};
+
+/**
+ * Fixed capacity multiple producer, single consumer lock free queue, based on Dmitry Vyukov's
+ * bounded queue. Each slot carries a sequence number that says whether it's ready to be written
+ * or read, so producers only contend on the write position. Never allocates after construction.
+ */
+template<typename T, int Capacity, QueueOverflowPolicy Policy = QueueOverflowPolicy::kDrop>
+class LockFreeMPSCQueue
+{
+public:
+    static_assert ((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert (Policy != QueueOverflowPolicy::kOverwrite, "overwrite needs a single producer");
+    
+    LockFreeMPSCQueue() : writePos(0), readPos(0), numDropped(0)
+    {
+        for (int i = 0; i < Capacity; ++i)
+            slots[i].sequence.set ((uint32) i);
+    }
+    
+    /**
+     * Add an item to the queue. Can be called from any number of threads.
+     * Returns false if the item didn't go in.
+     */
+    bool produce (const T& t)
+    {
+        uint32 pos = writePos.get();
+        
+        for (;;)
+        {
+            Slot& slot = slots[pos & (Capacity - 1)];
+            const int32 diff = (int32) (slot.sequence.get() - pos);
+            
+            if (diff == 0)
+            {
+                if (writePos.compareAndSetBool (pos + 1, pos))
+                {
+                    slot.value = t;
+                    slot.sequence.set (pos + 1);    // publish it to the consumer
+                    return true;
+                }
+                pos = writePos.get();
+            }
+            else if (diff < 0)  // full
+            {
+                if (Policy == QueueOverflowPolicy::kDrop)
+                    ++numDropped;
+                return false;
+            }
+            else    // another producer got this slot first
+            {
+                pos = writePos.get();
+            }
+        }
+    }
+    
+    /**
+     * Consume an item in the queue. Returns false if no items left to consume.
+     * Should only be called from consumer's thread.
+     */
+    bool consume (T& result)
+    {
+        Slot& slot = slots[readPos & (Capacity - 1)];
+        
+        if ((int32) (slot.sequence.get() - (readPos + 1)) < 0)  // empty, or a producer hasn't finished writing it
+            return false;
+        
+        result = slot.value;
+        slot.sequence.set (readPos + Capacity);    // hand it back to the producers for the next lap
+        ++readPos;
+        return true;
+    }
+    
+    int getNumDropped() const { return numDropped.get(); }
+    
+private:
+    struct Slot
+    {
+        Atomic<uint32> sequence;
+        T value;
+    };
+    
+    Atomic<uint32> writePos;
+    char writePadding[kQueueCacheLineSize];
+    uint32 readPos;
+    char readPadding[kQueueCacheLineSize];
+    Atomic<int> numDropped;
+    char droppedPadding[kQueueCacheLineSize];
+    Slot slots[Capacity];
+};
+
 
 #endif  // LOCKFREEQUEUE_H_INCLUDED
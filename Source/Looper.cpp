@@ -16,6 +16,7 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 #include "Rewriter.h"
+#include "ScratchArena.h"
 #include "FillSaveDropdown.h"
 
 float Looper::mBeatwheelPosRight = 0;
@@ -144,6 +145,7 @@ void Looper::CreateUIControls()
    mHalveSpeedButton = new ClickButton(this,".5x",147,43);
    mUndoButton = new ClickButton(this,"undo",-1,-1);
    mLoopPosOffsetSlider = new FloatSlider(this,"offset",-1,-1,130,15,&mLoopPosOffset,0,mLoopLength);
+   mLoopPosOffsetSlider->SetSampleAccurate(true);  //scrubbing, steps would be audible
    mResetOffsetButton = new ClickButton(this," r ",-1,-1);
    mWriteOffsetButton = new ClickButton(this," w ",-1,-1);
    mScratchSpeedSlider = new FloatSlider(this,"scrspd",-1,-1,130,15,&mScratchSpeed,-2,2);
@@ -152,7 +154,8 @@ void Looper::CreateUIControls()
    mFourTetSlicesDropdown = new DropdownList(this,"fourtetslices",-1,-1,&mFourTetSlices);
    mShowGranularCheckbox = new Checkbox(this,"granular",-1,-1,&mShowGranular);
    mGranularCheckbox = new Checkbox(this,"g on",3,168,&mGranular);
-   mGranOverlap = new FloatSlider(this,"g overlap",-1,-1,84,15,&mGranulator.mGrainOverlap,.5f,MAX_GRAINS);
+   mGranOverlap = new FloatSlider(this,"g overlap",-1,-1,84,15,&mGranulator.mGrainOverlap,.5f,MAX_GRAIN_OVERLAP);
+   mGranOverlap->SetMode(FloatSlider::kSquare);
    mGranSpeed = new FloatSlider(this,"g speed",-1,-1,84,15,&mGranulator.mSpeed,-3,3);
    mGranLengthMs = new FloatSlider(this,"g len ms",-1,-1,84,15,&mGranulator.mGrainLengthMs,1,200);
    mPosSlider = new FloatSlider(this,"pos",-1,-1,140,15,&mLoopPos,0,mLoopLength);
@@ -348,6 +351,11 @@ void Looper::Process(double time)
    int latencyOffset = 0;
    if (mPitchShift != 1)
       latencyOffset = mPitchShifter[0]->GetLatency();
+   
+   //granular playback is rendered for the whole block after the loop below, so collect where each sample reads from
+   ScratchArena::Scope scratch;
+   double* granularOffsets = scratch.GetDoubleBuffer();
+   float* granularGains = scratch.GetBuffer();
 
    for (int i=0; i<bufferSize; ++i)
    {
@@ -371,7 +379,12 @@ void Looper::Process(double time)
       ::Clear(output, ChannelBuffer::kMaxNumChannels);
       
       if (mGranular)
-         ProcessGranular(time, offset, output);
+      {
+         granularOffsets[i] = offset;
+         granularGains[i] = volSq * mMuteRamp.Value(time);
+         if (mFourTet > 0 && mFourTet < 1)
+            granularGains[i] *= mFourTet;
+      }
       
       for (int ch=0; ch<mBuffer->NumActiveChannels(); ++ch)
       {
@@ -397,13 +410,20 @@ void Looper::Process(double time)
          output[ch] *= volSq;
          
          mWorkBuffer.GetChannel(ch)[i] = output[ch] * mMuteRamp.Value(time);
-
-         GetVizBuffer()->Write(mWorkBuffer.GetChannel(ch)[i] + GetBuffer()->GetChannel(ch)[i], ch);
       }
       
       time += gInvSampleRateMs;
    }
    
+   if (mGranular)
+      ProcessGranular(time - bufferSize * gInvSampleRateMs, granularOffsets, granularGains, bufferSize);
+   
+   for (int ch=0; ch<mBuffer->NumActiveChannels(); ++ch)
+   {
+      for (int i=0; i<bufferSize; ++i)
+         GetVizBuffer()->Write(mWorkBuffer.GetChannel(ch)[i] + GetBuffer()->GetChannel(ch)[i], ch);
+   }
+   
    if (mPitchShift != 1)
    {
       for (int ch=0; ch<mBuffer->NumActiveChannels(); ++ch)
@@ -628,9 +648,23 @@ int Looper::GetMeasureSliceIndex(double time, int sampleIdx, int slicesPerBar)
    return slice;
 }
 
-void Looper::ProcessGranular(double time, float bufferOffset, float* output)
+void Looper::ProcessGranular(double time, const double* offsets, const float* gains, int bufferSize)
 {
-   mGranulator.Process(time, mBuffer, mLoopLength, bufferOffset, output);
+   ScratchArena::Scope scratch;
+   ChannelBuffer* grains = scratch.GetChannelBuffer();
+   grains->SetNumActiveChannels(mBuffer->NumActiveChannels());
+   for (int ch=0; ch<mBuffer->NumActiveChannels(); ++ch)
+      ::Clear(grains->GetChannel(ch), bufferSize);
+   
+   mGranulator.Process(time, mBuffer, mLoopLength, offsets, grains, bufferSize);
+   
+   for (int ch=0; ch<mBuffer->NumActiveChannels(); ++ch)
+   {
+      float* work = mWorkBuffer.GetChannel(ch);
+      const float* grain = grains->GetChannel(ch);
+      for (int i=0; i<bufferSize; ++i)
+         work[i] += grain[i] * gains[i];
+   }
 }
 
 void Looper::ResampleForNewSpeed()
@@ -110,7 +110,7 @@ private:
    void DoUndo();
    void ProcessFourTet(double time, int sampleIdx);
    void ProcessScratch();
-   void ProcessGranular(double time, float bufferOffset, float* output);
+   void ProcessGranular(double time, const double* offsets, const float* gains, int bufferSize);
    void ProcessBeatwheel(double time, int sampleIdx);
    int GetMeasureSliceIndex(double time, int sampleIdx, int slicesPerBar);
    void DrawBeatwheel();
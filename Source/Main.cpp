@@ -9,6 +9,8 @@
  */
 
 #include "../JuceLibraryCode/JuceHeader.h"
+#include "HeadlessRender.h"
+#include "Benchmark.h"
 
 Component* createMainContentComponent();
 
@@ -28,6 +30,20 @@ public:
    {
       // This method is where you should put your application's initialisation code..
       
+      if (HeadlessRender::IsRequested(getCommandLineParameterArray()))
+      {
+         setApplicationReturnValue(HeadlessRender::Run(getCommandLineParameterArray()));
+         quit();
+         return;
+      }
+      
+      if (Benchmark::IsRequested(getCommandLineParameterArray()))
+      {
+         setApplicationReturnValue(Benchmark::Run(getCommandLineParameterArray()));
+         quit();
+         return;
+      }
+      
       mainWindow = new MainWindow (getApplicationName());
    }
    
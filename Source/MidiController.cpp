@@ -38,6 +38,7 @@ MidiController::MidiController()
 , mBindMode(false)
 , mBindCheckbox(nullptr)
 , mTwoWay(true)
+, mLastNumDroppedMessages(0)
 , mControllerIndex(-1)
 , mLastActivityTime(-9999)
 , mLastActivityUIControl(nullptr)
@@ -269,44 +270,40 @@ void MidiController::OnTransportAdvanced(float amount)
 {
    PROFILER(MidiController);
    
-   mQueuedMessageMutex.lock();
-   
-   for (auto note = mQueuedNotes.begin(); note != mQueuedNotes.end(); ++note)
+   MidiNote note;
+   while (mQueuedNotes.consume(note))
    {
       int voiceIdx = -1;
       
       if (mUseChannelAsVoice)
-         voiceIdx = note->mChannel - 1;
+         voiceIdx = note.mChannel - 1;
       
-      PlayNoteOutput(gTime, note->mPitch + mNoteOffset, MIN(127,note->mVelocity*mVelocityMult), voiceIdx, ModulationParameters(mModulation.GetPitchBend(voiceIdx), mModulation.GetModWheel(voiceIdx), mModulation.GetPressure(voiceIdx), 0));
+      PlayNoteOutput(gTime, note.mPitch + mNoteOffset, MIN(127,note.mVelocity*mVelocityMult), voiceIdx, ModulationParameters(mModulation.GetPitchBend(voiceIdx), mModulation.GetModWheel(voiceIdx), mModulation.GetPressure(voiceIdx), 0));
       
       for (auto i = mListeners[mControllerPage].begin(); i != mListeners[mControllerPage].end(); ++i)
-         (*i)->OnMidiNote(*note);
+         (*i)->OnMidiNote(note);
    }
-   mQueuedNotes.clear();
    
-   for (auto note = mQueuedControls.begin(); note != mQueuedControls.end(); ++note)
+   MidiControl control;
+   while (mQueuedControls.consume(control))
    {
       for (auto i = mListeners[mControllerPage].begin(); i != mListeners[mControllerPage].end(); ++i)
-         (*i)->OnMidiControl(*note);
+         (*i)->OnMidiControl(control);
    }
-   mQueuedControls.clear();
    
-   for (auto note = mQueuedProgramChanges.begin(); note != mQueuedProgramChanges.end(); ++note)
+   MidiProgramChange program;
+   while (mQueuedProgramChanges.consume(program))
    {
       for (auto i = mListeners[mControllerPage].begin(); i != mListeners[mControllerPage].end(); ++i)
-         (*i)->OnMidiProgramChange(*note);
+         (*i)->OnMidiProgramChange(program);
    }
-   mQueuedProgramChanges.clear();
    
-   for (auto note = mQueuedPitchBends.begin(); note != mQueuedPitchBends.end(); ++note)
+   MidiPitchBend pitchBend;
+   while (mQueuedPitchBends.consume(pitchBend))
    {
       for (auto i = mListeners[mControllerPage].begin(); i != mListeners[mControllerPage].end(); ++i)
-         (*i)->OnMidiPitchBend(*note);
+         (*i)->OnMidiPitchBend(pitchBend);
    }
-   mQueuedPitchBends.clear();
-   
-   mQueuedMessageMutex.unlock();
 }
 
 void MidiController::OnMidiNote(MidiNote& note)
@@ -316,9 +313,7 @@ void MidiController::OnMidiNote(MidiNote& note)
    
    MidiReceived(kMidiMessage_Note, note.mPitch, note.mVelocity/127.0f, note.mChannel);
    
-   mQueuedMessageMutex.lock();
-   mQueuedNotes.push_back(note);
-   mQueuedMessageMutex.unlock();
+   mQueuedNotes.produce(note);
    
    if (mPrintInput)
       ofLog() << Name() << " note: " << note.mPitch << ", " << note.mVelocity;
@@ -344,9 +339,7 @@ void MidiController::OnMidiControl(MidiControl& control)
    
    MidiReceived(kMidiMessage_Control, control.mControl, control.mValue/127.0f, control.mChannel);
    
-   mQueuedMessageMutex.lock();
-   mQueuedControls.push_back(control);
-   mQueuedMessageMutex.unlock();
+   mQueuedControls.produce(control);
    
    if (mPrintInput)
       ofLog() << Name() << " control: " << control.mControl << ", " << control.mValue;
@@ -374,9 +367,7 @@ void MidiController::OnMidiProgramChange(MidiProgramChange& program)
    
    MidiReceived(kMidiMessage_Program, program.mProgram, program.mChannel);
    
-   mQueuedMessageMutex.lock();
-   mQueuedProgramChanges.push_back(program);
-   mQueuedMessageMutex.unlock();
+   mQueuedProgramChanges.produce(program);
    
    if (mPrintInput)
       ofLog() << Name() << " program change: " << program.mProgram;
@@ -400,9 +391,7 @@ void MidiController::OnMidiPitchBend(MidiPitchBend& pitchBend)
    
    MidiReceived(kMidiMessage_PitchBend, MIDI_PITCH_BEND_CONTROL_NUM, pitchBend.mValue/16383.0f, pitchBend.mChannel);   //16383 = max pitch bend
  
-   mQueuedMessageMutex.lock();
-   mQueuedPitchBends.push_back(pitchBend);
-   mQueuedMessageMutex.unlock();
+   mQueuedPitchBends.produce(pitchBend);
    
    if (mPrintInput)
       ofLog() << Name() << " pitch bend: " << pitchBend.mValue;
@@ -601,6 +590,13 @@ void MidiController::RemoveConnection(int control, MidiMessageType messageType,
 
 void MidiController::Poll()
 {
+   int numDroppedMessages = mQueuedNotes.getNumDropped() + mQueuedControls.getNumDropped() + mQueuedProgramChanges.getNumDropped() + mQueuedPitchBends.getNumDropped();
+   if (numDroppedMessages != mLastNumDroppedMessages)
+   {
+      ofLog() << Name() << ": dropped " << (numDroppedMessages - mLastNumDroppedMessages) << " midi messages, the audio thread isn't keeping up";
+      mLastNumDroppedMessages = numDroppedMessages;
+   }
+   
    bool lastBlink = mBlink;
    mBlink = int(TheTransport->GetMeasurePos(gTime) * TheTransport->GetTimeSigTop() * 2) % 2 == 0;
    
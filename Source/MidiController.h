@@ -22,6 +22,7 @@
 #include "TextEntry.h"
 #include "ModulationChain.h"
 #include "INoteSource.h"
+#include "LockFreeQueue.h"
 
 #define MIDI_PITCH_BEND_CONTROL_NUM 999
 #define MIDI_PAGE_WIDTH 1000
@@ -349,10 +350,12 @@ private:
    Checkbox* mBindCheckbox;
    bool mTwoWay;
    ClickButton* mAddConnectionButton;
-   std::list<MidiNote> mQueuedNotes;
-   std::list<MidiControl> mQueuedControls;
-   std::list<MidiProgramChange> mQueuedProgramChanges;
-   std::list<MidiPitchBend> mQueuedPitchBends;
+   //filled from the midi thread (and anything else that plays into us), drained on the audio thread
+   LockFreeMPSCQueue<MidiNote, 512> mQueuedNotes;
+   LockFreeMPSCQueue<MidiControl, 512> mQueuedControls;
+   LockFreeMPSCQueue<MidiProgramChange, 64> mQueuedProgramChanges;
+   LockFreeMPSCQueue<MidiPitchBend, 256> mQueuedPitchBends;
+   int mLastNumDroppedMessages;
    DropdownList* mControllerList;
    Checkbox* mDrawCablesCheckbox;
    MappingDisplayMode mMappingDisplayMode;
@@ -381,8 +384,6 @@ private:
    int mLayoutWidth;
    int mLayoutHeight;
    vector<GridLayout*> mGrids;
-   
-   ofMutex mQueuedMessageMutex;
 };
 
 #endif /* defined(__modularSynth__MidiController__) */
@@ -30,6 +30,8 @@
 #include "AudioToCV.h"
 #include "ScriptModule.h"
 #include "DrumPlayer.h"
+#include "ScratchArena.h"
+#include "IModulator.h"
 
 ModularSynth* TheSynth = nullptr;
 
@@ -41,7 +43,10 @@ void AtExit()
 }
 
 ModularSynth::ModularSynth()
-: mMoveModule(nullptr)
+: mNextAudioGraphGeneration(1)
+, mAppliedAudioGraphGeneration(0)
+, mDefaultSampleFormat(kSampleFormat_Float)
+, mMoveModule(nullptr)
 , mIsMousePanning(false)
 , mOutputBuffer(RECORDING_LENGTH)
 , mAudioPaused(false)
@@ -54,6 +59,7 @@ ModularSynth::ModularSynth()
 , mLastClickedModule(nullptr)
 , mInitialized(false)
 , mRecordingLength(0)
+, mHeadless(false)
 , mGroupSelectContext(nullptr)
 , mResizeModule(nullptr)
 , mShowLoadStatePopup(false)
@@ -68,6 +74,16 @@ ModularSynth::ModularSynth()
 , mPixelRatio(1)
 {
    mConsoleText[0] = 0;
+   for (int i=0; i<MAX_INPUT_CHANNELS; ++i)
+   {
+      mInput[i] = nullptr;
+      mAudioInput[i] = nullptr;
+   }
+   for (int i=0; i<MAX_OUTPUT_CHANNELS; ++i)
+   {
+      mOutput[i] = nullptr;
+      mAudioOutput[i] = nullptr;
+   }
    assert(TheSynth == nullptr);
    TheSynth = this;
    
@@ -75,12 +91,18 @@ ModularSynth::ModularSynth()
    mSaveOutputBuffer[1] = new float[RECORDING_LENGTH];
    
    mOutputBuffer.SetNumChannels(2);
+   
+   mSampleLoader.SetNumThreads(MAX(1, MIN(4, SystemStats::getNumCpus() / 2)));
+   mSampleStreamer.startThread(7);   //above the loader, a stream running dry is audible
 }
 
 ModularSynth::~ModularSynth()
 {
    DeleteAllModules();
    
+   for (auto& graph : mPublishedAudioGraphs)
+      delete graph.mPlan;
+   
    SetMemoryTrackingEnabled(false); //avoid crashes when the tracking lists themselves are deleted
    
    assert(TheSynth == this);
@@ -110,6 +132,19 @@ void ModularSynth::Setup(GlobalManagers* globalManagers, juce::Component* mainCo
          mScrollMultiplierHorizontal = mUserPrefs["scroll_multiplier_horizontal"].asDouble();
       if (!mUserPrefs["scroll_multiplier_vertical"].isNull())
          mScrollMultiplierVertical = mUserPrefs["scroll_multiplier_vertical"].asDouble();
+      if (!mUserPrefs["audio_worker_threads"].isNull())
+         mAudioGraph.SetNumWorkerThreads(mUserPrefs["audio_worker_threads"].asInt());
+      if (!mUserPrefs["sample_cache_mb"].isNull())
+         mSampleCache.SetMemoryBudget(int64(mUserPrefs["sample_cache_mb"].asInt()) * 1024 * 1024);
+      if (!mUserPrefs["sample_format"].isNull())
+      {
+         EnumMap formats = GetSampleFormatEnumMap();
+         auto format = formats.find(mUserPrefs["sample_format"].asString());
+         if (format != formats.end() && format->second != kSampleFormat_Default)
+            mDefaultSampleFormat = (SampleFormat)format->second;
+         else
+            ofLog() << "unknown sample_format " << mUserPrefs["sample_format"].asString();
+      }
 
       juce::File(ofToDataPath("savestate")).createDirectory();
       juce::File(ofToDataPath("recordings")).createDirectory();
@@ -148,6 +183,17 @@ void ModularSynth::Setup(GlobalManagers* globalManagers, juce::Component* mainCo
    mConsoleEntry = new TextEntry(mConsoleListener,"console",0,20,50,mConsoleText);
 }
 
+//no window, no gl context and no audio device. the caller drives AudioOut() and Poll() itself
+void ModularSynth::SetUpHeadless(int sampleRate, int bufferSize)
+{
+   mHeadless = true;
+   mInitialized = true;   //don't load the default layout on the first Poll()
+   
+   SetGlobalSampleRate(sampleRate);
+   SetGlobalBufferSize(bufferSize);
+   mIOBufferSize = bufferSize;
+}
+
 void ModularSynth::LoadResources(void* nanoVG, void* fontBoundsNanoVG)
 {
    gNanoVG = (NVGcontext*)nanoVG;
@@ -185,6 +231,10 @@ void ModularSynth::Poll()
    
    mZoomer.Update();
    
+   FreeRetiredAudioGraphs();
+   mXrunMonitor.Poll();
+   mSampleLoader.Poll();
+   
    if (!mIsLoadingState)
    {
       for (auto p : mExtraPollers)
@@ -236,7 +286,7 @@ void ModularSynth::Poll()
          desiredCursor = MouseCursor::NormalCursor;
       }
 
-      if (desiredCursor != sCurrentCursor)
+      if (desiredCursor != sCurrentCursor && mMainComponent != nullptr)
       {
          sCurrentCursor = desiredCursor;
          mMainComponent->setMouseCursor(desiredCursor);
@@ -1077,16 +1127,30 @@ void ModularSynth::OnModuleDeleted(IDrawableModule* module)
    for (int i=0; i<MAX_INPUT_CHANNELS; ++i)
    {
       if (module == mInput[i])
+      {
          mInput[i] = nullptr;
+         AudioThreadCommand command;
+         command.mType = AudioThreadCommand::kSetInputChannel;
+         command.mChannel = i;
+         PostAudioThreadCommand(command);
+      }
    }
    
    for (int i=0; i<MAX_OUTPUT_CHANNELS; ++i)
    {
       if (module == mOutput[i])
+      {
          mOutput[i] = nullptr;
+         AudioThreadCommand command;
+         command.mType = AudioThreadCommand::kSetOutputChannel;
+         command.mChannel = i;
+         PostAudioThreadCommand(command);
+      }
    }
    
    mAudioThreadMutex.Unlock();
+   
+   ArrangeAudioSourceDependencies();
 }
 
 void ModularSynth::MouseReleased(int intX, int intY, int button)
@@ -1165,7 +1229,20 @@ void ModularSynth::AudioOut(float** output, int bufferSize, int nChannels)
       return;
    }
    
-   ScopedMutex mutex(&mAudioThreadMutex, "audioOut()");
+   mXrunMonitor.BeginBlock();
+   
+   //the ui thread still holds this lock for big operations like loading. if it doesn't come free soon,
+   //output silence for this block instead of stalling the device callback
+   ScopedTryMutex mutex(&mAudioThreadMutex, "audioOut()", gInvSampleRateMs * bufferSize * .5f);
+   if (!mutex.IsLocked())
+   {
+      for (int ch=0; ch<nChannels; ++ch)
+         ::Clear(output[ch], bufferSize);
+      mXrunMonitor.EndBlock(bufferSize, mAudioThreadMutex.GetLocker());
+      return;
+   }
+   
+   ApplyAudioThreadCommands();
    
    assert(nChannels <= MAX_OUTPUT_CHANNELS);
    
@@ -1176,19 +1253,21 @@ void ModularSynth::AudioOut(float** output, int bufferSize, int nChannels)
                                           //if we want these different, need to fix outBuffer here, and also fix audioIn()
    for (int ioOffset = 0; ioOffset < mIOBufferSize; ioOffset += gBufferSize)
    {
+      ScratchArena::ForThisThread().Reset();
+      
       if (TheVinylTempoControl &&
-          mInput[TheVinylTempoControl->GetLeftChannel()-1] &&
-          mInput[TheVinylTempoControl->GetRightChannel()-1])
+          mAudioInput[TheVinylTempoControl->GetLeftChannel()-1] &&
+          mAudioInput[TheVinylTempoControl->GetRightChannel()-1])
       {
          TheVinylTempoControl->SetVinylControlInput(
-               mInput[TheVinylTempoControl->GetLeftChannel()-1]->GetBuffer()->GetChannel(0),
-               mInput[TheVinylTempoControl->GetRightChannel()-1]->GetBuffer()->GetChannel(0), gBufferSize);
+               mAudioInput[TheVinylTempoControl->GetLeftChannel()-1]->GetBuffer()->GetChannel(0),
+               mAudioInput[TheVinylTempoControl->GetRightChannel()-1]->GetBuffer()->GetChannel(0), gBufferSize);
       }
 
       for (int i=0; i<nChannels; ++i)
       {
-         if (mOutput[i])
-            mOutput[i]->ClearBuffer();
+         if (mAudioOutput[i])
+            mAudioOutput[i]->ClearBuffer();
       }
       
       double elapsed = gInvSampleRateMs * gBufferSize;
@@ -1196,18 +1275,17 @@ void ModularSynth::AudioOut(float** output, int bufferSize, int nChannels)
       TheTransport->Advance(elapsed);
       
       //get audio from sources
-      for (int i=0; i<mSources.size(); ++i)
-         mSources[i]->Process(gTime);
+      mAudioGraph.Process(gTime);
       
       //put it into speakers
       for (int i=0; i<MAX_OUTPUT_CHANNELS; ++i)
          outBuffer[i] = gZeroBuffer;
       for (int i=0; i<nChannels; ++i)
       {
-         if (mOutput[i])
+         if (mAudioOutput[i])
          {
-            mOutput[i]->Process();
-            outBuffer[i] = mOutput[i]->GetBuffer()->GetChannel(0);
+            mAudioOutput[i]->Process();
+            outBuffer[i] = mAudioOutput[i]->GetBuffer()->GetChannel(0);
          }
       }
       
@@ -1237,6 +1315,7 @@ void ModularSynth::AudioOut(float** output, int bufferSize, int nChannels)
    mRecordingLength += bufferSize;
    mRecordingLength = MIN(mRecordingLength, RECORDING_LENGTH);
    
+   mXrunMonitor.EndBlock(bufferSize);
    Profiler::PrintCounters();
 }
 
@@ -1245,15 +1324,17 @@ void ModularSynth::AudioIn(const float** input, int bufferSize, int nChannels)
    if (mAudioPaused)
       return;
    
-   ScopedMutex mutex(&mAudioThreadMutex, "audioIn()");
+   ScopedTryMutex mutex(&mAudioThreadMutex, "audioIn()", gInvSampleRateMs * bufferSize * .5f);
+   if (!mutex.IsLocked())
+      return;
 
    assert(bufferSize == mIOBufferSize);
    assert(nChannels <= MAX_INPUT_CHANNELS);
    
    for (int i=0; i<nChannels; ++i)
    {
-      if (mInput[i])
-         BufferCopy(mInput[i]->GetBuffer()->GetChannel(0), input[i], bufferSize);
+      if (mAudioInput[i])
+         BufferCopy(mAudioInput[i]->GetBuffer()->GetChannel(0), input[i], bufferSize);
    }
 }
 
@@ -1281,13 +1362,6 @@ void ModularSynth::FilesDropped(vector<string> files, int intX, int intY)
    }
 }
 
-struct SourceDepInfo
-{
-   SourceDepInfo(IAudioSource* me) : mMe(me) {}
-   IAudioSource* mMe;
-   vector<IAudioSource*> mDeps;
-};
-
 void ModularSynth::ArrangeAudioSourceDependencies()
 {
    //ofLog() << "Calculating audio source dependencies:";
@@ -1311,6 +1385,51 @@ void ModularSynth::ArrangeAudioSourceDependencies()
       }
    }
    
+   //whether source index "from" already has to wait for source index "on", through any chain of dependencies
+   auto dependsOn = [&deps, this](int from, int on)
+   {
+      vector<bool> visited(deps.size(), false);
+      vector<int> toVisit(1, from);
+      while (!toVisit.empty())
+      {
+         int index = toVisit.back();
+         toVisit.pop_back();
+         if (index == on)
+            return true;
+         if (visited[index])
+            continue;
+         visited[index] = true;
+         for (auto* dep : deps[index].mDeps)
+            toVisit.push_back(int(std::find(mSources.begin(), mSources.end(), dep) - mSources.begin()));
+      }
+      return false;
+   };
+   
+   //a modulator that processes audio (like audiotocv) fills its values in Process(), and the module it modulates reads them
+   //in its own Process(). so that module depends on it, same as an audio cable, and the two never run at the same time.
+   //unless the modulator is already downstream of that module (feeding back into it), then it already runs after it.
+   //modulators that aren't audio sources are followed through to whatever they end up modulating
+   for (int i=0; i<(int)mSources.size(); ++i)
+   {
+      IModulator* modulator = dynamic_cast<IModulator*>(mSources[i]);
+      for (int hops=0; modulator != nullptr && hops < 16; ++hops)   //bounded, modulators can be patched in a loop
+      {
+         FloatSlider* target = modulator->GetSliderTarget();
+         if (target == nullptr)
+            break;
+         IDrawableModule* owner = target->GetModuleParent();
+         auto iter = std::find(mSources.begin(), mSources.end(), dynamic_cast<IAudioSource*>(owner));
+         if (iter != mSources.end())
+         {
+            int j = int(iter - mSources.begin());
+            if (j != i && !dependsOn(i, j))
+               deps[j].mDeps.push_back(mSources[i]);
+            break;
+         }
+         modulator = dynamic_cast<IModulator*>(owner);
+      }
+   }
+   
    /*for (int i=0; i<deps.size(); ++i)
    {
       string depStr;
@@ -1325,7 +1444,8 @@ void ModularSynth::ArrangeAudioSourceDependencies()
    
    //TODO(Ryan) detect circular dependencies
    
-   mSources.clear();
+   vector<IAudioSource*> sources;
+   vector<SourceDepInfo> sortedDeps;
    int loopCount = 0;
    while (deps.size() > 0 && loopCount < 1000) //stupid circular dependency detection, make better
    {
@@ -1335,9 +1455,9 @@ void ModularSynth::ArrangeAudioSourceDependencies()
          for (int j=0; j<deps[i].mDeps.size(); ++j)
          {
             bool found = false;
-            for (int k=0; k<mSources.size(); ++k)
+            for (int k=0; k<sources.size(); ++k)
             {
-               if (deps[i].mDeps[j] == mSources[k])
+               if (deps[i].mDeps[j] == sources[k])
                   found = true;
             }
             if (!found) //has a dep that hasn't been added yet
@@ -1345,7 +1465,8 @@ void ModularSynth::ArrangeAudioSourceDependencies()
          }
          if (!hasDeps)
          {
-            mSources.push_back(deps[i].mMe);
+            sources.push_back(deps[i].mMe);
+            sortedDeps.push_back(deps[i]);
             deps.erase(deps.begin() + i);
             i-=1;
          }
@@ -1357,28 +1478,114 @@ void ModularSynth::ArrangeAudioSourceDependencies()
    {
       ofLog() << "circular dependency detected";
       for (int i=0; i<deps.size(); ++i)
-         mSources.push_back(deps[i].mMe);
+      {
+         sources.push_back(deps[i].mMe);
+         sortedDeps.push_back(deps[i]);
+      }
    }
    
+   mSources = sources;
+   PublishAudioGraph(sortedDeps);
+   
    /*ofLog() << "new ordering:";
    for (int i=0; i<mSources.size(); ++i)
       ofLog() << dynamic_cast<IDrawableModule*>(mSources[i])->Name();*/
 }
 
+void ModularSynth::PublishAudioGraph(const vector<SourceDepInfo>& sortedSources)
+{
+   PublishedAudioGraph graph;
+   graph.mPlan = new AudioGraphScheduler::Plan(sortedSources);
+   graph.mGeneration = mNextAudioGraphGeneration++;
+   mPublishedAudioGraphs.push_back(graph);
+   mXrunMonitor.NoteGraphChanged();
+   
+   AudioThreadCommand command;
+   command.mType = AudioThreadCommand::kSetGraph;
+   command.mPlan = graph.mPlan;
+   command.mGeneration = graph.mGeneration;
+   PostAudioThreadCommand(command);
+}
+
+void ModularSynth::PostAudioThreadCommand(const AudioThreadCommand& command)
+{
+   //ui thread only, the queue has a single producer
+   while (!mAudioThreadCommands.produce(command))
+   {
+      //the audio thread hasn't caught up, or isn't running. make room by applying what's pending ourselves
+      ScopedMutex mutex(&mAudioThreadMutex, "PostAudioThreadCommand()");
+      ApplyAudioThreadCommands();
+   }
+}
+
+void ModularSynth::ApplyAudioThreadCommands()
+{
+   //audio thread, or with mAudioThreadMutex held. doesn't allocate
+   AudioThreadCommand command;
+   while (mAudioThreadCommands.consume(command))
+   {
+      switch (command.mType)
+      {
+         case AudioThreadCommand::kSetGraph:
+            mAudioGraph.SetPlan(command.mPlan);
+            mAppliedAudioGraphGeneration.set(command.mGeneration);
+            break;
+         case AudioThreadCommand::kSetInputChannel:
+            mAudioInput[command.mChannel] = command.mInput;
+            break;
+         case AudioThreadCommand::kSetOutputChannel:
+            mAudioOutput[command.mChannel] = command.mOutput;
+            break;
+      }
+   }
+}
+
+void ModularSynth::FreeRetiredAudioGraphs()
+{
+   //once the audio thread has moved on to a newer plan, the old ones can go.
+   //a worker can be woken late and still be looking at a stage, so wait until they're all idle
+   int appliedGeneration = mAppliedAudioGraphGeneration.get();
+   if (!mAudioGraph.IsIdle())
+      return;
+   
+   while (!mPublishedAudioGraphs.empty() && mPublishedAudioGraphs.front().mGeneration < appliedGeneration)
+   {
+      delete mPublishedAudioGraphs.front().mPlan;
+      mPublishedAudioGraphs.pop_front();
+   }
+}
+
+void ModularSynth::SetNumAudioWorkerThreads(int numThreads)
+{
+   ScopedMutex mutex(&mAudioThreadMutex, "SetNumAudioWorkerThreads()");
+   mAudioGraph.SetNumWorkerThreads(numThreads);
+}
+
 void ModularSynth::ResetLayout()
 {
+   ScopedMutex mutex(&mAudioThreadMutex, "ResetLayout()");
+   
    mModuleContainer.Clear();
    
    for (int i=0; i<mDeletedModules.size(); ++i)
       delete mDeletedModules[i];
    
+   //the audio thread can't run while we hold the lock, so switch it over to an empty graph before it sees anything we just deleted
+   mDeletedModules.clear();
+   mSources.clear();
+   PublishAudioGraph(vector<SourceDepInfo>());
    for (int i=0; i<MAX_INPUT_CHANNELS; ++i)
+   {
       mInput[i] = nullptr;
+      mAudioInput[i] = nullptr;
+   }
    for (int i=0; i<MAX_OUTPUT_CHANNELS; ++i)
+   {
       mOutput[i] = nullptr;
-
-   mDeletedModules.clear();
-   mSources.clear();
+      mAudioOutput[i] = nullptr;
+   }
+   ApplyAudioThreadCommands();
+   
    mLissajousDrawers.clear();
    mMoveModule = nullptr;
    LFOPool::Shutdown();
@@ -1442,6 +1649,11 @@ bool ModularSynth::SetInputChannel(int channel, InputChannel* input)
    if (mInput[channel-1] == nullptr)
    {
       mInput[channel-1] = input;
+      AudioThreadCommand command;
+      command.mType = AudioThreadCommand::kSetInputChannel;
+      command.mChannel = channel-1;
+      command.mInput = input;
+      PostAudioThreadCommand(command);
       return true;
    }
    
@@ -1456,6 +1668,11 @@ bool ModularSynth::SetOutputChannel(int channel, OutputChannel* output)
    if (mOutput[channel-1] == nullptr)
    {
       mOutput[channel-1] = output;
+      AudioThreadCommand command;
+      command.mType = AudioThreadCommand::kSetOutputChannel;
+      command.mChannel = channel-1;
+      command.mOutput = output;
+      PostAudioThreadCommand(command);
       return true;
    }
    
@@ -1616,7 +1833,9 @@ void ModularSynth::OnModuleAdded(IDrawableModule* module)
 {
    IAudioSource* source = dynamic_cast<IAudioSource*>(module);
    if (source)
+   {
       mSources.push_back(source);
+   }
 }
 
 void ModularSynth::AddDynamicModule(IDrawableModule* module)
@@ -1666,7 +1885,7 @@ IUIControl* ModularSynth::FindUIControl(string path)
    return mModuleContainer.FindUIControl(path);
 }
 
-void ModularSynth::GrabSample(ChannelBuffer* data, bool window, int numBars)
+void ModularSynth::GrabSample(const ChannelBuffer* data, bool window, int numBars)
 {
    delete mHeldSample;
    mHeldSample = new Sample();
@@ -1685,8 +1904,8 @@ void ModularSynth::GrabSample(ChannelBuffer* data, bool window, int numBars)
             for (int ch=0; ch<mHeldSample->NumChannels(); ++ch)
             {
                float fade = float(i)/fadeSamples;
-               mHeldSample->Data()->GetChannel(ch)[i] *= fade;
-               mHeldSample->Data()->GetChannel(ch)[length-1-i] *= fade;
+               mHeldSample->EditData()->GetChannel(ch)[i] *= fade;
+               mHeldSample->EditData()->GetChannel(ch)[length-1-i] *= fade;
             }
          }
       }
@@ -1711,6 +1930,9 @@ void ModularSynth::LogEvent(string event, LogEventType type)
       mErrors.push_back(event);
    }
 
+   if (mHeadless)
+      printf("%s\n", event.c_str());
+
    mEvents.push_back(LogEventItem(gTime, event, type));
    if (mEvents.size() > 30)
       mEvents.pop_front();
@@ -1718,10 +1940,8 @@ void ModularSynth::LogEvent(string event, LogEventType type)
 
 IDrawableModule* ModularSynth::DuplicateModule(IDrawableModule* module)
 {
-   {
-      FileStreamOut out(ofToDataPath("tmp").c_str());
-      module->SaveState(out);
-   }
+   FileStreamOut out;
+   module->SaveState(out);
    
    ofxJSONElement layoutData;
    module->SaveLayout(layoutData);
@@ -1740,7 +1960,7 @@ IDrawableModule* ModularSynth::DuplicateModule(IDrawableModule* module)
    newModule->SetName(module->Name()); //temporarily rename to the same as what we duplicated, so we can load state properly
    
    {
-      FileStreamIn in(ofToDataPath("tmp").c_str());
+      FileStreamIn in(out.GetData(), out.GetDataSize());
       mIsLoadingModule = true;
       newModule->LoadState(in);
       mIsLoadingModule = false;
@@ -1804,24 +2024,25 @@ void ModularSynth::LoadStatePopupImp()
 
 void ModularSynth::SaveState(string file)
 {
-   mAudioThreadMutex.Lock("SaveState()");
-   
-   FileStreamOut out(ofToDataPath(file).c_str());
+   FileStreamOut out;   //into memory, so the audio thread isn't held up by the disk
    
+   mAudioThreadMutex.Lock("SaveState()");
    out << GetLayout().getRawString(true);
    mModuleContainer.SaveState(out);
-   
    mAudioThreadMutex.Unlock();
+   
+   if (!out.WriteToFile(ofToDataPath(file).c_str()))
+      LogEvent("couldn't write " + ofToDataPath(file), kLogEventType_Error);
 }
 
-void ModularSynth::LoadState(string file)
+bool ModularSynth::LoadState(string file)
 {
    ofLog() << "LoadState() " << ofToDataPath(file);
 
    if (!juce::File(ofToDataPath(file)).existsAsFile())
    {
       LogEvent("couldn't find file " + ofToDataPath(file), kLogEventType_Error);
-      return;
+      return false;
    }
    
    mAudioThreadMutex.Lock("LoadState()");
@@ -1853,6 +2074,8 @@ void ModularSynth::LoadState(string file)
    mIsLoadingState = false;
    LockRender(false);
    mAudioThreadMutex.Unlock();
+   
+   return layoutLoaded;
 }
 
 IAudioReceiver* ModularSynth::FindAudioReceiver(string name, bool fail)
@@ -1945,7 +2168,38 @@ void ModularSynth::OnConsoleInput()
       }
       else if (tokens[0] == "profiler")
       {
-         Profiler::ToggleProfiler();
+         if (tokens.size() >= 2 && tokens[1] == "trace")
+         {
+            Profiler::StartTraceCapture();
+            ofLog() << "capturing profiler trace";
+         }
+         else if (tokens.size() >= 3 && tokens[1] == "write")
+         {
+            string path = ofToDataPath(tokens[2]);
+            bool written;
+            if (String(path).endsWithIgnoreCase(".csv"))
+               written = Profiler::WriteCSV(path);
+            else
+               written = Profiler::WriteChromeTrace(path);
+            if (written)
+               ofLog() << "wrote " << path;
+            else
+               LogEvent("couldn't write profiler output to " + path, kLogEventType_Error);
+         }
+         else
+         {
+            Profiler::ToggleProfiler();
+         }
+      }
+      else if (tokens[0] == "xruns")
+      {
+         ofLog() << mXrunMonitor.GetSummary();
+      }
+      else if (tokens[0] == "workerthreads")
+      {
+         if (tokens.size() >= 2)
+            SetNumAudioWorkerThreads(atoi(tokens[1].c_str()));
+         ofLog() << "audio worker threads: " << GetNumAudioWorkerThreads();
       }
       else if (tokens[0] == "clear")
       {
@@ -2075,6 +2329,7 @@ IDrawableModule* ModularSynth::SpawnModuleOnTheFly(string moduleName, float x, f
             mModuleContainer.AddModule(module);
          SetUpModule(module, dummy);
          module->Init();
+         ArrangeAudioSourceDependencies();
       }
    }
    catch (LoadingJSONException& e)
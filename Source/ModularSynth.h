@@ -16,6 +16,12 @@
 #include "LocationZoomer.h"
 #include "EffectFactory.h"
 #include "ModuleContainer.h"
+#include "AudioGraphScheduler.h"
+#include "LockFreeQueue.h"
+#include "XrunMonitor.h"
+#include "SampleCache.h"
+#include "SampleLoader.h"
+#include "SampleStream.h"
 #ifdef BESPOKE_LINUX
 #include <climits>
 #endif
@@ -61,6 +67,8 @@ public:
    virtual ~ModularSynth();
    
    void Setup(GlobalManagers* globalManagers, juce::Component* mainComponent);
+   void SetUpHeadless(int sampleRate, int bufferSize);
+   bool IsHeadless() const { return mHeadless; }
    void LoadResources(void* nanoVG, void* fontBoundsNanoVG);
    void Poll();
    void Draw(void* vg);
@@ -91,6 +99,13 @@ public:
    
    void AddMidiDevice(MidiDevice* device);
    void ArrangeAudioSourceDependencies();
+   void SetNumAudioWorkerThreads(int numThreads);
+   int GetNumAudioWorkerThreads() const { return mAudioGraph.GetNumWorkerThreads(); }
+   AudioGraphScheduler& GetAudioGraph() { return mAudioGraph; }
+   SampleCache* GetSampleCache() { return &mSampleCache; }
+   SampleFormat GetDefaultSampleFormat() const { return mDefaultSampleFormat; }
+   SampleLoader* GetSampleLoader() { return &mSampleLoader; }
+   SampleStreamer* GetSampleStreamer() { return &mSampleStreamer; }
    IDrawableModule* SpawnModuleOnTheFly(string moduleName, float x, float y, bool addToContainer = true);
    void SetMoveModule(IDrawableModule* module, float offsetX, float offsetY);
    
@@ -123,7 +138,7 @@ public:
    void AddLissajousDrawer(IDrawableModule* module) { mLissajousDrawers.push_back(module); }
    bool IsLissajousDrawer(IDrawableModule* module) { return VectorContains(module, mLissajousDrawers); }
    
-   void GrabSample(ChannelBuffer* data, bool window = false, int numBars = -1);
+   void GrabSample(const ChannelBuffer* data, bool window = false, int numBars = -1);
    Sample* GetHeldSample() const { return mHeldSample; }
    void ClearHeldSample();
    
@@ -180,7 +195,7 @@ public:
    void SaveLayoutAsPopup();
    void SaveOutput();
    void SaveState(string file);
-   void LoadState(string file);
+   bool LoadState(string file);
    void SaveStatePopup();
    void LoadStatePopup();
 
@@ -200,14 +215,55 @@ private:
    void DeleteAllModules();
    void TriggerClapboard();
    
+   struct AudioThreadCommand
+   {
+      enum Type
+      {
+         kSetGraph,
+         kSetInputChannel,
+         kSetOutputChannel
+      };
+      AudioThreadCommand() : mType(kSetGraph), mPlan(nullptr), mGeneration(0), mChannel(0), mInput(nullptr), mOutput(nullptr) {}
+      Type mType;
+      AudioGraphScheduler::Plan* mPlan;
+      int mGeneration;
+      int mChannel;
+      InputChannel* mInput;
+      OutputChannel* mOutput;
+   };
+   void PublishAudioGraph(const vector<SourceDepInfo>& sortedSources);
+   void PostAudioThreadCommand(const AudioThreadCommand& command);
+   void ApplyAudioThreadCommands();
+   void FreeRetiredAudioGraphs();
+   
    ofSoundStream mSoundStream;
    int mIOBufferSize;
    
+   //graph edits happen on the ui thread, and reach the audio thread through mAudioThreadCommands at the start of a block
    vector<IAudioSource*> mSources;
    InputChannel* mInput[MAX_INPUT_CHANNELS];
    OutputChannel* mOutput[MAX_OUTPUT_CHANNELS];
+   LockFreeRingQueue<AudioThreadCommand, 256, QueueOverflowPolicy::kReport> mAudioThreadCommands;
+   struct PublishedAudioGraph
+   {
+      AudioGraphScheduler::Plan* mPlan;
+      int mGeneration;
+   };
+   std::list<PublishedAudioGraph> mPublishedAudioGraphs;
+   int mNextAudioGraphGeneration;
+   Atomic<int> mAppliedAudioGraphGeneration;
+   
+   //audio thread's copies
+   AudioGraphScheduler mAudioGraph;
+   InputChannel* mAudioInput[MAX_INPUT_CHANNELS];
+   OutputChannel* mAudioOutput[MAX_OUTPUT_CHANNELS];
+   XrunMonitor mXrunMonitor;
    vector<IDrawableModule*> mLissajousDrawers;
    vector<IDrawableModule*> mDeletedModules;
+   SampleCache mSampleCache;   //before the loader, whose threads use it
+   SampleFormat mDefaultSampleFormat;
+   SampleLoader mSampleLoader;
+   SampleStreamer mSampleStreamer;
    
    vector<IDrawableModule*> mModalFocusItemStack;
    
@@ -265,6 +321,7 @@ private:
    
    ofxJSONElement mUserPrefs;
    bool mInitialized;
+   bool mHeadless;
    
    ofRectangle mDrawRect;
    
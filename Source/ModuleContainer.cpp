@@ -485,9 +485,20 @@ ofxJSONElement ModuleContainer::WriteModules()
 
 namespace
 {
-   const int kSaveStateRev = 420;
+   const int kSaveStateRev = 421;
+   const int kLegacySaveStateRev = 420;
+   
+   struct SavedModuleChunk
+   {
+      string mName;
+      int64 mOffset;
+      int64 mSize;
+   };
 }
 
+//each module's state is a chunk, followed by a table of where the chunks are, so a module that fails to load can be skipped
+//by seeking past it instead of scanning for the separator. offsets are from the end of the header, so that the containers
+//saved inside a module's chunk come out the same wherever in the file they end up
 void ModuleContainer::SaveState(FileStreamOut& out)
 {
    out << kSaveStateRev;
@@ -501,25 +512,106 @@ void ModuleContainer::SaveState(FileStreamOut& out)
    
    out << savedModules;
    
+   int64 tocOffsetPosition = out.GetPosition();
+   int64 tocOffset = 0;
+   out << tocOffset;   //filled in once we know it
+   int64 base = out.GetPosition();
+   
+   vector<SavedModuleChunk> chunks;
    for (auto* module : mModules)
    {
       if (module != TheSaveDataPanel && module != TheTitleBar)
       {
          //ofLog() << "Saving " << module->Name();
-         out << string(module->Name());
+         SavedModuleChunk chunk;
+         chunk.mName = module->Name();
+         chunk.mOffset = out.GetPosition() - base;
          module->SaveState(out);
          for (int i=0; i<GetModuleSeparatorLength(); ++i)
-            out << GetModuleSeparator()[i];
+            out << GetModuleSeparator()[i];   //modules still look for this, see DoesModuleHaveMoreSaveData()
+         chunk.mSize = out.GetPosition() - base - chunk.mOffset;
+         chunks.push_back(chunk);
       }
    }
+   
+   tocOffset = out.GetPosition() - base;
+   for (const auto& chunk : chunks)
+   {
+      out << chunk.mName;
+      out << chunk.mOffset;
+      out << chunk.mSize;
+   }
+   
+   out.Patch(tocOffsetPosition, &tocOffset, sizeof(tocOffset));
 }
 
 void ModuleContainer::LoadState(FileStreamIn& in)
 {
    int header;
    in >> header;
+   if (header == kLegacySaveStateRev)
+   {
+      LoadStateLegacy(in);
+      return;
+   }
    assert(header == kSaveStateRev);
    
+   int savedModules;
+   in >> savedModules;
+   int64 tocOffset;
+   in >> tocOffset;
+   int64 base = in.GetPosition();
+   
+   in.Seek(base + tocOffset);
+   vector<SavedModuleChunk> chunks(savedModules);
+   for (auto& chunk : chunks)
+   {
+      in >> chunk.mName;
+      in >> chunk.mOffset;
+      in >> chunk.mSize;
+   }
+   int64 end = in.GetPosition();
+   
+   for (const auto& chunk : chunks)
+   {
+      in.Seek(base + chunk.mOffset);
+      //ofLog() << "Loading " << chunk.mName;
+      IDrawableModule* module = FindModule(chunk.mName, false);
+      if (module == nullptr)
+      {
+         TheSynth->LogEvent("Couldn't find module \""+chunk.mName+"\" to load state for", kLogEventType_Error);
+         continue;
+      }
+      
+      try
+      {
+         module->LoadState(in);
+         
+         char separator[GetModuleSeparatorLength()];
+         in.ReadGeneric(separator, GetModuleSeparatorLength());
+         if (memcmp(separator, GetModuleSeparator(), GetModuleSeparatorLength()) != 0 ||
+             in.GetPosition() != base + chunk.mOffset + chunk.mSize)
+         {
+            ofLog() << "Error loading state for " << module->Name();
+            ofLog() << "Read " + ofToString(in.GetPosition() - base - chunk.mOffset) + " bytes of a " + ofToString(chunk.mSize) + " byte chunk";
+            assert(false);
+         }
+      }
+      catch (LoadStateException& e)
+      {
+         TheSynth->LogEvent("Error loading state for module \""+chunk.mName+"\"", kLogEventType_Error);
+         //the next chunk's offset is in the table, so there's nothing to scan for
+      }
+   }
+   
+   in.Seek(end);
+   
+   for (auto module : mModules)
+      module->PostLoadState();
+}
+
+void ModuleContainer::LoadStateLegacy(FileStreamIn& in)
+{
    int savedModules;
    in >> savedModules;
    
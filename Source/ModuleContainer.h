@@ -67,6 +67,7 @@ public:
    
 private:
    ofVec2f GetOwnerPosition() const;
+   void LoadStateLegacy(FileStreamIn& in);   //rev 420, before modules were saved as chunks
    
    vector<IDrawableModule*> mModules;
    IDrawableModule* mOwner;
@@ -8,23 +8,67 @@
 
 #include "NamedMutex.h"
 
-void NamedMutex::Lock(string locker)
+namespace
 {
-   if (mLocker == locker)
+   const int kSpinCount = 100;
+}
+
+bool NamedMutex::TryAcquire(Thread::ThreadID thread)
+{
+   return mOwner.compareAndSetBool(thread, nullptr);
+}
+
+void NamedMutex::Lock(const char* locker)
+{
+   Thread::ThreadID thisThread = Thread::getCurrentThreadId();
+   if (mOwner.get() == thisThread)
    {
       ++mExtraLockCount;
       return;
    }
-   mMutex.lock();
+
+   int spins = 0;
+   while (!TryAcquire(thisThread))
+   {
+      if (++spins < kSpinCount)
+         continue;
+
+      //held for a while, sleep until it's released. the timeout covers a release that slips in before we wait
+      ++mNumWaiters;
+      if (mOwner.get() != nullptr)
+         mUnlockedEvent.wait(1);
+      --mNumWaiters;
+   }
+
    mLocker = locker;
 }
 
+bool NamedMutex::TryLock(const char* locker)
+{
+   Thread::ThreadID thisThread = Thread::getCurrentThreadId();
+   if (mOwner.get() == thisThread)
+   {
+      ++mExtraLockCount;
+      return true;
+   }
+
+   if (!TryAcquire(thisThread))
+      return false;
+
+   mLocker = locker;
+   return true;
+}
+
 void NamedMutex::Unlock()
 {
+   assert(mOwner.get() == Thread::getCurrentThreadId());
+
    if (mExtraLockCount == 0)
    {
       mLocker = "<none>";
-      mMutex.unlock();
+      mOwner.set(nullptr);
+      if (mNumWaiters.get() > 0)
+         mUnlockedEvent.signal();
    }
    else
    {
@@ -32,7 +76,7 @@ void NamedMutex::Unlock()
    }
 }
 
-ScopedMutex::ScopedMutex(NamedMutex* mutex, string locker)
+ScopedMutex::ScopedMutex(NamedMutex* mutex, const char* locker)
 : mMutex(mutex)
 {
    mMutex->Lock(locker);
@@ -41,4 +85,25 @@ ScopedMutex::ScopedMutex(NamedMutex* mutex, string locker)
 ScopedMutex::~ScopedMutex()
 {
    mMutex->Unlock();
-}
\ No newline at end of file
+}
+
+ScopedTryMutex::ScopedTryMutex(NamedMutex* mutex, const char* locker, double timeoutMs)
+: mMutex(mutex)
+{
+   mLocked = mMutex->TryLock(locker);
+   if (!mLocked)
+   {
+      double giveUpTime = Time::getMillisecondCounterHiRes() + timeoutMs;
+      while (!mLocked && Time::getMillisecondCounterHiRes() < giveUpTime)
+      {
+         Thread::yield();
+         mLocked = mMutex->TryLock(locker);
+      }
+   }
+}
+
+ScopedTryMutex::~ScopedTryMutex()
+{
+   if (mLocked)
+      mMutex->Unlock();
+}
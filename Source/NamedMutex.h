@@ -11,25 +11,46 @@
 
 #include "OpenFrameworksPort.h"
 
+//recursive mutex that remembers who is holding it, for debugging.
+//locking and unlocking don't allocate, and an uncontended lock is a single compare-and-swap,
+//so the audio thread can use TryLock() without ever blocking in the kernel.
 class NamedMutex
 {
 public:
-   NamedMutex() : mLocker("<none>"), mExtraLockCount(0) {}
-   void Lock(string locker);
+   NamedMutex() : mOwner(nullptr), mLocker("<none>"), mExtraLockCount(0), mNumWaiters(0) {}
+   void Lock(const char* locker);
+   bool TryLock(const char* locker);
    void Unlock();
+   const char* GetLocker() const { return mLocker; }
 private:
-   ofMutex mMutex;
-   string mLocker;
+   bool TryAcquire(Thread::ThreadID thread);
+
+   Atomic<Thread::ThreadID> mOwner;
+   const char* mLocker;
    int mExtraLockCount;
+   Atomic<int> mNumWaiters;
+   WaitableEvent mUnlockedEvent;
 };
 
 class ScopedMutex
 {
 public:
-   ScopedMutex(NamedMutex* mutex, string locker);
+   ScopedMutex(NamedMutex* mutex, const char* locker);
    ~ScopedMutex();
 private:
    NamedMutex* mMutex;
 };
 
+//for the audio thread: spins for up to timeoutMs trying to get the lock, then gives up rather than stalling
+class ScopedTryMutex
+{
+public:
+   ScopedTryMutex(NamedMutex* mutex, const char* locker, double timeoutMs);
+   ~ScopedTryMutex();
+   bool IsLocked() const { return mLocked; }
+private:
+   NamedMutex* mMutex;
+   bool mLocked;
+};
+
 #endif /* defined(__modularSynth__NamedMutex__) */
@@ -7,6 +7,7 @@
 //
 
 #include "Oscillator.h"
+#include "OscillatorKernels.h"
 
 float Oscillator::Value(float phase) const
 {
@@ -22,13 +23,13 @@ float Oscillator::Value(float phase) const
          phase = (phase - shufflePoint) / (1-mShuffle);
    }
    
-   phase = fmod(phase, FTWO_PI);
+   phase -= floorf(phase / FTWO_PI) * FTWO_PI;
    
    float sample;
    switch (mType)
    {
       case kOsc_Sin:
-         sample = sin(phase);
+         sample = FastSin(phase);
          break;
       case kOsc_Saw:
          sample = SawSample(phase);
@@ -67,6 +68,36 @@ float Oscillator::Value(float phase) const
    return sample;
 }
 
+void Oscillator::Process(const float* phases, const float* phaseIncs, float* out, int bufferSize) const
+{
+   if (IsPlainShape() && mType == kOsc_Sin)
+   {
+      FastSinBlock(phases, out, bufferSize);
+   }
+   else if (IsPlainShape() && BandLimitedWavetable::Supports(mType))
+   {
+      const BandLimitedWavetable& table = BandLimitedWavetable::Get(mType);
+      float lastInc = -1;
+      int level = 0;
+      for (int i=0; i<bufferSize; ++i)
+      {
+         if (phaseIncs[i] != lastInc)
+         {
+            lastInc = phaseIncs[i];
+            level = table.GetLevel(phaseIncs[i] / FTWO_PI);
+         }
+         float cycles = phases[i] / FTWO_PI;
+         cycles -= floorf(cycles);
+         out[i] = table.Sample((uint32_t)(int64_t)(cycles * 4294967296.0), level);
+      }
+   }
+   else
+   {
+      for (int i=0; i<bufferSize; ++i)
+         out[i] = Value(phases[i]);
+   }
+}
+
 float Oscillator::SawSample(float phase) const
 {
    phase /= FTWO_PI;
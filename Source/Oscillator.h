@@ -21,6 +21,9 @@ public:
    OscillatorType GetType() const { return mType; }
    void SetType(OscillatorType type) { mType = type; }
    float Value(float phase) const;
+   //Value() for a block: phases[i] as Value() takes them, phaseIncs[i] the radians per sample they advance by.
+   //plain sin/saw/square/tri shapes come from the oscillator kernels (band-limited), anything else goes through Value()
+   void Process(const float* phases, const float* phaseIncs, float* out, int bufferSize) const;
    float GetPulseWidth() const { return mPulseWidth; }
    void SetPulseWidth(float width) { mPulseWidth = width; }
    float GetShuffle() const { return mShuffle; }
@@ -30,6 +33,7 @@ public:
    OscillatorType mType;
 private:
    float SawSample(float phase) const;
+   bool IsPlainShape() const { return mPulseWidth == .5f && mShuffle == 0 && mSoften == 0; }
    
    float mPulseWidth;
    float mShuffle;
@@ -0,0 +1,211 @@
+/*
+  ==============================================================================
+
+    OscillatorKernels.cpp
+    Created: 17 Oct 2026 7:05:37pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "OscillatorKernels.h"
+#include "Float4.h"
+#include "FFT.h"
+#include "ScratchArena.h"
+
+namespace
+{
+   const float kInvTwoPi = 1.0f / FTWO_PI;
+   const int kFracBits = 32 - BandLimitedWavetable::kTableBits;
+   const float kInvFracRange = 1.0f / (1 << kFracBits);
+
+   //same polynomial as Float4::Sin, for x in [-pi, pi]
+   inline float SinPoly(float x)
+   {
+      if (x > FPI * .5f)
+         x = FPI - x;
+      else if (x < -FPI * .5f)
+         x = -FPI - x;
+      float x2 = x * x;
+      float poly = 2.7557319e-6f;
+      poly = poly * x2 - 1.98412698e-4f;
+      poly = poly * x2 + 8.33333333e-3f;
+      poly = poly * x2 - 1.66666667e-1f;
+      poly = poly * x2 + 1;
+      return poly * x;
+   }
+
+   inline Float4 WrapToPi(Float4 phase)
+   {
+      const Float4 twoPi = Float4::Set(FTWO_PI);
+      Float4 cycles = Float4::Floor((phase + Float4::Set(FPI)) * Float4::Set(kInvTwoPi));
+      return phase - cycles * twoPi;
+   }
+
+   inline uint32_t CyclesToFixed(double cycles)
+   {
+      return (uint32_t)(int64_t)(cycles * 4294967296.0);
+   }
+}
+
+float FastSin(float phase)
+{
+   phase -= floorf((phase + FPI) * kInvTwoPi) * FTWO_PI;
+   return SinPoly(phase);
+}
+
+void FastSinBlock(const float* phases, float* out, int bufferSize)
+{
+   int i = 0;
+   for (; i+4<=bufferSize; i+=4)
+      Float4::Sin(WrapToPi(Float4::Load(phases + i))).Store(out + i);
+   for (; i<bufferSize; ++i)
+      out[i] = FastSin(phases[i]);
+}
+
+void PhaseAccumulator::Process(const float* freqs, float freqScale, float* phases, int bufferSize)
+{
+   double cyclesPerHz = double(freqScale) / gSampleRate;
+   uint32_t phase = mPhase;
+   for (int i=0; i<bufferSize; ++i)
+   {
+      phase += CyclesToFixed(freqs[i] * cyclesPerHz);
+      phases[i] = ToRadians(phase);
+   }
+   mPhase = phase;
+}
+
+void PhaseAccumulator::Process(const float* freqs, float freqScale, uint32_t* phases, int bufferSize)
+{
+   double cyclesPerHz = double(freqScale) / gSampleRate;
+   uint32_t phase = mPhase;
+   for (int i=0; i<bufferSize; ++i)
+   {
+      phase += CyclesToFixed(freqs[i] * cyclesPerHz);
+      phases[i] = phase;
+   }
+   mPhase = phase;
+}
+
+void PhaseAccumulator::Advance(float freqSum, float freqScale)
+{
+   double cycles = double(freqSum) * freqScale / gSampleRate;
+   mPhase += CyclesToFixed(cycles - floor(cycles));
+}
+
+void RenderSine(PhaseAccumulator& phase, const float* freqs, float freqScale, float* out, int bufferSize)
+{
+   //phases come back already in [-pi, pi), so they can go straight into the polynomial
+   phase.Process(freqs, freqScale, out, bufferSize);
+   int i = 0;
+   for (; i+4<=bufferSize; i+=4)
+      Float4::Sin(Float4::Load(out + i)).Store(out + i);
+   for (; i<bufferSize; ++i)
+      out[i] = SinPoly(out[i]);
+}
+
+//static
+const BandLimitedWavetable& BandLimitedWavetable::Get(OscillatorType type)
+{
+   static const BandLimitedWavetable sSaw(kOsc_Saw);
+   static const BandLimitedWavetable sNegSaw(kOsc_NegSaw);
+   static const BandLimitedWavetable sSquare(kOsc_Square);
+   static const BandLimitedWavetable sTri(kOsc_Tri);
+
+   assert(Supports(type));
+   if (type == kOsc_NegSaw)
+      return sNegSaw;
+   if (type == kOsc_Square)
+      return sSquare;
+   if (type == kOsc_Tri)
+      return sTri;
+   return sSaw;
+}
+
+//static
+bool BandLimitedWavetable::Supports(OscillatorType type)
+{
+   return type == kOsc_Saw || type == kOsc_NegSaw || type == kOsc_Square || type == kOsc_Tri;
+}
+
+BandLimitedWavetable::BandLimitedWavetable(OscillatorType type)
+{
+   //build each level from its fourier series with an inverse FFT.
+   //in ::FFT's layout a sine partial of amplitude a is +a/2 in the imaginary part of its bin, a cosine is a/2 in the real part
+   FFT fft(kTableSize);
+   std::vector<float> real(kTableSize/2+1);
+   std::vector<float> imag(kTableSize/2+1);
+
+   for (int level=0; level<kNumLevels; ++level)
+   {
+      int numHarmonics = (kTableSize/4) >> level;
+      std::fill(real.begin(), real.end(), 0.0f);
+      std::fill(imag.begin(), imag.end(), 0.0f);
+
+      for (int h=1; h<=numHarmonics; ++h)
+      {
+         switch (type)
+         {
+            case kOsc_Saw:    //rising ramp, -2/pi * sum(sin(hx)/h)
+               imag[h-1] = -1 / (FPI * h);
+               break;
+            case kOsc_NegSaw:
+               imag[h-1] = 1 / (FPI * h);
+               break;
+            case kOsc_Square: //4/pi * sum over odd h of sin(hx)/h
+               if (h % 2 == 1)
+                  imag[h-1] = 2 / (FPI * h);
+               break;
+            case kOsc_Tri:    //starts at the top, 8/pi^2 * sum over odd h of cos(hx)/h^2
+               if (h % 2 == 1)
+                  real[h] = 4 / (FPI * FPI * h * h);
+               break;
+            default:
+               break;
+         }
+      }
+
+      mTables[level].resize(kTableSize+1);
+      fft.Inverse(real.data(), imag.data(), mTables[level].data());
+      mTables[level][kTableSize] = mTables[level][0];
+   }
+}
+
+int BandLimitedWavetable::GetLevel(float cyclesPerSample) const
+{
+   //richest level whose top harmonic stays under nyquist: (kTableSize/4 >> level) * cyclesPerSample <= .5
+   float x = fabsf(cyclesPerSample) * (kTableSize/2);
+   if (x <= 1)
+      return 0;
+   int exponent;
+   float mantissa = frexpf(x, &exponent);
+   int level = (mantissa > .5f) ? exponent : exponent - 1;
+   return MIN(level, kNumLevels - 1);
+}
+
+float BandLimitedWavetable::Sample(uint32_t phase, int level) const
+{
+   const float* table = mTables[level].data();
+   uint32_t index = phase >> kFracBits;
+   float frac = (phase & ((1u << kFracBits) - 1)) * kInvFracRange;
+   return table[index] + (table[index+1] - table[index]) * frac;
+}
+
+void BandLimitedWavetable::Render(PhaseAccumulator& phase, const float* freqs, float freqScale, float* out, int bufferSize) const
+{
+   ScratchArena::Scope scratch;
+   uint32_t* phases = (uint32_t*)scratch.GetBuffer();
+   phase.Process(freqs, freqScale, phases, bufferSize);
+
+   float lastFreq = -1;
+   int level = 0;
+   for (int i=0; i<bufferSize; ++i)
+   {
+      if (freqs[i] != lastFreq)
+      {
+         lastFreq = freqs[i];
+         level = GetLevel(freqs[i] * freqScale / gSampleRate);
+      }
+      out[i] = Sample(phases[i], level);
+   }
+}
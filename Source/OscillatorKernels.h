@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    OscillatorKernels.h
+    Created: 17 Oct 2026 7:05:37pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SynthGlobals.h"
+#include <vector>
+
+//building blocks for oscillators that render a block at a time:
+//a fast polynomial sine, a fixed-point phase accumulator, and band-limited wavetables mip-mapped by pitch.
+
+//sin() for any phase in radians, good to a few parts per million
+float FastSin(float phase);
+//out[i] = FastSin(phases[i])
+void FastSinBlock(const float* phases, float* out, int bufferSize);
+
+//phase kept as a 32 bit fraction of a cycle, so it wraps for free and keeps its precision however long it runs
+class PhaseAccumulator
+{
+public:
+   PhaseAccumulator() : mPhase(0) {}
+
+   void Reset() { mPhase = 0; }
+   uint32_t GetPhase() const { return mPhase; }
+   void SetPhase(uint32_t phase) { mPhase = phase; }
+
+   //steps once per sample at freqs[i] * freqScale hz. writes the phase each sample lands on, in radians [-pi, pi)
+   void Process(const float* freqs, float freqScale, float* phases, int bufferSize);
+   //same, writing the raw fixed-point phases for table lookups
+   void Process(const float* freqs, float freqScale, uint32_t* phases, int bufferSize);
+   //skips ahead as Process() would over a block whose freqs add up to freqSum
+   void Advance(float freqSum, float freqScale);
+
+   static float ToRadians(uint32_t phase) { return int32_t(phase) * (FPI / 2147483648.0f); }
+
+private:
+   uint32_t mPhase;
+};
+
+//sine partial at freqs[i] * freqScale hz, written into out
+void RenderSine(PhaseAccumulator& phase, const float* freqs, float freqScale, float* out, int bufferSize);
+
+//one cycle of a waveform at a series of harmonic counts, one table per octave.
+//playing a pitch picks the richest table whose top harmonic is still below nyquist, so nothing aliases.
+//tables are built on first use, from the same spectrum the naive Oscillator shapes have.
+class BandLimitedWavetable
+{
+public:
+   //kOsc_Saw, kOsc_NegSaw, kOsc_Square or kOsc_Tri
+   static const BandLimitedWavetable& Get(OscillatorType type);
+   static bool Supports(OscillatorType type);
+
+   //table to use for a fundamental of this many cycles per sample
+   int GetLevel(float cyclesPerSample) const;
+   float Sample(uint32_t phase, int level) const;
+
+   //waveform at freqs[i] * freqScale hz, written into out
+   void Render(PhaseAccumulator& phase, const float* freqs, float freqScale, float* out, int bufferSize) const;
+
+   static const int kTableBits = 12;
+   static const int kTableSize = 1 << kTableBits;
+   static const int kNumLevels = kTableBits - 1;   //kTableSize/4 harmonics at the top level, halving down to one
+
+private:
+   BandLimitedWavetable(OscillatorType type);
+
+   std::vector<float> mTables[kNumLevels];   //kTableSize+1 each, the extra sample wraps around for interpolation
+};
@@ -12,6 +12,7 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 #include "PatchCableSource.h"
+#include "ScratchArena.h"
 
 Panner::Panner()
 : IAudioProcessor(gBufferSize)
@@ -44,11 +45,13 @@ void Panner::Process(double time)
    SyncBuffers(2);
    mWidenerBuffer.SetNumChannels(2);
    
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
    float* secondChannel;
    if (GetBuffer()->NumActiveChannels() == 1)   //panning mono input
    {
-      BufferCopy(gWorkBuffer, GetBuffer()->GetChannel(0), GetBuffer()->BufferSize());
-      secondChannel = gWorkBuffer;
+      BufferCopy(workBuffer, GetBuffer()->GetChannel(0), GetBuffer()->BufferSize());
+      secondChannel = workBuffer;
    }
    else
    {
@@ -10,7 +10,7 @@
 #include "SynthGlobals.h"
 
 TimerInstance::TimerInstance(string name, PerformanceTimer& manager)
-: mName(name)
+: mName(std::move(name))
 , mManager(manager)
 {
    mTimerStart = ofGetSystemTimeNanos();
@@ -21,7 +21,7 @@ TimerInstance::~TimerInstance()
    mManager.RecordCost(mName, ofGetSystemTimeNanos() - mTimerStart);
 }
 
-void PerformanceTimer::RecordCost(string name, long cost)
+void PerformanceTimer::RecordCost(const string& name, long cost)
 {
    mCostTable.push_back(PerformanceTimer::Cost(name,cost));
 }
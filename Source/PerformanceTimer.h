@@ -27,12 +27,12 @@ private:
 class PerformanceTimer
 {
 public:
-   void RecordCost(string name, long cost);
+   void RecordCost(const string& name, long cost);
    void PrintCosts();
 private:
    struct Cost
    {
-      Cost(string name, long cost) : mName(name), mCost(cost) {}
+      Cost(const string& name, long cost) : mName(name), mCost(cost) {}
       string mName;
       long mCost;
    };
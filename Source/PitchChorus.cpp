@@ -10,6 +10,7 @@
 #include "Profiler.h"
 #include "Scale.h"
 #include "SynthGlobals.h"
+#include "ScratchArena.h"
 
 PitchChorus::PitchChorus()
 : IAudioProcessor(gBufferSize)
@@ -44,17 +45,19 @@ void PitchChorus::Process(double time)
    int bufferSize = GetBuffer()->BufferSize();
    if (GetTarget())
    {
+      ScratchArena::Scope scratch;
+      float* workBuffer = scratch.GetBuffer();
       Clear(mOutputBuffer, gBufferSize);
       for (int i=0; i<kNumShifters; ++i)
       {
          if (mShifters[i].mOn || mShifters[i].mRamp.Value(time) > 0)
          {
-            BufferCopy(gWorkBuffer, GetBuffer()->GetChannel(0), bufferSize);
-            mShifters[i].mShifter.Process(gWorkBuffer, bufferSize);
+            BufferCopy(workBuffer, GetBuffer()->GetChannel(0), bufferSize);
+            mShifters[i].mShifter.Process(workBuffer, bufferSize);
             double timeCopy = time;
             for (int j=0; j<bufferSize; ++j)
             {
-               mOutputBuffer[j] += gWorkBuffer[j] * mShifters[i].mRamp.Value(timeCopy);
+               mOutputBuffer[j] += workBuffer[j] * mShifters[i].mRamp.Value(timeCopy);
                timeCopy += gInvSampleRateMs;
             }
          }
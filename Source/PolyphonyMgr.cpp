@@ -14,67 +14,192 @@
 #include "SampleVoice.h"
 #include "SynthGlobals.h"
 #include "Profiler.h"
+#include "ModularSynth.h"
 
 PolyphonyMgr::PolyphonyMgr(IDrawableModule* owner)
-   : mAllowStealing(true)
-   , mLastVoice(-1)
+   : mFreeHead(-1)
+   , mFreeTail(-1)
+   , mVoiceType(kVoiceType_SingleOscillator)
+   , mVoiceParams(nullptr)
+   , mAllowStealing(true)
    , mFadeOutBufferPos(0)
    , mOwner(owner)
    , mFadeOutBuffer(kVoiceFadeSamples)
    , mFadeOutWorkBuffer(kVoiceFadeSamples)
    , mVoiceLimit(kNumVoices)
 {
+   mRenderJob.mOwner = this;
 }
 
 PolyphonyMgr::~PolyphonyMgr()
 {
-   for (int i=0; i<kNumVoices; ++i)
+   for (int i=0; i<(int)mVoices.size(); ++i)
+   {
       delete mVoices[i].mVoice;
+      delete mVoiceOutputs[i];
+   }
 }
 
 void PolyphonyMgr::Init(VoiceType type, IVoiceParams* params)
 {
-   if (type == kVoiceType_FM)
+   mVoiceType = type;
+   mVoiceParams = params;
+   SetPoolSize(kNumVoices);
+}
+
+IMidiVoice* PolyphonyMgr::CreateVoice() const
+{
+   IMidiVoice* voice = nullptr;
+   if (mVoiceType == kVoiceType_FM)
+      voice = new FMVoice(mOwner);
+   else if (mVoiceType == kVoiceType_Karplus)
+      voice = new KarplusStrongVoice(mOwner);
+   else if (mVoiceType == kVoiceType_SingleOscillator)
+      voice = new SingleOscillatorVoice(mOwner);
+   else if (mVoiceType == kVoiceType_Sampler)
+      voice = new SampleVoice(mOwner);
+   else
+      assert(false);  //unsupported voice type
+   
+   if (voice)
+      voice->SetVoiceParams(mVoiceParams);
+   return voice;
+}
+
+void PolyphonyMgr::SetPoolSize(int size)
+{
+   size = CLAMP(size, 1, kMaxVoicePoolSize);
+   if (size <= (int)mVoices.size())
+      return;
+   
+   //build the new voices before taking the lock, so the audio thread only waits for the swap
+   vector<IMidiVoice*> newVoices;
+   vector<ChannelBuffer*> newOutputs;
+   for (int i=(int)mVoices.size(); i<size; ++i)
    {
-      for (int i=0; i<kNumVoices; ++i)
-      {
-         mVoices[i].mVoice = new FMVoice(mOwner);
-         mVoices[i].mVoice->SetVoiceParams(params);
-      }
+      newVoices.push_back(CreateVoice());
+      ChannelBuffer* output = new ChannelBuffer(gBufferSize);
+      //allocate both channels now, rather than on a worker thread the first time a stereo voice renders
+      output->SetNumActiveChannels(ChannelBuffer::kMaxNumChannels);
+      for (int ch=0; ch<ChannelBuffer::kMaxNumChannels; ++ch)
+         output->GetChannel(ch);
+      newOutputs.push_back(output);
    }
-   else if (type == kVoiceType_Karplus)
+   
+   ScopedMutex mutex(TheSynth->GetAudioMutex(), "PolyphonyMgr::SetPoolSize()");
+   for (int i=0; i<(int)newVoices.size(); ++i)
    {
-      for (int i=0; i<kNumVoices; ++i)
-      {
-         mVoices[i].mVoice = new KarplusStrongVoice(mOwner);
-         mVoices[i].mVoice->SetVoiceParams(params);
-      }
+      VoiceInfo info;
+      info.mVoice = newVoices[i];
+      mVoices.push_back(info);
+      mVoiceOutputs.push_back(newOutputs[i]);
    }
-   else if (type == kVoiceType_SingleOscillator)
+   mActiveVoices.reserve(size);
+   RebuildFreeList();
+}
+
+void PolyphonyMgr::SetVoiceLimit(int limit)
+{
+   limit = CLAMP(limit, 1, kMaxVoicePoolSize);
+   SetPoolSize(limit);
+   
+   ScopedMutex mutex(TheSynth->GetAudioMutex(), "PolyphonyMgr::SetVoiceLimit()");
+   mVoiceLimit = limit;
+   for (int i=mVoiceLimit; i<(int)mVoices.size(); ++i)   //voices past the limit don't get processed, so don't leave notes hanging on them
    {
-      for (int i=0; i<kNumVoices; ++i)
-      {
-         mVoices[i].mVoice = new SingleOscillatorVoice(mOwner);
-         mVoices[i].mVoice->SetVoiceParams(params);
-      }
+      mVoices[i].mVoice->ClearVoice();
+      mVoices[i].mPitch = -1;
+      mVoices[i].mNoteOn = false;
    }
-   else if (type == kVoiceType_Sampler)
+   RebuildFreeList();
+}
+
+void PolyphonyMgr::RebuildFreeList()
+{
+   mFreeHead = -1;
+   mFreeTail = -1;
+   for (int i=0; i<(int)mVoices.size(); ++i)
    {
-      for (int i=0; i<kNumVoices; ++i)
-      {
-         mVoices[i].mVoice = new SampleVoice(mOwner);
-         mVoices[i].mVoice->SetVoiceParams(params);
-      }
+      mVoices[i].mFree = false;
+      if (i < mVoiceLimit && mVoices[i].mPitch == -1)
+         PushFreeVoice(i);
    }
+}
+
+void PolyphonyMgr::PushFreeVoice(int index)
+{
+   VoiceInfo& voice = mVoices[index];
+   assert(!voice.mFree);
+   voice.mFree = true;
+   voice.mPrevFree = mFreeTail;
+   voice.mNextFree = -1;
+   if (mFreeTail != -1)
+      mVoices[mFreeTail].mNextFree = index;
+   else
+      mFreeHead = index;
+   mFreeTail = index;
+}
+
+void PolyphonyMgr::RemoveFreeVoice(int index)
+{
+   VoiceInfo& voice = mVoices[index];
+   assert(voice.mFree);
+   if (voice.mPrevFree != -1)
+      mVoices[voice.mPrevFree].mNextFree = voice.mNextFree;
    else
+      mFreeHead = voice.mNextFree;
+   if (voice.mNextFree != -1)
+      mVoices[voice.mNextFree].mPrevFree = voice.mPrevFree;
+   else
+      mFreeTail = voice.mPrevFree;
+   voice.mFree = false;
+   voice.mPrevFree = -1;
+   voice.mNextFree = -1;
+}
+
+int PolyphonyMgr::PopFreeVoice()
+{
+   int index = mFreeHead;
+   if (index != -1)
+      RemoveFreeVoice(index);
+   return index;
+}
+
+void PolyphonyMgr::FreeVoice(int index)
+{
+   mVoices[index].mPitch = -1;
+   if (index < mVoiceLimit && !mVoices[index].mFree)
+      PushFreeVoice(index);
+}
+
+int PolyphonyMgr::ChooseVoiceToSteal(double time)
+{
+   //take the quietest of the voices that have been released, otherwise the oldest held note
+   int quietest = -1;
+   float quietestLevel = 0;
+   int oldest = -1;
+   for (int i=0; i<mVoiceLimit; ++i)
    {
-      assert(false);  //unsupported voice type
+      if (!mVoices[i].mNoteOn)
+      {
+         float level = mVoices[i].mVoice->GetLevel(time);
+         if (quietest == -1 || level < quietestLevel)
+         {
+            quietest = i;
+            quietestLevel = level;
+         }
+      }
+      else if (oldest == -1 || mVoices[i].mTime < mVoices[oldest].mTime)
+      {
+         oldest = i;
+      }
    }
+   return quietest != -1 ? quietest : oldest;
 }
 
 void PolyphonyMgr::Start(double time, int pitch, float amount, int voiceIdx, ModulationParameters modulation)
 {
-   assert(voiceIdx < kNumVoices);
+   assert(voiceIdx < (int)mVoices.size());
    
    amount = amount * amount; //increase the importance of velocity
    
@@ -95,40 +220,19 @@ void PolyphonyMgr::Start(double time, int pitch, float amount, int voiceIdx, Mod
    }*/
    
    if (voiceIdx == -1) //need a new voice
-   {
-      for (int i=0; i<mVoiceLimit; ++i)
-      {
-         int check = (i + mLastVoice + 1) % mVoiceLimit;  //try to keep incrementing through list to allow old voices to finish
-         if (mVoices[check].mPitch == -1)
-         {
-            voiceIdx = check;
-            break;
-         }
-      }
-   }
+      voiceIdx = PopFreeVoice();
 
    if (voiceIdx == -1)   //all used
    {
       if (mAllowStealing)
-      {
-         double oldest = mVoices[0].mTime;
-         int oldestIndex = 0;
-         for (int i=1; i<mVoiceLimit; ++i)
-         {
-            if (mVoices[i].mTime < oldest)
-            {
-               oldest = mVoices[i].mTime;
-               oldestIndex = i;
-            }
-         }
-         voiceIdx = oldestIndex;
-      }
-      else
-      {
+         voiceIdx = ChooseVoiceToSteal(time);
+      if (voiceIdx == -1)
          return;
-      }
    }
    
+   if (mVoices[voiceIdx].mFree)
+      RemoveFreeVoice(voiceIdx);
+   
    IMidiVoice* voice = mVoices[voiceIdx].mVoice;
    assert(voice);
    if (!voice->IsDone(time) && (!preserveVoice || modulation.pan != voice->GetPan()))
@@ -148,21 +252,23 @@ void PolyphonyMgr::Start(double time, int pitch, float amount, int voiceIdx, Mod
    voice->SetModulators(modulation);
    voice->Start(time, amount);
    voice->SetPan(modulation.pan);
-   mLastVoice = voiceIdx;
    
    mVoices[voiceIdx].mPitch = pitch;
    mVoices[voiceIdx].mTime = time;
    mVoices[voiceIdx].mNoteOn = true;
+   mVoices[voiceIdx].mRunning = true;
+   mVoices[voiceIdx].mRendered = false;
 }
 
 void PolyphonyMgr::Stop(double time, int pitch)
 {
-   for (int i=0; i<kNumVoices; ++i)
+   for (int i=0; i<(int)mVoices.size(); ++i)
    {
       if (mVoices[i].mPitch == pitch && mVoices[i].mNoteOn)
       {
          mVoices[i].mVoice->Stop(time);
          mVoices[i].mNoteOn = false;
+         mVoices[i].mStopTime = time;
       }
    }
 }
@@ -174,12 +280,59 @@ void PolyphonyMgr::Process(double time, ChannelBuffer* out, int bufferSize)
    mFadeOutBuffer.SetNumActiveChannels(out->NumActiveChannels());
    mFadeOutWorkBuffer.SetNumActiveChannels(out->NumActiveChannels());
 
+   //only voices that hold a note get rendered. released voices that have faded below hearing are freed without rendering them
+   mActiveVoices.clear();
    for (int i=0; i<mVoiceLimit; ++i)
    {
-      mVoices[i].mVoice->Process(time, out);
+      VoiceInfo& voice = mVoices[i];
+      if (voice.mPitch == -1)
+         continue;
       
-      if (mVoices[i].mPitch != -1 && !mVoices[i].mNoteOn && mVoices[i].mVoice->IsDone(time))
-         mVoices[i].mPitch = -1;
+      //a note that starts and stops within this block hasn't made a sound yet, and its envelope is still at zero at the
+      //start of the block. so only cull voices that have rendered, and only look at the level once the release is under way
+      if (voice.mRendered && !voice.mNoteOn && time >= voice.mStopTime && voice.mVoice->GetLevel(time) < kSilentVoiceLevel)
+      {
+         voice.mVoice->ClearVoice();
+         FreeVoice(i);
+         continue;
+      }
+      
+      mActiveVoices.push_back(i);
+   }
+   int numActiveVoices = (int)mActiveVoices.size();
+   
+   if (ShouldRenderInParallel(numActiveVoices, out))
+   {
+      mRenderJob.mTime = time;
+      mRenderJob.mNumChannels = out->NumActiveChannels();
+      mOwner->SetModulatedSlidersFrozen(true);
+      TheSynth->GetAudioGraph().RunParallel(&mRenderJob, numActiveVoices);
+      mOwner->SetModulatedSlidersFrozen(false);
+      
+      //mix down in voice order, so the result is the same whichever threads did the rendering
+      for (int j=0; j<numActiveVoices; ++j)
+      {
+         int i = mActiveVoices[j];
+         for (int ch=0; ch<out->NumActiveChannels(); ++ch)
+            Add(out->GetChannel(ch), mVoiceOutputs[i]->GetChannel(ch), bufferSize);
+      }
+   }
+   else
+   {
+      for (int j=0; j<numActiveVoices; ++j)
+      {
+         VoiceInfo& voice = mVoices[mActiveVoices[j]];
+         voice.mRunning = voice.mVoice->Process(time, out);
+      }
+   }
+   
+   //a voice that reports its envelope finished during this block is free right away
+   for (int j=0; j<numActiveVoices; ++j)
+   {
+      int i = mActiveVoices[j];
+      mVoices[i].mRendered = true;
+      if (!mVoices[i].mNoteOn && (!mVoices[i].mRunning || mVoices[i].mVoice->IsDone(time)))
+         FreeVoice(i);
    }
    
    for (int ch=0; ch<out->NumActiveChannels(); ++ch)
@@ -195,12 +348,36 @@ void PolyphonyMgr::Process(double time, ChannelBuffer* out, int bufferSize)
    mFadeOutBufferPos += bufferSize;
 }
 
+bool PolyphonyMgr::ShouldRenderInParallel(int numActiveVoices, ChannelBuffer* out)
+{
+   if (numActiveVoices < kParallelVoiceThreshold)
+      return false;
+   if (!TheSynth->GetAudioGraph().IsParallel())
+      return false;
+   if (out->BufferSize() != mVoiceOutputs[0]->BufferSize())
+      return false;
+   //voices compute their owner's modulated sliders every sample, which only works from one thread at a time
+   if (mOwner == nullptr || mOwner->HasModulatedSliders())
+      return false;
+   return true;
+}
+
+void PolyphonyMgr::VoiceRenderJob::Run(int index)
+{
+   int voiceIdx = mOwner->mActiveVoices[index];
+   ChannelBuffer* voiceOut = mOwner->mVoiceOutputs[voiceIdx];
+   voiceOut->SetNumActiveChannels(mNumChannels);
+   voiceOut->Clear();
+   VoiceInfo& voice = mOwner->mVoices[voiceIdx];
+   voice.mRunning = voice.mVoice->Process(mTime, voiceOut);
+}
+
 void PolyphonyMgr::DrawDebug(float x, float y)
 {
    ofPushMatrix();
    ofPushStyle();
    ofTranslate(x,y);
-   for (int i=0; i<kNumVoices; ++i)
+   for (int i=0; i<mVoiceLimit; ++i)
    {
       if (mVoices[i].mPitch == -1)
          ofSetColor(100, 100, 100);
@@ -13,8 +13,12 @@
 #include "OpenFrameworksPort.h"
 #include "SynthGlobals.h"
 #include "ChannelBuffer.h"
+#include "AudioGraphScheduler.h"
 
 const int kVoiceFadeSamples = 50;
+const int kParallelVoiceThreshold = 4;   //fewer voices than this aren't worth the handoff to other threads
+const int kMaxVoicePoolSize = 256;
+const float kSilentVoiceLevel = .00001f;   //-100dB, released voices under this are culled
 
 class IMidiVoice;
 class IVoiceParams;
@@ -31,12 +35,20 @@ enum VoiceType
 
 struct VoiceInfo
 {
-   VoiceInfo() : mPitch(-1), mNoteOn(false) {}
+   VoiceInfo() : mPitch(-1), mVoice(nullptr), mTime(0), mStopTime(0), mNoteOn(false), mRunning(false), mRendered(false), mFree(false), mPrevFree(-1), mNextFree(-1) {}
    
    float mPitch;
    IMidiVoice* mVoice;
    double mTime;
+   double mStopTime;
    bool mNoteOn;
+   bool mRunning;
+   bool mRendered;   //has been through Process() since its note started
+   
+   //links in the free list
+   bool mFree;
+   int mPrevFree;
+   int mNextFree;
 };
 
 class PolyphonyMgr
@@ -53,13 +65,42 @@ public:
    void Process(double time, ChannelBuffer* out, int bufferSize);
    void GetPhaseAndInc(float& phase, float& inc);
    void DrawDebug(float x, float y);
-   void SetVoiceLimit(int limit) { mVoiceLimit = limit; }
+   //grows the voice pool if it needs to, up to kMaxVoicePoolSize. locks the audio thread, call it from setup rather than per note
+   void SetVoiceLimit(int limit);
+   int GetVoiceLimit() const { return mVoiceLimit; }
 private:
    void Prune(double time);
+   void SetPoolSize(int size);
+   IMidiVoice* CreateVoice() const;
+   void FreeVoice(int index);
+   void PushFreeVoice(int index);
+   void RemoveFreeVoice(int index);
+   int PopFreeVoice();
+   int ChooseVoiceToSteal(double time);
+   void RebuildFreeList();
+   bool ShouldRenderInParallel(int numActiveVoices, ChannelBuffer* out);
+   
+   //renders each active voice into its own buffer, so they can run on different threads
+   struct VoiceRenderJob : public AudioGraphScheduler::ParallelJob
+   {
+      void Run(int index) override;
+      
+      PolyphonyMgr* mOwner;
+      double mTime;
+      int mNumChannels;
+   };
    
-   VoiceInfo mVoices[kNumVoices];
+   //the pool is allocated up front, so starting a note never allocates.
+   //free voices are kept in a list in the order they were freed, so a new note takes the voice that has been quiet longest
+   std::vector<VoiceInfo> mVoices;
+   std::vector<ChannelBuffer*> mVoiceOutputs;
+   std::vector<int> mActiveVoices;
+   int mFreeHead;
+   int mFreeTail;
+   VoiceType mVoiceType;
+   IVoiceParams* mVoiceParams;
+   VoiceRenderJob mRenderJob;
    bool mAllowStealing;
-   int mLastVoice;
    ChannelBuffer mFadeOutBuffer;
    ChannelBuffer mFadeOutWorkBuffer;
    float mWorkBuffer[2048];
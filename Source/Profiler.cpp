@@ -12,84 +12,138 @@
 
 Profiler::Cost Profiler::sCosts[];
 bool Profiler::sEnableProfiler = false;
+thread_local int Profiler::sCurrentNode = -1;
+thread_local int Profiler::sThreadIndex = -1;
+Atomic<int> Profiler::sNumThreads;
+Profiler::TraceEvent* Profiler::sTraceEvents = nullptr;
+Atomic<int> Profiler::sNumTraceEvents;
+bool Profiler::sTraceCapturing = false;
+int64 Profiler::sTraceStart = 0;
 
-namespace {
-   static inline uint64_t rdtscp( uint32_t & aux )
+namespace
+{
+   const int kMaxTraceEvents = 1 << 18;
+   
+   string EscapeJSON(const char* str)
    {
-#if BESPOKE_WINDOWS
-      return 0;   //TODO(Ryan)
-#else
-      uint64_t rax,rdx;
-      asm volatile ( "rdtscp\n" : "=a" (rax), "=d" (rdx), "=c" (aux) : : );
-      return (rdx << 32) + rax;
-#endif
+      string escaped;
+      for (const char* c = str; *c != 0; ++c)
+      {
+         if (*c == '"' || *c == '\\')
+            escaped += '\\';
+         escaped += *c;
+      }
+      return escaped;
    }
 }
 
-Profiler::Profiler(const char* name, uint32_t hash)
+Profiler::Profiler(const char* name, uint32_t hash, bool isModule)
 : mIndex(-1)
 {
    if (sEnableProfiler)
    {
-      for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+      mIndex = FindOrAddNode(sCurrentNode, hash, name, isModule);
+      if (mIndex != -1)
       {
-         if (sCosts[i].mHash == hash)
-         {
-            mIndex = i;
-            break;
-         }
-         if (sCosts[i].mName[0] == 0)
-         {
-            mIndex = i;
-            sCosts[i].mName = name;
-            sCosts[i].mHash = hash;
-            break;
-         }
+         mParent = sCurrentNode;
+         sCurrentNode = mIndex;
+         mTimerStart = Time::getHighResolutionTicks();
       }
-      
-      uint32_t aux;
-      mTimerStart = rdtscp(aux);
-
-      //struct timespec t;
-      //clock_gettime(CLOCK_MONOTONIC, &t);
-      //mTimerStart = t.tv_sec * 1000000000 + t.tv_nsec;
    }
 }
 
 Profiler::~Profiler()
 {
-   if (sEnableProfiler)
+   if (mIndex != -1)
    {
-      uint32_t aux;
-      sCosts[mIndex].mFrameCost += rdtscp(aux) - mTimerStart;
+      int64 timerEnd = Time::getHighResolutionTicks();
+      sCosts[mIndex].mFrameCost += timerEnd - mTimerStart;
+      sCurrentNode = mParent;
       
-      //struct timespec t;
-      //clock_gettime(CLOCK_MONOTONIC, &t);
-      //unsigned long long timerEnd = t.tv_sec * 1000000000 + t.tv_nsec;
-   
-      //sCosts[mIndex].mFrameCost += timerEnd - mTimerStart;
+      if (sTraceCapturing)
+      {
+         int eventIdx = ++sNumTraceEvents - 1;
+         if (eventIdx < kMaxTraceEvents)
+         {
+            if (sThreadIndex == -1)
+               sThreadIndex = ++sNumThreads - 1;
+            TraceEvent& event = sTraceEvents[eventIdx];
+            event.mThread = sThreadIndex;
+            event.mStart = mTimerStart;
+            event.mEnd = timerEnd;
+            event.mNode = mIndex;   //written last, marks the event as complete
+         }
+      }
    }
 }
 
+//static
+int Profiler::FindOrAddNode(int parent, uint32_t hash, const char* name, bool isModule)
+{
+   //open addressing on (parent, hash), so the same scope under different parents gets its own entry
+   uint64 key = ((uint64)(parent + 2) << 32) | hash;
+   int start = (int)((hash ^ ((uint32_t)(parent + 2) * 2654435761u)) % PROFILER_MAX_TRACK);
+   for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+   {
+      int index = (start + i) % PROFILER_MAX_TRACK;
+      Cost& cost = sCosts[index];
+      uint64 existing = cost.mKey.get();
+      if (existing == key)
+         return index;
+      if (existing == 0 && cost.mKey.compareAndSetBool(key, 0))
+      {
+         cost.mParent = parent;
+         cost.mIsModule = isModule;
+         strncpy(cost.mName, name, sizeof(cost.mName) - 1);
+         cost.mName[sizeof(cost.mName) - 1] = 0;
+         cost.mReady.set(1);
+         return index;
+      }
+      if (cost.mKey.get() == key)   //somebody else just added it
+         return index;
+   }
+   return -1;  //full, don't track this one
+}
+
 //static
 void Profiler::PrintCounters()
 {
-   //bool printedBreak = false;
    for (int i=0; i<PROFILER_MAX_TRACK; ++i)
    {
-      if (sCosts[i].mName[0] == 0)
-         break;
-      /*if (sCosts[i].mFrameCost > 500)
+      if (sCosts[i].mReady.get())
+         sCosts[i].EndFrame();
+   }
+}
+
+//static
+int Profiler::GetTopModuleCosts(ModuleCost* out, int maxCount)
+{
+   int count = 0;
+   for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+   {
+      const Cost& cost = sCosts[i];
+      if (!cost.mReady.get() || !cost.mIsModule)
+         continue;
+      int64 ticks = cost.mFrameCost.get();
+      if (ticks == 0)
+         continue;
+      
+      //insertion sort into the short list
+      ModuleCost entry = { cost.mName, TicksToUs(ticks) };
+      int pos = count;
+      while (pos > 0 && out[pos-1].mUs < entry.mUs)
       {
-         if (!printedBreak)
-         {
-            ofLog() << "******* PrintCounters():";
-            printedBreak = true;
-         }
-         ofLog() << sCosts[i].mName << " " << sCosts[i].mFrameCost << " us";
-      }*/
-      sCosts[i].EndFrame();
+         if (pos < maxCount)
+            out[pos] = out[pos-1];
+         --pos;
+      }
+      if (pos < maxCount)
+      {
+         out[pos] = entry;
+         count = MIN(count + 1, maxCount);
+      }
    }
+   return count;
 }
 
 //static
@@ -104,25 +158,25 @@ void Profiler::Draw()
    ofFill();
    ofSetColor(0,0,0,140);
    //ofRect(-5,-15,600,sCosts.size()*15+10);
-   long entireFrameUs = GetSafeFrameLengthNanoseconds();
-   for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+   double entireFrameUs = GetSafeFrameLengthNanoseconds() / 1000.0;
+   vector<Stats> stats = GetStats();
+   for (const auto& stat : stats)
    {
-      if (sCosts[i].mName[0] == 0)
-         break;
-      const Cost& cost = sCosts[i];
-      long maxCost = cost.MaxCost();
+      string name = stat.mPath.substr(stat.mPath.rfind('/') + 1);
       
       ofSetColor(255,255,255);
-      gFont.DrawString(string(sCosts[i].mName)+": "+ofToString(maxCost/1000), 15, 0, 0);
+      gFont.DrawString(name+": "+ofToString(stat.mMeanUs,0)+" / "+ofToString(stat.mP99Us,0)+" / "+ofToString(stat.mMaxUs,0), 15, stat.mDepth * 10, 0);
       
-      if (maxCost > entireFrameUs)
+      if (stat.mMaxUs > entireFrameUs)
          ofSetColor(255,0,0);
       else
          ofSetColor(0,255,0);
-      ofRect(250, -10,(float)maxCost / entireFrameUs * (ofGetWidth() - 300) * .5f, 10);
+      ofRect(330, -10,(float)(stat.mP99Us / entireFrameUs) * (ofGetWidth() - 380) * .5f, 10);
       
       ofTranslate(0, 15);
    }
+   ofSetColor(255,255,255);
+   gFont.DrawString("mean / p99 / max us per block", 13, 0, 0);
    ofPopStyle();
    ofPopMatrix();
 }
@@ -138,25 +192,134 @@ long Profiler::GetSafeFrameLengthNanoseconds()
 //static
 void Profiler::ToggleProfiler()
 {
-   sEnableProfiler = !sEnableProfiler;
+   SetEnabled(!sEnableProfiler);
+}
+
+//static
+void Profiler::SetEnabled(bool enabled)
+{
+   if (enabled && !sEnableProfiler)
+   {
+      //keep the nodes, the audio thread might be looking them up right now. just start the history over
+      for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+      {
+         sCosts[i].mFrameCost.set(0);
+         bzero(sCosts[i].mHistory, sizeof(sCosts[i].mHistory));
+      }
+   }
+   sEnableProfiler = enabled;
+}
+
+//static
+double Profiler::TicksToUs(int64 ticks)
+{
+   return Time::highResolutionTicksToSeconds(ticks) * 1000000;
+}
+
+//static
+vector<Profiler::Stats> Profiler::GetStats()
+{
+   vector<Stats> stats;
+   for (int i=0; i<PROFILER_MAX_TRACK; ++i)
+   {
+      if (sCosts[i].mReady.get() && sCosts[i].mParent == -1)
+         CollectStats(i, 0, sCosts[i].mName, stats);
+   }
+   return stats;
+}
+
+//static
+void Profiler::CollectStats(int node, int depth, string path, vector<Stats>& stats)
+{
+   const Cost& cost = sCosts[node];
+   
+   vector<int64> history(cost.mHistory, cost.mHistory + PROFILER_HISTORY_LENGTH);
+   int lastIdx = (cost.mHistoryIdx + PROFILER_HISTORY_LENGTH - 1) % PROFILER_HISTORY_LENGTH;
+   int64 last = history[lastIdx];
+   sort(history.begin(), history.end());
+   if (history.back() == 0)   //hasn't run lately, probably a deleted module
+      return;
+   
+   Stats stat;
+   stat.mPath = path;
+   stat.mDepth = depth;
+   int64 total = 0;
+   for (auto ticks : history)
+      total += ticks;
+   stat.mMinUs = TicksToUs(history.front());
+   stat.mMeanUs = TicksToUs(total) / history.size();
+   stat.mP99Us = TicksToUs(history[(history.size() * 99) / 100]);
+   stat.mMaxUs = TicksToUs(history.back());
+   stat.mLastUs = TicksToUs(last);
+   stats.push_back(stat);
    
    for (int i=0; i<PROFILER_MAX_TRACK; ++i)
-      sCosts[i].mName[0] = 0;
+   {
+      if (sCosts[i].mReady.get() && sCosts[i].mParent == node)
+         CollectStats(i, depth + 1, path + "/" + sCosts[i].mName, stats);
+   }
+}
+
+//static
+void Profiler::StartTraceCapture()
+{
+   if (sTraceEvents == nullptr)
+      sTraceEvents = new TraceEvent[kMaxTraceEvents];
+   sTraceCapturing = false;
+   for (int i=0; i<kMaxTraceEvents; ++i)
+      sTraceEvents[i].mNode = -1;
+   sNumTraceEvents.set(0);
+   sTraceStart = Time::getHighResolutionTicks();
+   SetEnabled(true);
+   sTraceCapturing = true;
+}
+
+//static
+bool Profiler::WriteChromeTrace(string path)
+{
+   if (sTraceEvents == nullptr)
+      return false;
+   
+   sTraceCapturing = false;
+   int numEvents = MIN(sNumTraceEvents.get(), kMaxTraceEvents);
+   
+   string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+   bool first = true;
+   for (int i=0; i<numEvents; ++i)
+   {
+      const TraceEvent& event = sTraceEvents[i];
+      if (event.mNode == -1)   //was still being written when we stopped
+         continue;
+      if (!first)
+         json += ",\n";
+      first = false;
+      json += "{\"name\":\"" + EscapeJSON(sCosts[event.mNode].mName) + "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + ofToString(event.mThread) +
+              ",\"ts\":" + ofToString(TicksToUs(event.mStart - sTraceStart), 3) + ",\"dur\":" + ofToString(TicksToUs(event.mEnd - event.mStart), 3) + "}";
+   }
+   json += "\n]}\n";
+   
+   if (sNumTraceEvents.get() > kMaxTraceEvents)
+      ofLog() << "profiler trace filled up, only wrote the first " << kMaxTraceEvents << " scopes";
+   
+   return juce::File(path).replaceWithText(json);
+}
+
+//static
+bool Profiler::WriteCSV(string path)
+{
+   string csv = "scope,depth,min_us,mean_us,p99_us,max_us\n";
+   for (const auto& stat : GetStats())
+   {
+      csv += "\"" + stat.mPath + "\"," + ofToString(stat.mDepth) + "," + ofToString(stat.mMinUs, 2) + "," + ofToString(stat.mMeanUs, 2) + "," +
+             ofToString(stat.mP99Us, 2) + "," + ofToString(stat.mMaxUs, 2) + "\n";
+   }
+   return juce::File(path).replaceWithText(csv);
 }
 
 void Profiler::Cost::EndFrame()
 {
-   mHistory[mHistoryIdx] = mFrameCost;
-   mFrameCost = 0;
+   mHistory[mHistoryIdx] = mFrameCost.exchange(0);
    ++mHistoryIdx;
    if (mHistoryIdx >= PROFILER_HISTORY_LENGTH)
       mHistoryIdx = 0;
 }
-
-unsigned long long Profiler::Cost::MaxCost() const
-{
-   unsigned long long maxCost = 0;
-   for (int i=0; i<PROFILER_HISTORY_LENGTH; ++i)
-      maxCost = MAX(maxCost, mHistory[i]);
-   return maxCost;
-}
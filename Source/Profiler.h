@@ -13,42 +13,117 @@
 #include "SynthGlobals.h"
 
 #define PROFILER_HISTORY_LENGTH 500
-#define PROFILER_MAX_TRACK 100
+#define PROFILER_MAX_TRACK 512
 
+//scopes nest: a PROFILER inside another one is tracked as its child.
+//build with BESPOKE_DISABLE_PROFILER to compile them out entirely, otherwise a disabled profiler costs one branch per scope.
+#if BESPOKE_DISABLE_PROFILER
+#define PROFILER(profile_id)
+#else
 #define PROFILER(profile_id) static uint32_t profile_id ## _hash = JenkinsHash(#profile_id); Profiler profilerScopeHolder(#profile_id, profile_id ## _hash)
+#endif
 
 class Profiler
 {
 public:
-   Profiler(const char* name, uint32_t hash);
+   Profiler(const char* name, uint32_t hash, bool isModule = false);
    ~Profiler();
+
+#if BESPOKE_DISABLE_PROFILER
+   static bool IsEnabled() { return false; }
+#else
+   static bool IsEnabled() { return sEnableProfiler; }
+#endif
+   static uint32_t HashInstance(const void* instance) { return (uint32_t)((uintptr_t)instance >> 4) * 2654435761u; }
+   
+   //scopes opened on another thread on our behalf (audio graph workers) can be parented to ours
+   static int GetCurrentScope() { return sCurrentNode; }
+   class InheritScope
+   {
+   public:
+      InheritScope(int scope) : mPrevious(sCurrentNode) { sCurrentNode = scope; }
+      ~InheritScope() { sCurrentNode = mPrevious; }
+   private:
+      int mPrevious;
+   };
    
+   //call once per audio block, from the audio thread
    static void PrintCounters();
    static void Draw();
    
    static void ToggleProfiler();
+   static void SetEnabled(bool enabled);
    
+   struct Stats
+   {
+      string mPath;
+      int mDepth;
+      double mMinUs;
+      double mMeanUs;
+      double mP99Us;
+      double mMaxUs;
+      double mLastUs;
+   };
+   //per-block costs over the last PROFILER_HISTORY_LENGTH blocks, parents before their children
+   static vector<Stats> GetStats();
+   
+   struct ModuleCost
+   {
+      const char* mName;
+      double mUs;
+   };
+   //most expensive module scopes of the block in progress, most expensive first. audio thread, before PrintCounters()
+   static int GetTopModuleCosts(ModuleCost* out, int maxCount);
+   
+   //chrome://tracing / perfetto. records every scope while capturing
+   static void StartTraceCapture();
+   static bool IsCapturingTrace() { return sTraceEvents != nullptr && sTraceCapturing; }
+   static bool WriteChromeTrace(string path);
+   static bool WriteCSV(string path);
+
 private:
    static long GetSafeFrameLengthNanoseconds();
+   static int FindOrAddNode(int parent, uint32_t hash, const char* name, bool isModule);
+   static void CollectStats(int node, int depth, string path, vector<Stats>& stats);
+   static double TicksToUs(int64 ticks);
    
    struct Cost
    {
-      Cost() : mFrameCost(0), mHistoryIdx(0) { bzero(mHistory, sizeof(long)); }
+      Cost() : mKey(0), mParent(-1), mIsModule(false), mReady(0), mFrameCost(0), mHistoryIdx(0) { mName[0] = 0; bzero(mHistory, sizeof(mHistory)); }
       void EndFrame();
-      unsigned long long MaxCost() const;
       
-      string mName;
-      uint32_t mHash;
-      unsigned long long mFrameCost;
-      unsigned long long mHistory[PROFILER_HISTORY_LENGTH];
+      Atomic<uint64> mKey;
+      int mParent;
+      bool mIsModule;
+      Atomic<int> mReady;
+      char mName[64];
+      Atomic<int64> mFrameCost;
+      int64 mHistory[PROFILER_HISTORY_LENGTH];
       int mHistoryIdx;
    };
    
-   unsigned long long mTimerStart;
+   struct TraceEvent
+   {
+      int mNode;
+      int mThread;
+      int64 mStart;
+      int64 mEnd;
+   };
+   
+   int64 mTimerStart;
    int mIndex;
+   int mParent;
    
    static Cost sCosts[PROFILER_MAX_TRACK];
    static bool sEnableProfiler;
+   static thread_local int sCurrentNode;
+   static thread_local int sThreadIndex;
+   static Atomic<int> sNumThreads;
+   
+   static TraceEvent* sTraceEvents;
+   static Atomic<int> sNumTraceEvents;
+   static bool sTraceCapturing;
+   static int64 sTraceStart;
 };
 
 #endif /* defined(__modularSynth__Profiler__) */
@@ -13,6 +13,7 @@
 #include "IAudioSource.h"
 #include "INoteReceiver.h"
 #include "ADSR.h"
+#include "AdditiveEngine.h"
 #include "IDrawableModule.h"
 #include "Checkbox.h"
 #include "Slider.h"
@@ -59,7 +60,6 @@ public:
    
    
 private:
-   float SinSample(float phase); //phase 0-512
    void CalcAmp();
    void DrawViz();
 
@@ -72,7 +72,7 @@ private:
    float mPhase;
    ::ADSR mAdsr[NUM_PARTIALS];
    float mAmp[NUM_PARTIALS];
-   float mPhases[NUM_PARTIALS];
+   AdditiveEngine mEngine;
    float mDetune[NUM_PARTIALS];
    
    int mPitch;
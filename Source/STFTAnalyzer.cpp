@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    STFTAnalyzer.cpp
+    Created: 17 Oct 2026 5:02:16pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "STFTAnalyzer.h"
+
+STFTAnalyzer::STFTAnalyzer(int windowSize, int overlap)
+: mWindowSize(windowSize)
+, mHopSize(overlap == kOverlapPerBlock ? 1 : MAX(1, windowSize / overlap))
+, mFFT(windowSize)
+, mInput(windowSize)
+, mData(windowSize, windowSize/2 + 1)
+, mSamplesSinceFrame(0)
+{
+   mWindow = new float[windowSize];
+   for (int i=0; i<windowSize; ++i)
+      mWindow[i] = -.5f*cos(FTWO_PI*i/windowSize)+.5f;
+   
+   Clear(mData.mRealValues, GetNumBins());
+   Clear(mData.mImaginaryValues, GetNumBins());
+   Clear(mData.mTimeDomain, windowSize);
+   mFrame.mRealValues = mData.mRealValues;
+   mFrame.mImaginaryValues = mData.mImaginaryValues;
+   mFrame.mTimeDomain = mData.mTimeDomain;
+   mFrame.mNumBins = GetNumBins();
+}
+
+STFTAnalyzer::~STFTAnalyzer()
+{
+   delete[] mWindow;
+}
+
+void STFTAnalyzer::Write(const float* samples, int numSamples)
+{
+   mInput.WriteChunk(const_cast<float*>(samples), numSamples, 0);
+   mSamplesSinceFrame += numSamples;
+}
+
+const STFTFrame& STFTAnalyzer::GetFrame()
+{
+   if (mSamplesSinceFrame < mHopSize)
+      return mFrame;
+   mSamplesSinceFrame = 0;
+   
+   mInput.ReadChunk(mData.mTimeDomain, mWindowSize, 0, 0);
+   Mult(mData.mTimeDomain, mWindow, mWindowSize);
+   mFFT.Forward(mData.mTimeDomain, mData.mRealValues, mData.mImaginaryValues);
+   return mFrame;
+}
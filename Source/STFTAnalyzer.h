@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    STFTAnalyzer.h
+    Created: 17 Oct 2026 5:02:16pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SynthGlobals.h"
+#include "FFT.h"
+#include "RollingBuffer.h"
+
+//one windowed spectrum, in ::FFT's layout. read-only
+struct STFTFrame
+{
+   const float* mRealValues;
+   const float* mImaginaryValues;
+   const float* mTimeDomain;  //the windowed input it came from
+   int mNumBins;
+};
+
+//short-time fourier analysis of one signal, for the spectral modules.
+//write every block of input, the transform only runs when somebody asks for a frame, at most once per hop.
+//the window is a hann window, GetWindow() has it for overlap-add resynthesis.
+class STFTAnalyzer
+{
+public:
+   //overlap is windowSize / hop size. kOverlapPerBlock makes a fresh frame every audio block instead,
+   //which is what modules doing their own overlap-add per block need
+   STFTAnalyzer(int windowSize, int overlap);
+   ~STFTAnalyzer();
+   
+   //audio thread
+   void Write(const float* samples, int numSamples);
+   const STFTFrame& GetFrame();
+   
+   //doesn't analyze anything, for drawing
+   const STFTFrame& GetLastFrame() const { return mFrame; }
+   
+   int GetWindowSize() const { return mWindowSize; }
+   int GetNumBins() const { return mWindowSize/2 + 1; }
+   const float* GetWindow() const { return mWindow; }
+   
+   static const int kOverlapPerBlock = 0;
+private:
+   STFTAnalyzer(const STFTAnalyzer&);   //not copyable
+   STFTAnalyzer& operator=(const STFTAnalyzer&);
+   
+   int mWindowSize;
+   int mHopSize;
+   float* mWindow;
+   ::FFT mFFT;
+   RollingBuffer mInput;
+   FFTData mData;
+   STFTFrame mFrame;
+   int mSamplesSinceFrame;
+};
@@ -11,9 +11,13 @@
 #include "FileStream.h"
 #include "ModularSynth.h"
 #include "ChannelBuffer.h"
+#include "SampleStream.h"
+#include "ScratchArena.h"
 
 Sample::Sample()
 : mData(0)
+, mStream(nullptr)
+, mStorageFormat(kSampleFormat_Float)
 , mNumSamples(0)
 , mStartTime(0)
 , mOffset(FLT_MAX)
@@ -28,9 +32,10 @@ Sample::Sample()
 
 Sample::~Sample()
 {
+   delete mStream;
 }
 
-bool Sample::Read(const char* path, bool mono)
+bool Sample::Read(const char* path, bool mono, bool allowStreaming)
 {
    StringCopy(mReadPath,path,MAX_SAMPLE_READ_PATH_LENGTH);
    vector<string> tokens = ofSplitString(path, GetPathSeparator());
@@ -38,40 +43,62 @@ bool Sample::Read(const char* path, bool mono)
    mName[strlen(mName)-4] = 0;
    
    File file(ofToDataPath(path));
+   
+   //if anything else has read this file, share its audio rather than decoding it again
+   SampleCache::EntryPtr cached = TheSynth->GetSampleCache()->Find(file, mono, mStorageFormat);
+   if (cached != nullptr)
+   {
+      SetStream(nullptr);
+      ShareData(cached);
+      Reset();
+      return true;
+   }
+   
    ScopedPointer<AudioFormatReader> reader(TheSynth->GetGlobalManagers()->mAudioFormatManager.createReaderFor(file));
    
    if (reader != nullptr)
    {
+      if (allowStreaming && reader->lengthInSamples > kStreamingThresholdSeconds * reader->sampleRate)
+      {
+         reader = nullptr;
+         return OpenStream(path);
+      }
+      
+      SetStream(nullptr);
+      ReleaseSharedData();
       mNumSamples = (int)reader->lengthInSamples;
       mSampleRateRatio = float(reader->sampleRate) / gSampleRate;
       
       mData.Resize(mNumSamples);
       
-      AudioSampleBuffer fileBuffer;
-      fileBuffer.setSize (reader->numChannels, mNumSamples);
-      reader->read(&fileBuffer, 0, mNumSamples, 0, true, true);
-      
-      if (mono)
+      if (mono && reader->numChannels > 1)
+      {
+         AudioSampleBuffer fileBuffer;
+         fileBuffer.setSize (reader->numChannels, mNumSamples);
+         reader->read(&fileBuffer, 0, mNumSamples, 0, true, true);
+         
          mData.SetNumActiveChannels(1);
+         float* mixed = mData.GetChannel(0);
+         BufferCopy(mixed, fileBuffer.getReadPointer(0), mNumSamples); //put first channel in
+         for (int ch=1; ch<reader->numChannels; ++ch)
+            Add(mixed, fileBuffer.getReadPointer(ch), mNumSamples);  //add the other channels
+         Mult(mixed, 1.0f / reader->numChannels, mNumSamples);   //normalize volume
+      }
       else
-         mData.SetNumActiveChannels(reader->numChannels);
-      
-      for (int i=0; i<reader->lengthInSamples; ++i)
       {
-         if (mono)
-         {
-            mData.GetChannel(0)[i] = fileBuffer.getSample(0, i); //put first channel in
-            for (int ch=1; ch<reader->numChannels; ++ch)
-               mData.GetChannel(0)[i] += fileBuffer.getSample(ch, i); //add the other channels
-            mData.GetChannel(0)[i] /= reader->numChannels;   //normalize volume
-         }
-         else
-         {
-            for (int ch=0; ch<reader->numChannels; ++ch)
-               mData.GetChannel(ch)[i] = fileBuffer.getSample(ch, i);
-         }
+         //decode straight into our channels, rather than through a temporary buffer
+         //files with more channels than we keep only get their first few read
+         int numChannels = MIN(mono ? 1 : (int)reader->numChannels, ChannelBuffer::kMaxNumChannels);
+         mData.SetNumActiveChannels(numChannels);
+         numChannels = mData.NumActiveChannels();
+         float* channels[ChannelBuffer::kMaxNumChannels];
+         for (int ch=0; ch<numChannels; ++ch)
+            channels[ch] = mData.GetChannel(ch);
+         AudioSampleBuffer fileBuffer(channels, numChannels, mNumSamples);
+         reader->read(&fileBuffer, 0, mNumSamples, 0, true, true);
       }
       
+      ShareData(TheSynth->GetSampleCache()->Add(file, mono, mStorageFormat, mData, mNumSamples, mSampleRateRatio));
       Reset();
       return true;
    }
@@ -79,17 +106,156 @@ bool Sample::Read(const char* path, bool mono)
    return false;
 }
 
+void Sample::ShareData(SampleCache::EntryPtr entry)
+{
+   ChannelBuffer shared(0);
+   if (entry->IsCompact())
+   {
+      //no float audio to point at, it's decoded as it plays
+      shared.SetNumActiveChannels(entry->mCompact.NumChannels());
+   }
+   else
+   {
+      ChannelBuffer* source = &entry->mData;
+      float* channels[ChannelBuffer::kMaxNumChannels];
+      for (int ch=0; ch<source->NumActiveChannels(); ++ch)
+         channels[ch] = source->GetChannel(ch);
+      ChannelBuffer wrapped(channels, source->NumActiveChannels(), entry->mNumSamples);
+      wrapped.SetNumActiveChannels(source->NumActiveChannels());
+      shared.Swap(wrapped);
+   }
+   
+   LockDataMutex(true);
+   mData.Swap(shared);
+   mShared = entry;
+   mNumSamples = entry->mNumSamples;
+   mSampleRateRatio = entry->mSampleRateRatio;
+   LockDataMutex(false);
+}
+
+void Sample::ReleaseSharedData()
+{
+   if (mShared == nullptr)
+      return;
+   
+   ChannelBuffer empty(0);
+   LockDataMutex(true);
+   mData.Swap(empty);
+   mShared.reset();
+   LockDataMutex(false);
+}
+
+ChannelBuffer* Sample::EditData()
+{
+   if (mShared != nullptr)
+   {
+      ChannelBuffer copy(mNumSamples);
+      if (mShared->IsCompact())
+      {
+         copy.SetNumActiveChannels(mShared->mCompact.NumChannels());
+         mShared->mCompact.Read(0, &copy, mNumSamples);
+      }
+      else
+      {
+         copy.CopyFrom(&mData, mNumSamples);
+      }
+      LockDataMutex(true);
+      mData.Swap(copy);
+      mShared.reset();
+      LockDataMutex(false);
+   }
+   return &mData;
+}
+
+bool Sample::OpenStream(const char* path)
+{
+   SampleStream* stream = new SampleStream();
+   if (!stream->Open(path))
+   {
+      delete stream;
+      return false;
+   }
+   SetStream(stream);
+   return true;
+}
+
+void Sample::SetStream(SampleStream* stream)
+{
+   if (stream == mStream)
+      return;
+   
+   mPlayMutex.lock();
+   LockDataMutex(true);
+   SampleStream* oldStream = mStream;
+   mStream = stream;
+   if (stream != nullptr)
+   {
+      mNumSamples = stream->LengthInSamples();
+      mSampleRateRatio = stream->GetSampleRateRatio();
+      ChannelBuffer empty(0);   //whether it was ours or the cache's, the audio in memory goes
+      mData.Swap(empty);
+      mShared.reset();
+      mData.SetNumActiveChannels(stream->NumChannels());
+      Reset();
+   }
+   LockDataMutex(false);
+   mPlayMutex.unlock();
+   
+   delete oldStream;
+}
+
+void Sample::ReadWindow(int start, int length, ChannelBuffer* out)
+{
+   if (mStream != nullptr)
+   {
+      mStream->ReadWindow(start, length, out);
+      return;
+   }
+   
+   LockDataMutex(true);
+   out->SetNumActiveChannels(mData.NumActiveChannels());
+   if (IsCompact())
+   {
+      mShared->mCompact.Read(start, out, length);
+      LockDataMutex(false);
+      return;
+   }
+   int from = CLAMP(start, 0, mNumSamples);
+   int to = CLAMP(start + length, 0, mNumSamples);
+   for (int ch=0; ch<out->NumActiveChannels(); ++ch)
+   {
+      float* dest = out->GetChannel(ch);
+      ::Clear(dest, length);
+      if (from < to)
+         BufferCopy(dest + from - start, mData.GetChannel(ch) + from, to - from);
+   }
+   LockDataMutex(false);
+}
+
+const ChannelBuffer* Sample::GetDrawData()
+{
+   if (mStream != nullptr)
+      return mStream->GetOverview();
+   if (IsCompact())
+      return &mShared->mOverview;
+   return &mData;
+}
+
 void Sample::Create(int length)
 {
+   SetStream(nullptr);
+   ReleaseSharedData();
    mData.Resize(length);
    mData.SetNumActiveChannels(1);
    Setup(length);
 }
 
-void Sample::Create(ChannelBuffer* data)
+void Sample::Create(const ChannelBuffer* data)
 {
    int channels = data->NumActiveChannels();
    int length = data->BufferSize();
+   SetStream(nullptr);
+   ReleaseSharedData();
    mData.Resize(length);
    mData.SetNumActiveChannels(channels);
    for (int ch=0; ch<channels; ++ch)
@@ -111,6 +277,18 @@ void Sample::Setup(int length)
 bool Sample::Write(const char* path /*=nullptr*/)
 {
    const char* writeTo = path ? path : mReadPath;
+   if (mStream != nullptr)   //the audio is only on disk, so that's what gets written
+   {
+      File source(ofToDataPath(mReadPath));
+      File dest(ofToDataPath(writeTo));
+      return source == dest || source.copyFileTo(dest);
+   }
+   if (IsCompact())
+   {
+      ChannelBuffer decoded(mNumSamples);
+      ReadWindow(0, mNumSamples, &decoded);
+      return WriteDataToFile(writeTo, &decoded, mNumSamples);
+   }
    WriteDataToFile(writeTo, &mData, mNumSamples);
    return true;
 }
@@ -174,6 +352,14 @@ bool Sample::ConsumeData(double time, ChannelBuffer* out, int size, bool replace
    }
    
    LockDataMutex(true);
+   if (mStream != nullptr || IsCompact())
+   {
+      ConsumeWindowedData(time, out, size, replace, end);
+      LockDataMutex(false);
+      mPlayMutex.unlock();
+      return true;
+   }
+   
    for (int i=0; i<size; ++i)
    {
       if (time < mStartTime)
@@ -210,6 +396,83 @@ bool Sample::ConsumeData(double time, ChannelBuffer* out, int size, bool replace
    return true;
 }
 
+void Sample::ConsumeWindowedData(double time, ChannelBuffer* out, int size, bool replace, float end)
+{
+   //streams only hand out stretches of the file, and compact audio has to be decoded before it can be interpolated,
+   //so play a chunk at a time out of a float window holding just what that chunk touches
+   ScratchArena::Scope scratch;
+   ChannelBuffer* window = scratch.GetChannelBuffer();
+   window->SetNumActiveChannels(NumChannels());
+   double step = mRate * mSampleRateRatio;
+   int chunkSize = MAX(1, int((kWorkBufferSize - 3) / MAX(1.0, fabs(step))));
+   
+   int i = 0;
+   for (; i<size && time < mStartTime; ++i)
+   {
+      if (replace)
+      {
+         for (int ch=0; ch<out->NumActiveChannels(); ++ch)
+            out->GetChannel(ch)[i] = 0;
+      }
+      time += gInvSampleRateMs;
+   }
+   
+   while (i < size)
+   {
+      int length = MIN(chunkSize, size - i);
+      double last = mOffset + step * (length - 1);
+      int windowStart = (int)floor(MIN(mOffset, last));
+      int windowLength = (int)floor(MAX(mOffset, last)) - windowStart + 2;
+      ReadPlaybackWindow(windowStart, window, windowLength);
+      
+      for (int j=0; j<length; ++j, ++i)
+      {
+         for (int ch=0; ch<out->NumActiveChannels(); ++ch)
+         {
+            int dataChannel = MIN(ch, window->NumActiveChannels()-1);
+            
+            float sample = 0;
+            if (mOffset < end || mLooping)
+               sample = GetInterpolatedSample(mOffset - windowStart, window->GetChannel(dataChannel), windowLength) * mVolume;
+            
+            if (replace)
+               out->GetChannel(ch)[i] = sample;
+            else
+               out->GetChannel(ch)[i] += sample;
+         }
+         
+         mOffset += step;
+      }
+   }
+}
+
+void Sample::ReadPlaybackWindow(int start, ChannelBuffer* window, int length)
+{
+   if (!mLooping || mNumSamples <= 0)
+   {
+      ReadPlaybackSource(start, window, length, 0);
+      return;
+   }
+   
+   //looping, so the window can run off the end and carry on from the start
+   int done = 0;
+   while (done < length)
+   {
+      int pos = ((start + done) % mNumSamples + mNumSamples) % mNumSamples;
+      int chunk = MIN(length - done, mNumSamples - pos);
+      ReadPlaybackSource(pos, window, chunk, done);
+      done += chunk;
+   }
+}
+
+void Sample::ReadPlaybackSource(int position, ChannelBuffer* out, int numSamples, int outOffset)
+{
+   if (mStream != nullptr)
+      mStream->Read(position, out, numSamples, outOffset);
+   else
+      mShared->mCompact.Read(position, out, numSamples, outOffset);
+}
+
 void Sample::PadBack(int amount)
 {
    //TODO(Ryan)
@@ -255,8 +518,36 @@ void Sample::ShiftWrap(int numSamplesToShift)
 
 void Sample::CopyFrom(Sample* sample)
 {
+   SetStream(nullptr);
+   SampleCache::EntryPtr shared = sample->mShared;
+   if (shared != nullptr && (!shared->IsCompact() || shared->mCompact.GetFormat() == mStorageFormat))
+   {
+      ShareData(shared);
+   }
+   else if (shared != nullptr)
+   {
+      //compact audio in a format we weren't asked to hold, and we might only be able to play floats. decode our own copy
+      ChannelBuffer decoded(shared->mNumSamples);
+      decoded.SetNumActiveChannels(shared->mCompact.NumChannels());
+      shared->mCompact.Read(0, &decoded, shared->mNumSamples);
+      if (mStorageFormat != kSampleFormat_Float)
+      {
+         ShareData(SampleCache::MakeEntry(decoded, shared->mNumSamples, shared->mSampleRateRatio, mStorageFormat));
+      }
+      else
+      {
+         ReleaseSharedData();
+         LockDataMutex(true);
+         mData.Swap(decoded);
+         LockDataMutex(false);
+      }
+   }
+   else
+   {
+      ReleaseSharedData();
+      mData.CopyFrom(&sample->mData);
+   }
    mNumSamples = sample->mNumSamples;
-   mData.CopyFrom(&sample->mData);
    mNumBars = sample->mNumBars;
    mLooping = sample->mLooping;
    mRate = sample->mRate;
@@ -264,20 +555,55 @@ void Sample::CopyFrom(Sample* sample)
    mStopPoint = sample->mStopPoint;
    strcpy(mName, sample->mName);
    strcpy(mReadPath, sample->mReadPath);
+   if (sample->IsStreaming())   //gets its own stream of the same file, rather than a copy of the audio
+      OpenStream(mReadPath);
+}
+
+void Sample::SwapData(Sample& other)
+{
+   mPlayMutex.lock();
+   LockDataMutex(true);
+   mData.Swap(other.mData);
+   std::swap(mStream, other.mStream);
+   std::swap(mShared, other.mShared);
+   std::swap(mNumSamples, other.mNumSamples);
+   std::swap(mSampleRateRatio, other.mSampleRateRatio);
+   char name[32];
+   StringCopy(name, mName, 32);
+   StringCopy(mName, other.mName, 32);
+   StringCopy(other.mName, name, 32);
+   char readPath[MAX_SAMPLE_READ_PATH_LENGTH];
+   StringCopy(readPath, mReadPath, MAX_SAMPLE_READ_PATH_LENGTH);
+   StringCopy(mReadPath, other.mReadPath, MAX_SAMPLE_READ_PATH_LENGTH);
+   StringCopy(other.mReadPath, readPath, MAX_SAMPLE_READ_PATH_LENGTH);
+   Reset();
+   other.Reset();
+   LockDataMutex(false);
+   mPlayMutex.unlock();
 }
 
 namespace
 {
-   const int kSaveStateRev = 0;
+   const int kSaveStateRev = 1;
 }
 
 void Sample::SaveState(FileStreamOut& out)
 {
    out << kSaveStateRev;
    
-   out << mNumSamples;
-   if (mNumSamples > 0)
+   //a streamed sample is saved as a reference to its file
+   out << IsStreaming();
+   out << (IsStreaming() ? 0 : mNumSamples);
+   if (mNumSamples > 0 && IsCompact())   //saved as floats like any other sample, and compacted again on load
+   {
+      ChannelBuffer decoded(mNumSamples);
+      ReadWindow(0, mNumSamples, &decoded);
+      decoded.Save(out, mNumSamples);
+   }
+   else if (mNumSamples > 0 && !IsStreaming())
+   {
       mData.Save(out, mNumSamples);
+   }
    out << mNumBars;
    out << mLooping;
    out << mRate;
@@ -292,6 +618,11 @@ void Sample::LoadState(FileStreamIn& in)
    int rev;
    in >> rev;
    
+   bool streaming = false;
+   if (rev >= 1)
+      in >> streaming;
+   SetStream(nullptr);
+   ReleaseSharedData();
    in >> mNumSamples;
    if (mNumSamples > 0)
    {
@@ -318,4 +649,10 @@ void Sample::LoadState(FileStreamIn& in)
    string readPath;
    in >> readPath;
    StringCopy(mReadPath, readPath.c_str(), MAX_SAMPLE_READ_PATH_LENGTH);
+   
+   if (mNumSamples > 0 && !streaming && mStorageFormat != kSampleFormat_Float)
+      ShareData(SampleCache::MakeEntry(mData, mNumSamples, mSampleRateRatio, mStorageFormat));
+   
+   if (streaming && !OpenStream(mReadPath))
+      ofLog() << "couldn't find streamed sample " << readPath;
 }
@@ -11,9 +11,11 @@
 
 #include "OpenFrameworksPort.h"
 #include "ChannelBuffer.h"
+#include "SampleCache.h"
 
 class FileStreamOut;
 class FileStreamIn;
+class SampleStream;
 
 #define MAX_SAMPLE_READ_PATH_LENGTH 1024
 
@@ -22,7 +24,8 @@ class Sample
 public:
    Sample();
    ~Sample();
-   bool Read(const char* path, bool mono = false);
+   //with allowStreaming, files longer than kStreamingThresholdSeconds are played from disk instead of loaded
+   bool Read(const char* path, bool mono = false, bool allowStreaming = false);
    bool Write(const char* path = nullptr);   //no path = use read filename
    bool ConsumeData(double time, ChannelBuffer* out, int size, bool replace);
    void Play(double time, float rate, int offset, int stopPoint=-1);
@@ -30,7 +33,21 @@ public:
    const char* Name() { return mName; }
    int LengthInSamples() const { return mNumSamples; }
    int NumChannels() const { return mData.NumActiveChannels(); }
-   ChannelBuffer* Data() { return &mData; }
+   //read only, audio read from a file is shared with every other Sample that read it. EditData() makes it ours to write.
+   //empty for streamed and compact samples, use ReadWindow() for those
+   const ChannelBuffer* Data() const { return &mData; }
+   ChannelBuffer* EditData();   //copies the audio first if it's shared, and makes compact audio float again
+   bool IsStreaming() const { return mStream != nullptr; }
+   SampleStream* GetStream() { return mStream; }
+   //how audio read or loaded from now on is held in memory. anything but float is played back from its compact form,
+   //and only a module that plays through ConsumeData() and reads through ReadWindow()/GetDrawData() should ask for that
+   void SetStorageFormat(SampleFormat format) { mStorageFormat = ResolveSampleFormat(format); }
+   SampleFormat GetStorageFormat() const { return mStorageFormat; }
+   bool IsCompact() const { return mShared != nullptr && mShared->IsCompact(); }
+   //copies [start, start+length) into out, from memory or from disk. not the audio thread for streamed samples
+   void ReadWindow(int start, int length, ChannelBuffer* out);
+   //the audio to draw. for streamed and compact samples that's an overview of peaks, scale positions by its BufferSize() / LengthInSamples()
+   const ChannelBuffer* GetDrawData();
    int GetPlayPosition() const { return mOffset; }
    void SetPlayPosition(int sample) { mOffset = sample; }
    float GetSampleRateRatio() const { return mSampleRateRatio; }
@@ -46,19 +63,33 @@ public:
    bool IsPlaying() { return mOffset < mNumSamples; }
    void LockDataMutex(bool lock) { lock ? mDataMutex.lock() : mDataMutex.unlock(); }
    void Create(int length);
-   void Create(ChannelBuffer* data);
+   void Create(const ChannelBuffer* data);
    void SetLooping(bool looping) { mLooping = looping; }
    void SetNumBars(int numBars) { mNumBars = numBars; }
    int GetNumBars() const { return mNumBars; }
    void SetVolume(float vol) { mVolume = vol; }
    void CopyFrom(Sample* sample);
+   //trades the audio and where it came from with other, without copying. for swapping in a sample that was loaded in the background
+   void SwapData(Sample& other);
    
    void SaveState(FileStreamOut& out);
    void LoadState(FileStreamIn& in);
+   
+   static const int kStreamingThresholdSeconds = 30;
 private:
    void Setup(int length);
+   bool OpenStream(const char* path);
+   void ShareData(SampleCache::EntryPtr entry);
+   void ReleaseSharedData();
+   void SetStream(SampleStream* stream);
+   void ConsumeWindowedData(double time, ChannelBuffer* out, int size, bool replace, float end);
+   void ReadPlaybackWindow(int start, ChannelBuffer* window, int length);
+   void ReadPlaybackSource(int position, ChannelBuffer* out, int numSamples, int outOffset);
    
    ChannelBuffer mData;
+   SampleCache::EntryPtr mShared;   //set while mData points into the cache
+   SampleStream* mStream;
+   SampleFormat mStorageFormat;
    int mNumSamples;
    double mStartTime;
    double mOffset;
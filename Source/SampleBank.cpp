@@ -12,15 +12,26 @@
 #include "ModularSynth.h"
 
 SampleBank::SampleBank()
-: mSamplesDropdown(nullptr)
+: mNumLoading(0)
+, mSamplesDropdown(nullptr)
 , mSampleIdx(-1)
 {
 }
 
 SampleBank::~SampleBank()
+{
+   ClearSamples();
+}
+
+void SampleBank::ClearSamples()
 {
    for (int i=0; i<mSamples.size(); ++i)
+   {
+      TheSynth->GetSampleLoader()->Cancel(mSamples[i].mSample);
       delete mSamples[i].mSample;
+   }
+   mSamples.clear();
+   mNumLoading = 0;
 }
 
 void SampleBank::CreateUIControls()
@@ -68,9 +79,7 @@ bool SampleSorter(const SampleInfo& info1, const SampleInfo& info2)
 
 void SampleBank::LoadList(const char* filename)
 {
-   for (int i=0; i<mSamples.size(); ++i)
-      delete mSamples[i].mSample;
-   mSamples.clear();
+   ClearSamples();
    mSamplesDropdown->Clear();
    
    ifstream fin(ofToDataPath(filename).c_str());
@@ -91,8 +100,15 @@ void SampleBank::LoadList(const char* filename)
             float vol = atoi(tokens[3].c_str());
             string type = tokens[4];
 
+            //empty until the loader swaps the audio in
             Sample* sample = new Sample();
-            sample->Read(wavFile.c_str());
+            ++mNumLoading;
+            TheSynth->GetSampleLoader()->Load(sample, wavFile, SampleLoader::kPriority_Background, [this, sample](Sample* loaded)
+            {
+               if (loaded)
+                  sample->SwapData(*loaded);
+               OnSampleLoaded();
+            });
 
             SampleInfo info;
             info.mSample = sample;
@@ -102,7 +118,7 @@ void SampleBank::LoadList(const char* filename)
             info.mType = type;
 
             mSamples.push_back(info);
-            mSamplesDropdown->AddLabel(sample->Name(), (int)mSamples.size()-1);
+            mSamplesDropdown->AddLabel(File(wavFile).getFileNameWithoutExtension().toStdString(), (int)mSamples.size()-1);
          }
       }
       fin.close();
@@ -110,8 +126,21 @@ void SampleBank::LoadList(const char* filename)
    
    //sort(mSamples.begin(), mSamples.end(), SampleSorter);
    
-   for (ISampleBankListener* listener : mListeners)
-      listener->OnSamplesLoaded(this);
+   if (mNumLoading == 0)
+   {
+      for (ISampleBankListener* listener : mListeners)
+         listener->OnSamplesLoaded(this);
+   }
+}
+
+void SampleBank::OnSampleLoaded()
+{
+   --mNumLoading;
+   if (mNumLoading == 0)
+   {
+      for (ISampleBankListener* listener : mListeners)
+         listener->OnSamplesLoaded(this);
+   }
 }
 
 const SampleInfo& SampleBank::GetSampleInfo(int index)
@@ -124,7 +153,7 @@ const SampleInfo& SampleBank::GetSampleInfo(int index)
 void SampleBank::AddListener(ISampleBankListener* listener)
 {
    mListeners.push_back(listener);
-   if (!mSamples.empty()) //already loaded
+   if (!mSamples.empty() && mNumLoading == 0) //already loaded
       listener->OnSamplesLoaded(this);
 }
 
@@ -136,11 +165,17 @@ void SampleBank::RemoveListener(ISampleBankListener* listener)
 void SampleBank::FilesDropped(vector<string> files, int x, int y)
 {
    Sample* sample = new Sample();
-   sample->Read(files[0].c_str());
+   TheSynth->GetSampleLoader()->Load(sample, files[0], SampleLoader::kPriority_Normal, [sample](Sample* loaded)
+   {
+      if (loaded)
+      {
+         sample->SwapData(*loaded);
+         sample->SetNumBars(int(sample->LengthInSamples() / gSampleRate * .5f));
+      }
+   });
 
    SampleInfo info;
    info.mSample = sample;
-   sample->SetNumBars(int(sample->LengthInSamples() / gSampleRate * .5f));
    info.mOffset = 0;
    info.mVol = 1;
    info.mType = "sample";
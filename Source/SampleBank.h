@@ -62,7 +62,11 @@ private:
    void GetModuleDimensions(float& width, float& height) override { width=200; height=80; }
    void OnClicked(int x, int y, bool right) override;
    
+   void ClearSamples();
+   void OnSampleLoaded();
+   
    vector<SampleInfo> mSamples;
+   int mNumLoading;
    list<ISampleBankListener*> mListeners;
    
    DropdownList* mSamplesDropdown;
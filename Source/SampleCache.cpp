@@ -0,0 +1,144 @@
+/*
+  ==============================================================================
+
+    SampleCache.cpp
+    Created: 17 Oct 2026 10:47:09pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "SampleCache.h"
+
+SampleCache::SampleCache()
+: mBytesUsed(0)
+, mMemoryBudget(kDefaultMemoryBudget)
+, mUseCounter(0)
+{
+}
+
+int64 SampleCache::Entry::GetBytes() const
+{
+   return int64(mData.BufferSize()) * mData.NumActiveChannels() * sizeof(float) +
+          mCompact.GetBytes() +
+          int64(mOverview.BufferSize()) * mOverview.NumActiveChannels() * sizeof(float);
+}
+
+//static
+string SampleCache::GetKey(const File& file, bool mono, SampleFormat format)
+{
+   string key = file.getFullPathName().toStdString() + (mono ? "|mono" : "");
+   if (format == kSampleFormat_Int16)
+      key += "|int16";
+   if (format == kSampleFormat_Half)
+      key += "|half";
+   return key;
+}
+
+bool SampleCache::IsCurrent(const Slot& slot, const File& file) const
+{
+   return slot.mFileSize == file.getSize() && slot.mModifiedMs == file.getLastModificationTime().toMilliseconds();
+}
+
+SampleCache::EntryPtr SampleCache::Find(const File& file, bool mono, SampleFormat format)
+{
+   const ScopedLock lock(mLock);
+   auto slot = mSlots.find(GetKey(file, mono, format));
+   if (slot == mSlots.end())
+      return nullptr;
+
+   if (!IsCurrent(slot->second, file))
+   {
+      //changed on disk. whoever still has the old audio keeps it, but nobody new gets it
+      Remove(slot);
+      return nullptr;
+   }
+
+   slot->second.mLastUsed = ++mUseCounter;
+   return slot->second.mEntry;
+}
+
+SampleCache::EntryPtr SampleCache::Add(const File& file, bool mono, SampleFormat format, ChannelBuffer& data, int numSamples, float sampleRateRatio)
+{
+   const ScopedLock lock(mLock);
+   string key = GetKey(file, mono, format);
+   auto existing = mSlots.find(key);
+   if (existing != mSlots.end())
+   {
+      if (IsCurrent(existing->second, file))
+      {
+         existing->second.mLastUsed = ++mUseCounter;
+         return existing->second.mEntry;
+      }
+      Remove(existing);
+   }
+
+   EntryPtr entry = MakeEntry(data, numSamples, sampleRateRatio, format);
+
+   Slot slot;
+   slot.mEntry = entry;
+   slot.mFileSize = file.getSize();
+   slot.mModifiedMs = file.getLastModificationTime().toMilliseconds();
+   slot.mBytes = entry->GetBytes();
+   slot.mLastUsed = ++mUseCounter;
+   mSlots[key] = slot;
+   mBytesUsed += slot.mBytes;
+
+   EvictUnused();
+   return entry;
+}
+
+//static
+SampleCache::EntryPtr SampleCache::MakeEntry(ChannelBuffer& data, int numSamples, float sampleRateRatio, SampleFormat format)
+{
+   EntryPtr entry = std::make_shared<Entry>();
+   entry->mNumSamples = numSamples;
+   entry->mSampleRateRatio = sampleRateRatio;
+   if (format == kSampleFormat_Float)
+   {
+      entry->mData.Swap(data);
+      return entry;
+   }
+
+   int numChannels = data.NumActiveChannels();
+   entry->mCompact.Set(format, &data, numSamples);
+   ChannelBuffer empty(0);
+   data.Swap(empty);   //done with the float audio
+
+   int overviewLength = MIN(numSamples, kOverviewLength);
+   entry->mOverview.Resize(overviewLength);
+   entry->mOverview.SetNumActiveChannels(numChannels);
+   for (int ch=0; ch<numChannels; ++ch)
+      entry->mCompact.GetPeaks(ch, 0, numSamples, entry->mOverview.GetChannel(ch), overviewLength);
+   return entry;
+}
+
+void SampleCache::SetMemoryBudget(int64 bytes)
+{
+   const ScopedLock lock(mLock);
+   mMemoryBudget = bytes;
+   EvictUnused();
+}
+
+void SampleCache::Remove(std::map<string, Slot>::iterator slot)
+{
+   mBytesUsed -= slot->second.mBytes;
+   mSlots.erase(slot);
+}
+
+void SampleCache::EvictUnused()
+{
+   //only entries that nothing but the cache holds can go, audio a Sample is using stays in memory regardless
+   while (mBytesUsed > mMemoryBudget)
+   {
+      auto oldest = mSlots.end();
+      for (auto slot = mSlots.begin(); slot != mSlots.end(); ++slot)
+      {
+         if (slot->second.mEntry.use_count() == 1 && (oldest == mSlots.end() || slot->second.mLastUsed < oldest->second.mLastUsed))
+            oldest = slot;
+      }
+      if (oldest == mSlots.end())
+         break;
+      Remove(oldest);
+   }
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    SampleCache.h
+    Created: 17 Oct 2026 10:47:09pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OpenFrameworksPort.h"
+#include "ChannelBuffer.h"
+#include "SampleStorage.h"
+#include <map>
+#include <memory>
+
+//decoded sample files, shared by every Sample that reads the same file, so a kit loaded twice is decoded and stored once.
+//entries are keyed by path, and are dropped if the file's size or modification time has changed since it was decoded.
+//the audio in an entry is read only. a Sample that needs to write to it takes its own copy first, see Sample::EditData().
+//entries nobody is using any more stay cached until the cache goes over its memory budget, least recently used first.
+//a file read in a compact SampleFormat gets its own entry, holding just the compact audio plus an overview to draw.
+class SampleCache
+{
+public:
+   struct Entry
+   {
+      Entry() : mData(0), mOverview(0), mNumSamples(0), mSampleRateRatio(1) {}
+      bool IsCompact() const { return mCompact.GetFormat() != kSampleFormat_Float; }
+      int64 GetBytes() const;
+      ChannelBuffer mData;   //float audio, empty if compact
+      SampleStorage mCompact;   //compact audio
+      ChannelBuffer mOverview;   //peaks of the compact audio
+      int mNumSamples;
+      float mSampleRateRatio;
+   };
+   typedef std::shared_ptr<Entry> EntryPtr;
+
+   SampleCache();
+
+   //any thread. nullptr if file isn't cached, or has changed since it was
+   EntryPtr Find(const File& file, bool mono, SampleFormat format);
+   //any thread. takes over data (leaving it empty) as the decoded audio for file, converting it to format.
+   //if another thread cached the same file meanwhile, returns that entry instead and data is left alone
+   EntryPtr Add(const File& file, bool mono, SampleFormat format, ChannelBuffer& data, int numSamples, float sampleRateRatio);
+   //an entry that isn't cached, for audio that didn't come from a file
+   static EntryPtr MakeEntry(ChannelBuffer& data, int numSamples, float sampleRateRatio, SampleFormat format);
+
+   void SetMemoryBudget(int64 bytes);
+   int64 GetMemoryUsed() const { return mBytesUsed; }
+
+   static const int64 kDefaultMemoryBudget = 512 * 1024 * 1024;
+   static const int kOverviewLength = 4096;
+
+private:
+   struct Slot
+   {
+      EntryPtr mEntry;
+      int64 mFileSize;
+      int64 mModifiedMs;
+      int64 mBytes;
+      uint32 mLastUsed;
+   };
+
+   static string GetKey(const File& file, bool mono, SampleFormat format);
+   bool IsCurrent(const Slot& slot, const File& file) const;
+   void Remove(std::map<string, Slot>::iterator slot);   //with mLock held
+   void EvictUnused();   //with mLock held
+
+   CriticalSection mLock;
+   std::map<string, Slot> mSlots;
+   int64 mBytesUsed;
+   int64 mMemoryBudget;
+   uint32 mUseCounter;
+};
@@ -15,6 +15,7 @@
 #include "CanvasElement.h"
 #include "Profiler.h"
 #include "Sample.h"
+#include "ScratchArena.h"
 
 SampleCanvas::SampleCanvas()
 : mCanvas(nullptr)
@@ -57,7 +58,9 @@ void SampleCanvas::Process(double time)
    float* out = GetTarget()->GetBuffer()->GetChannel(0);
    assert(bufferSize == gBufferSize);
    
-   Clear(gWorkBuffer, bufferSize);
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
+   Clear(workBuffer, bufferSize);
    
    const vector<CanvasElement*>& elements = mCanvas->GetElements();
    for (int elemIdx = 0; elemIdx < elements.size(); ++elemIdx)
@@ -89,12 +92,12 @@ void SampleCanvas::Process(double time)
          
          //TODO(Ryan) multichannel
          if (sample >= 0 && sample < clip->LengthInSamples() * numLoops)
-            gWorkBuffer[i] += GetInterpolatedSample(sample, clip->Data()->GetChannel(0), clip->LengthInSamples());
+            workBuffer[i] += GetInterpolatedSample(sample, clip->Data()->GetChannel(0), clip->LengthInSamples());
       }
    }
    
-   Add(out, gWorkBuffer, bufferSize);
-   GetVizBuffer()->WriteChunk(gWorkBuffer, bufferSize, 0);
+   Add(out, workBuffer, bufferSize);
+   GetVizBuffer()->WriteChunk(workBuffer, bufferSize, 0);
 }
 
 void SampleCanvas::OnClicked(int x, int y, bool right)
@@ -16,6 +16,7 @@
 #include "FillSaveDropdown.h"
 #include "PatchCableSource.h"
 #include "Scale.h"
+#include "ScratchArena.h"
 
 SampleEditor::SampleEditor()
 : mVolume(1)
@@ -111,10 +112,12 @@ void SampleEditor::Process(double time)
       RecalcPos();
    mSample->SetRate(speed);
 
-   gWorkChannelBuffer.SetNumActiveChannels(mSample->NumChannels());
-   if (mSample->ConsumeData(time, &gWorkChannelBuffer, bufferSize, true))
+   ScratchArena::Scope scratch;
+   ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+   workBuffer->SetNumActiveChannels(mSample->NumChannels());
+   if (mSample->ConsumeData(time, workBuffer, bufferSize, true))
    {
-      for (int ch=0; ch<gWorkChannelBuffer.NumActiveChannels(); ++ch)
+      for (int ch=0; ch<workBuffer->NumActiveChannels(); ++ch)
       {
          float pitchShift = mPitchShift;
          if (mKeepPitch)
@@ -124,17 +127,17 @@ void SampleEditor::Process(double time)
          if (pitchShift != 1)
          {
             mPitchShifter[ch]->SetRatio(pitchShift);
-            mPitchShifter[ch]->Process(gWorkChannelBuffer.GetChannel(ch), bufferSize);
+            mPitchShifter[ch]->Process(workBuffer->GetChannel(ch), bufferSize);
          }
          
-         Mult(gWorkChannelBuffer.GetChannel(ch), volSq, bufferSize);
-         Add(GetTarget()->GetBuffer()->GetChannel(ch), gWorkChannelBuffer.GetChannel(ch), bufferSize);
-         GetVizBuffer()->WriteChunk(gWorkChannelBuffer.GetChannel(ch), bufferSize, ch);
+         Mult(workBuffer->GetChannel(ch), volSq, bufferSize);
+         Add(GetTarget()->GetBuffer()->GetChannel(ch), workBuffer->GetChannel(ch), bufferSize);
+         GetVizBuffer()->WriteChunk(workBuffer->GetChannel(ch), bufferSize, ch);
       }
    }
    else
    {
-      for (int ch=0; ch<gWorkChannelBuffer.NumActiveChannels(); ++ch)
+      for (int ch=0; ch<workBuffer->NumActiveChannels(); ++ch)
          GetVizBuffer()->WriteChunk(gZeroBuffer, bufferSize, ch);
    }
 }
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+    SampleLoader.cpp
+    Created: 17 Oct 2026 9:14:26pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "SampleLoader.h"
+#include "Sample.h"
+
+SampleLoader::SampleLoader()
+: mNumDecoding(0)
+, mNextSequence(0)
+{
+}
+
+SampleLoader::~SampleLoader()
+{
+   StopWorkers();
+   for (auto& request : mFinished)
+      delete request.mResult;
+}
+
+void SampleLoader::SetNumThreads(int numThreads)
+{
+   if (numThreads == (int)mWorkers.size())
+      return;
+   
+   StopWorkers();
+   for (int i=0; i<numThreads; ++i)
+   {
+      Worker* worker = new Worker(this, i);
+      worker->startThread(3);   //below normal, decoding shouldn't compete with the ui
+      mWorkers.push_back(worker);
+   }
+}
+
+void SampleLoader::StopWorkers()
+{
+   for (auto* worker : mWorkers)
+      worker->signalThreadShouldExit();
+   for (auto* worker : mWorkers)
+   {
+      worker->stopThread(5000);   //lets a file that's being decoded finish
+      delete worker;
+   }
+   mWorkers.clear();
+}
+
+void SampleLoader::Load(const void* key, string path, Priority priority, LoadedFn onLoaded, bool mono, bool allowStreaming, SampleFormat format)
+{
+   Request request;
+   request.mKey = key;
+   request.mPath = path;
+   request.mPriority = priority;
+   request.mMono = mono;
+   request.mAllowStreaming = allowStreaming;
+   request.mFormat = ResolveSampleFormat(format);   //on the calling thread rather than a worker
+   request.mOnLoaded = onLoaded;
+   request.mResult = nullptr;
+   
+   {
+      const ScopedLock lock(mLock);
+      request.mSequence = ++mNextSequence;
+      mLatestRequest[key] = request.mSequence;
+      
+      RemoveRequestsFor(key);
+      auto insertAt = mPending.begin();
+      while (insertAt != mPending.end() && insertAt->mPriority >= priority)
+         ++insertAt;
+      mPending.insert(insertAt, request);
+   }
+   
+   mWorkAvailable.signal();
+}
+
+void SampleLoader::Cancel(const void* key)
+{
+   const ScopedLock lock(mLock);
+   mLatestRequest.erase(key);
+   RemoveRequestsFor(key);
+}
+
+void SampleLoader::RemoveRequestsFor(const void* key)
+{
+   mPending.remove_if([key](const Request& pending) { return pending.mKey == key; });
+   for (auto iter = mFinished.begin(); iter != mFinished.end(); )
+   {
+      if (iter->mKey == key)
+      {
+         delete iter->mResult;
+         iter = mFinished.erase(iter);
+      }
+      else
+      {
+         ++iter;
+      }
+   }
+}
+
+bool SampleLoader::IsLoading(const void* key) const
+{
+   const ScopedLock lock(mLock);
+   return mLatestRequest.find(key) != mLatestRequest.end();
+}
+
+bool SampleLoader::TakeNextRequest(Request& request)
+{
+   const ScopedLock lock(mLock);
+   if (mPending.empty())
+      return false;
+   request = mPending.front();
+   mPending.pop_front();
+   ++mNumDecoding;
+   return true;
+}
+
+void SampleLoader::Decode(Request& request)
+{
+   Sample* sample = new Sample();
+   sample->SetStorageFormat(request.mFormat);
+   if (!sample->Read(request.mPath.c_str(), request.mMono, request.mAllowStreaming))
+   {
+      delete sample;
+      sample = nullptr;
+   }
+   
+   {
+      const ScopedLock lock(mLock);
+      --mNumDecoding;
+      auto latest = mLatestRequest.find(request.mKey);
+      if (latest != mLatestRequest.end() && latest->second == request.mSequence)
+      {
+         request.mResult = sample;
+         mFinished.push_back(request);
+         sample = nullptr;
+      }
+   }
+   delete sample;   //superseded or cancelled while we were reading it
+   
+   mWorkFinished.signal();
+}
+
+void SampleLoader::Poll()
+{
+   if (mWorkers.empty())
+   {
+      Request request;
+      while (TakeNextRequest(request))
+         Decode(request);
+   }
+   
+   std::list<Request> finished;
+   {
+      const ScopedLock lock(mLock);
+      finished.swap(mFinished);
+      for (const auto& request : finished)
+      {
+         auto latest = mLatestRequest.find(request.mKey);
+         if (latest != mLatestRequest.end() && latest->second == request.mSequence)
+            mLatestRequest.erase(latest);
+      }
+   }
+   
+   for (auto& request : finished)
+   {
+      request.mOnLoaded(request.mResult);
+      delete request.mResult;
+   }
+}
+
+void SampleLoader::Flush()
+{
+   while (true)
+   {
+      Poll();
+      
+      {
+         const ScopedLock lock(mLock);
+         if (mPending.empty() && mFinished.empty() && mNumDecoding == 0)
+            break;
+      }
+      
+      mWorkFinished.wait(10);
+   }
+}
+
+SampleLoader::Worker::Worker(SampleLoader* owner, int index)
+: Thread("sample loader " + String(index))
+, mOwner(owner)
+{
+}
+
+void SampleLoader::Worker::run()
+{
+   while (!threadShouldExit())
+   {
+      Request request;
+      if (mOwner->TakeNextRequest(request))
+         mOwner->Decode(request);
+      else
+         mOwner->mWorkAvailable.wait(50);
+   }
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+    Created: 17 Oct 2026 9:14:26pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OpenFrameworksPort.h"
+#include "SampleStorage.h"
+#include <functional>
+#include <list>
+#include <map>
+
+class Sample;
+
+//decodes sample files on a pool of background threads, so loading a kit or dropping in a file doesn't stall the ui or audio thread.
+//pending requests are decoded highest priority first. a finished sample is handed to its callback on the ui thread from Poll(),
+//and the callback swaps it into place with Sample::SwapData() under whatever lock guards playback, so playback never waits on disk.
+//requests are identified by a key, usually the Sample they'll end up in. a new request for a key replaces the old one.
+class SampleLoader
+{
+public:
+   enum Priority
+   {
+      kPriority_Background,
+      kPriority_Normal,
+      kPriority_Audible    //playing now, or about to be heard
+   };
+   
+   //ui thread. loaded is nullptr if the file couldn't be read, and is freed once the callback returns
+   typedef std::function<void(Sample* loaded)> LoadedFn;
+   
+   SampleLoader();
+   ~SampleLoader();
+   
+   //0 decodes on the ui thread inside Poll()
+   void SetNumThreads(int numThreads);
+   
+   //allowStreaming as in Sample::Read(), long files come back as streams. format as in Sample::SetStorageFormat()
+   void Load(const void* key, string path, Priority priority, LoadedFn onLoaded, bool mono = false, bool allowStreaming = false, SampleFormat format = kSampleFormat_Float);
+   //drops anything pending or in flight for key. call before whatever the callback touches goes away
+   void Cancel(const void* key);
+   bool IsLoading(const void* key) const;
+   
+   //ui thread
+   void Poll();
+   //ui thread. waits until everything requested so far has been loaded and delivered, for offline rendering
+   void Flush();
+   
+private:
+   struct Request
+   {
+      const void* mKey;
+      string mPath;
+      Priority mPriority;
+      bool mMono;
+      bool mAllowStreaming;
+      SampleFormat mFormat;
+      LoadedFn mOnLoaded;
+      int mSequence;
+      Sample* mResult;
+   };
+   
+   class Worker : public Thread
+   {
+   public:
+      Worker(SampleLoader* owner, int index);
+      void run() override;
+   private:
+      SampleLoader* mOwner;
+   };
+   
+   bool TakeNextRequest(Request& request);
+   void RemoveRequestsFor(const void* key);   //with mLock held
+   void Decode(Request& request);
+   void StopWorkers();
+   
+   CriticalSection mLock;
+   WaitableEvent mWorkAvailable;
+   WaitableEvent mWorkFinished;
+   std::list<Request> mPending;    //highest priority first, in request order within a priority
+   std::list<Request> mFinished;
+   std::map<const void*, int> mLatestRequest;   //sequence of the request that's current for each key, results from any other are dropped
+   int mNumDecoding;
+   int mNextSequence;
+   vector<Worker*> mWorkers;
+};
@@ -14,11 +14,13 @@
 #include "SampleBank.h"
 #include "SynthGlobals.h"
 #include "ModularSynth.h"
+#include "SampleStream.h"
 #include "Profiler.h"
 #include "FillSaveDropdown.h"
 #include "PatchCableSource.h"
 #include "Scale.h"
 #include "UIControlMacros.h"
+#include "ScratchArena.h"
 
 SamplePlayer::SamplePlayer()
 : mVolume(1)
@@ -91,6 +93,7 @@ void SamplePlayer::CreateUIControls()
 
 SamplePlayer::~SamplePlayer()
 {
+   TheSynth->GetSampleLoader()->Cancel(this);
    if (mOwnsSample)
       delete mSample;
 }
@@ -150,20 +153,22 @@ void SamplePlayer::Process(double time)
    }
    mSample->SetRate(mPlaySpeed);
    
-   gWorkChannelBuffer.SetNumActiveChannels(mSample->NumChannels());
-   if (mPlay && mSample->ConsumeData(time, &gWorkChannelBuffer, bufferSize, true))
+   ScratchArena::Scope scratch;
+   ChannelBuffer* workBuffer = scratch.GetChannelBuffer();
+   workBuffer->SetNumActiveChannels(mSample->NumChannels());
+   if (mPlay && mSample->ConsumeData(time, workBuffer, bufferSize, true))
    {
-      for (int ch=0; ch<gWorkChannelBuffer.NumActiveChannels(); ++ch)
+      for (int ch=0; ch<workBuffer->NumActiveChannels(); ++ch)
       {
          for (int i=0; i<bufferSize; ++i)
-            gWorkChannelBuffer.GetChannel(ch)[i] *= volSq * mAdsr.Value(time + i * gInvSampleRateMs);
-         Add(GetTarget()->GetBuffer()->GetChannel(ch), gWorkChannelBuffer.GetChannel(ch), bufferSize);
-         GetVizBuffer()->WriteChunk(gWorkChannelBuffer.GetChannel(ch), bufferSize, ch);
+            workBuffer->GetChannel(ch)[i] *= volSq * mAdsr.Value(time + i * gInvSampleRateMs);
+         Add(GetTarget()->GetBuffer()->GetChannel(ch), workBuffer->GetChannel(ch), bufferSize);
+         GetVizBuffer()->WriteChunk(workBuffer->GetChannel(ch), bufferSize, ch);
       }
    }
    else
    {
-      for (int ch=0; ch<gWorkChannelBuffer.NumActiveChannels(); ++ch)
+      for (int ch=0; ch<workBuffer->NumActiveChannels(); ++ch)
          GetVizBuffer()->WriteChunk(gZeroBuffer, bufferSize, ch);
       mAdsr.Stop(time);
    }
@@ -224,15 +229,26 @@ void SamplePlayer::DropdownUpdated(DropdownList* list, int oldVal)
 {
    if (list == mSampleList)
    {
+      TheSynth->GetSampleLoader()->Cancel(this);   //so a file still loading doesn't replace the one just picked
       UpdateSample(mBank->GetSampleInfo(mSampleIndex).mSample, false);
    }
 }
 
 void SamplePlayer::FilesDropped(vector<string> files, int x, int y)
 {
-   Sample* sample = new Sample();
-   sample->Read(files[0].c_str());
-   UpdateSample(sample, true);
+   LoadSampleFile(files[0]);
+}
+
+void SamplePlayer::LoadSampleFile(string path)
+{
+   TheSynth->GetSampleLoader()->Load(this, path, SampleLoader::kPriority_Normal, [this](Sample* loaded)
+   {
+      if (loaded == nullptr)
+         return;
+      Sample* sample = new Sample();
+      sample->SwapData(*loaded);
+      UpdateSample(sample, true);
+   }, false, true);
 }
 
 void SamplePlayer::UpdateSample(Sample* sample, bool ownsSample)
@@ -248,9 +264,11 @@ void SamplePlayer::UpdateSample(Sample* sample, bool ownsSample)
    mPlay = false;
    mOwnsSample = ownsSample;
    
+   //a streamed sample is drawn from its overview, rather than copying a file we're avoiding holding in memory
+   const ChannelBuffer* drawSource = mSample->GetDrawData();
    mSample->LockDataMutex(true);
-   mDrawBuffer.Resize(mSample->LengthInSamples());
-   mDrawBuffer.CopyFrom(mSample->Data());
+   mDrawBuffer.Resize(drawSource->BufferSize());
+   mDrawBuffer.CopyFrom(drawSource);
    mSample->LockDataMutex(false);
    
    float lengthSeconds = mSample->LengthInSamples() / (gSampleRate * mSample->GetSampleRateRatio());
@@ -318,6 +336,7 @@ void SamplePlayer::DownloadYoutube(string search, string options)
    Sample* sample = new Sample();
    if (juce::File(ofToDataPath("youtube.wav")).existsAsFile())
       sample->Read(ofToDataPath("youtube.wav").c_str());
+   TheSynth->GetSampleLoader()->Cancel(this);
    UpdateSample(sample, true);
 }
 
@@ -328,11 +347,8 @@ void SamplePlayer::LoadFile()
    if (chooser.browseForFileToOpen())
    {
       auto file = chooser.getResult();
-
-      Sample* sample = new Sample();
       if (file.existsAsFile())
-         sample->Read(file.getFullPathName().toStdString().c_str());
-      UpdateSample(sample, true);
+         LoadSampleFile(file.getFullPathName().toStdString());
    }
 }
 
@@ -425,7 +441,10 @@ void SamplePlayer::DrawModule()
    if (mSample)
    {
       float sampleWidth = mWidth - 10;
-      DrawAudioBuffer(sampleWidth, mHeight - 65, &mDrawBuffer, 0, mDrawBuffer.BufferSize(), mSample->GetPlayPosition());
+      int playPosition = mSample->GetPlayPosition();
+      if (mSample->IsStreaming())
+         playPosition = int(float(playPosition) / MAX(1, mSample->LengthInSamples()) * mDrawBuffer.BufferSize());
+      DrawAudioBuffer(sampleWidth, mHeight - 65, &mDrawBuffer, 0, mDrawBuffer.BufferSize(), playPosition);
       
       ofPushStyle();
       ofFill();
@@ -590,6 +609,7 @@ void SamplePlayer::LoadState(FileStreamIn& in)
    {
       Sample* sample = new Sample();
       sample->LoadState(in);
+      TheSynth->GetSampleLoader()->Cancel(this);
       UpdateSample(sample, true);
    }
    
@@ -71,6 +71,7 @@ public:
    
 private:
    void UpdateSample(Sample* sample, bool ownsSample);
+   void LoadSampleFile(string path);
    void UpdateSampleList();
    float GetPlayPositionForMouse(float mouseX) const;
    void GetPlayInfoForPitch(int pitch, float& startSeconds, float& lengthSeconds, float& speed) const;
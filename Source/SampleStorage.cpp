@@ -0,0 +1,251 @@
+/*
+  ==============================================================================
+
+    SampleStorage.cpp
+    Created: 17 Oct 2026 11:38:14pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "SampleStorage.h"
+#include "ModularSynth.h"
+#include "ScratchArena.h"
+
+EnumMap GetSampleFormatEnumMap()
+{
+   EnumMap map;
+   map["default"] = kSampleFormat_Default;
+   map["float"] = kSampleFormat_Float;
+   map["int16"] = kSampleFormat_Int16;
+   map["half"] = kSampleFormat_Half;
+   return map;
+}
+
+SampleFormat ResolveSampleFormat(SampleFormat format)
+{
+   if (format == kSampleFormat_Default)
+      return TheSynth->GetDefaultSampleFormat();
+   return format;
+}
+
+int16_t FloatToInt16(float value)
+{
+   return int16_t(lroundf(ofClamp(value, -1, 1) * 32767));
+}
+
+uint16_t FloatToHalf(float value)
+{
+   uint32_t bits;
+   memcpy(&bits, &value, 4);
+   uint32_t sign = bits & 0x80000000u;
+   bits ^= sign;
+
+   uint16_t half;
+   if (bits >= (143u << 23))   //too big for a half, or inf or nan already
+   {
+      half = bits > (255u << 23) ? 0x7e00 : 0x7c00;
+   }
+   else if (bits < (113u << 23))   //comes out denormal. adding .5 lines the mantissa up and lets the fpu do the rounding
+   {
+      float f;
+      memcpy(&f, &bits, 4);
+      f += .5f;
+      memcpy(&bits, &f, 4);
+      half = uint16_t(bits - (126u << 23));
+   }
+   else
+   {
+      uint32_t mantissaOdd = (bits >> 13) & 1;
+      bits -= 112u << 23;
+      bits += 0xfff + mantissaOdd;
+      half = uint16_t(bits >> 13);
+   }
+   return half | uint16_t(sign >> 16);
+}
+
+SampleStorage::SampleStorage()
+: mFormat(kSampleFormat_Float)
+, mNumChannels(0)
+, mLength(0)
+{
+   for (int ch=0; ch<ChannelBuffer::kMaxNumChannels; ++ch)
+      mChannels[ch] = nullptr;
+}
+
+SampleStorage::~SampleStorage()
+{
+   Free();
+}
+
+void SampleStorage::Free()
+{
+   for (int ch=0; ch<ChannelBuffer::kMaxNumChannels; ++ch)
+   {
+      delete[] mChannels[ch];
+      mChannels[ch] = nullptr;
+   }
+}
+
+void SampleStorage::Reset(SampleFormat format, int numChannels, int length)
+{
+   assert(format != kSampleFormat_Default);
+   Free();
+   mFormat = format;
+   mNumChannels = MIN(numChannels, ChannelBuffer::kMaxNumChannels);
+   mLength = length;
+   int bytes = length * GetSampleSize(format);
+   for (int ch=0; ch<mNumChannels; ++ch)
+   {
+      mChannels[ch] = new char[bytes];
+      memset(mChannels[ch], 0, bytes);   //all zero bits is silence in every format
+   }
+}
+
+void SampleStorage::Set(SampleFormat format, ChannelBuffer* data, int length)
+{
+   Reset(format, data->NumActiveChannels(), length);
+   for (int ch=0; ch<mNumChannels; ++ch)
+      Write(ch, 0, data->GetChannel(ch), length);
+}
+
+void SampleStorage::SetFormat(SampleFormat format)
+{
+   if (format == mFormat)
+      return;
+
+   SampleStorage converted;
+   converted.Reset(format, mNumChannels, mLength);
+   ScratchArena::Scope scratch;
+   float* chunk = scratch.GetBuffer();
+   for (int ch=0; ch<mNumChannels; ++ch)
+   {
+      for (int pos=0; pos<mLength; pos += kWorkBufferSize)
+      {
+         int length = MIN(kWorkBufferSize, mLength - pos);
+         Decode(ch, pos, chunk, length);
+         converted.Write(ch, pos, chunk, length);
+      }
+   }
+   Swap(converted);
+}
+
+void SampleStorage::Clear()
+{
+   for (int ch=0; ch<mNumChannels; ++ch)
+      memset(mChannels[ch], 0, mLength * GetSampleSize(mFormat));
+}
+
+void SampleStorage::Swap(SampleStorage& other)
+{
+   std::swap(mFormat, other.mFormat);
+   std::swap(mNumChannels, other.mNumChannels);
+   std::swap(mLength, other.mLength);
+   for (int ch=0; ch<ChannelBuffer::kMaxNumChannels; ++ch)
+      std::swap(mChannels[ch], other.mChannels[ch]);
+}
+
+void SampleStorage::SetSample(int channel, int index, float value)
+{
+   switch (mFormat)
+   {
+      case kSampleFormat_Int16: ((int16_t*)mChannels[channel])[index] = FloatToInt16(value); break;
+      case kSampleFormat_Half: ((uint16_t*)mChannels[channel])[index] = FloatToHalf(value); break;
+      default: ((float*)mChannels[channel])[index] = value; break;
+   }
+}
+
+void SampleStorage::Write(int channel, int start, const float* data, int length)
+{
+   assert(start >= 0 && start + length <= mLength);
+   //encoding happens once per load, off the audio thread, so it isn't worth vectorizing
+   switch (mFormat)
+   {
+      case kSampleFormat_Int16:
+      {
+         int16_t* dest = (int16_t*)mChannels[channel] + start;
+         for (int i=0; i<length; ++i)
+            dest[i] = FloatToInt16(data[i]);
+         break;
+      }
+      case kSampleFormat_Half:
+      {
+         uint16_t* dest = (uint16_t*)mChannels[channel] + start;
+         for (int i=0; i<length; ++i)
+            dest[i] = FloatToHalf(data[i]);
+         break;
+      }
+      default:
+         BufferCopy((float*)mChannels[channel] + start, data, length);
+         break;
+   }
+}
+
+void SampleStorage::Decode(int channel, int start, float* out, int length) const
+{
+   assert(start >= 0 && start + length <= mLength);
+   int i = 0;
+   switch (mFormat)
+   {
+      case kSampleFormat_Int16:
+      {
+         const int16_t* in = (const int16_t*)mChannels[channel] + start;
+         const Float4 scale = Float4::Set(1.0f / 32767);
+         for (; i+4<=length; i+=4)
+            (Float4::LoadInt16(in + i) * scale).Store(out + i);
+         for (; i<length; ++i)
+            out[i] = in[i] * (1.0f / 32767);
+         break;
+      }
+      case kSampleFormat_Half:
+      {
+         const uint16_t* in = (const uint16_t*)mChannels[channel] + start;
+         for (; i+4<=length; i+=4)
+            Float4::LoadHalf(in + i).Store(out + i);
+         for (; i<length; ++i)
+            out[i] = HalfToFloat(in[i]);
+         break;
+      }
+      default:
+         BufferCopy(out, (const float*)mChannels[channel] + start, length);
+         break;
+   }
+}
+
+void SampleStorage::Read(int position, ChannelBuffer* out, int numSamples, int outOffset /*= 0*/) const
+{
+   int before = MIN(MAX(0, -position), numSamples);
+   int available = 0;
+   if (mNumChannels > 0)
+      available = MAX(0, MIN(position + numSamples, mLength) - (position + before));
+   for (int ch=0; ch<out->NumActiveChannels(); ++ch)
+   {
+      float* dest = out->GetChannel(ch) + outOffset;
+      ::Clear(dest, before);
+      if (available > 0)
+         Decode(MIN(ch, mNumChannels-1), position + before, dest + before, available);
+      ::Clear(dest + before + available, numSamples - before - available);
+   }
+}
+
+void SampleStorage::GetPeaks(int channel, int start, int length, float* out, int numPoints) const
+{
+   ::Clear(out, numPoints);
+   if (length <= 0 || numPoints <= 0)
+      return;
+
+   ScratchArena::Scope scratch;
+   float* chunk = scratch.GetBuffer();
+   float pointsPerFrame = float(numPoints) / length;
+   for (int pos=0; pos<length; pos += kWorkBufferSize)
+   {
+      int chunkLength = MIN(kWorkBufferSize, length - pos);
+      Decode(channel, start + pos, chunk, chunkLength);
+      for (int i=0; i<chunkLength; ++i)
+      {
+         int point = MIN(int((pos + i) * pointsPerFrame), numPoints - 1);
+         if (fabsf(chunk[i]) > fabsf(out[point]))
+            out[point] = chunk[i];
+      }
+   }
+}
@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    SampleStorage.h
+    Created: 17 Oct 2026 11:38:14pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OpenFrameworksPort.h"
+#include "ChannelBuffer.h"
+#include "Float4.h"
+
+enum SampleFormat
+{
+   kSampleFormat_Float,
+   kSampleFormat_Int16,
+   kSampleFormat_Half,
+   kSampleFormat_Default   //whatever the sample_format userpref says
+};
+
+//"default", "float", "int16" and "half", for the sampleformat module setting and the userpref
+EnumMap GetSampleFormatEnumMap();
+//kSampleFormat_Default becomes the userpref's format, anything else stays as it is
+SampleFormat ResolveSampleFormat(SampleFormat format);
+
+int16_t FloatToInt16(float value);   //clipped to [-1, 1]
+uint16_t FloatToHalf(float value);   //rounded to nearest even
+
+//channels of audio held as floats, or, for audio that is mostly just played back, as 16 bit ints or halfs in half the memory.
+//int16 is the better fit for audio that came from 16 bit files, half keeps quiet passages and anything over 0dB.
+//decode a block at a time with Decode()/Read(), which convert with SIMD, or a sample at a time with GetSample()
+class SampleStorage
+{
+public:
+   SampleStorage();
+   ~SampleStorage();
+
+   void Reset(SampleFormat format, int numChannels, int length);   //silence
+   void Set(SampleFormat format, ChannelBuffer* data, int length);   //encodes the first length frames of data
+   void SetFormat(SampleFormat format);   //re-encodes what's there
+   void Clear();   //silence, keeping the format and size
+   void Swap(SampleStorage& other);
+
+   SampleFormat GetFormat() const { return mFormat; }
+   int NumChannels() const { return mNumChannels; }
+   int LengthInSamples() const { return mLength; }
+   int64 GetBytes() const { return int64(mLength) * mNumChannels * GetSampleSize(mFormat); }
+
+   float GetSample(int channel, int index) const;
+   void SetSample(int channel, int index, float value);
+   void Write(int channel, int start, const float* data, int length);
+   //frames [start, start+length) of channel into out. all of them have to be in range
+   void Decode(int channel, int start, float* out, int length) const;
+   //like SampleStream::Read(): frames [position, position+numSamples) into out's active channels from outOffset on,
+   //silent outside the audio, and channels past our last one get a copy of it
+   void Read(int position, ChannelBuffer* out, int numSamples, int outOffset = 0) const;
+   //the loudest sample, sign and all, in each of numPoints even stretches of [start, start+length). for drawing
+   void GetPeaks(int channel, int start, int length, float* out, int numPoints) const;
+
+   static int GetSampleSize(SampleFormat format) { return format == kSampleFormat_Float ? sizeof(float) : sizeof(int16_t); }
+
+private:
+   SampleStorage(const SampleStorage&);   //not copyable
+   SampleStorage& operator=(const SampleStorage&);
+
+   void Free();
+
+   SampleFormat mFormat;
+   int mNumChannels;
+   int mLength;
+   char* mChannels[ChannelBuffer::kMaxNumChannels];
+};
+
+inline float SampleStorage::GetSample(int channel, int index) const
+{
+   switch (mFormat)
+   {
+      case kSampleFormat_Int16: return ((const int16_t*)mChannels[channel])[index] * (1.0f / 32767);
+      case kSampleFormat_Half: return HalfToFloat(((const uint16_t*)mChannels[channel])[index]);
+      default: return ((const float*)mChannels[channel])[index];
+   }
+}
@@ -0,0 +1,376 @@
+/*
+  ==============================================================================
+
+    SampleStream.cpp
+    Created: 17 Oct 2026 10:02:51pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "SampleStream.h"
+#include "SynthGlobals.h"
+#include "ModularSynth.h"
+#include "ScratchArena.h"
+
+SampleStream::SampleStream()
+: mIsMemoryMapped(false)
+, mLength(0)
+, mNumChannels(1)
+, mSampleRateRatio(1)
+, mHead(0)
+, mHeadLength(0)
+, mOverview(0)
+, mRing(0)
+, mRingMask(0)
+, mRingStart(0)
+, mRingEnd(0)
+, mRingGeneration(0)
+, mWantedPosition(0)
+, mDirection(1)
+, mLastReadPosition(0)
+, mUnderruns(0)
+, mChunk(0)
+{
+}
+
+SampleStream::~SampleStream()
+{
+   TheSynth->GetSampleStreamer()->Remove(this);
+}
+
+bool SampleStream::Open(string path)
+{
+   File file(ofToDataPath(path));
+   AudioFormatManager& formats = TheSynth->GetGlobalManagers()->mAudioFormatManager;
+
+   //map the file if its format can be read in place, otherwise decode it as a stream
+   AudioFormat* format = formats.findFormatForFileExtension(file.getFileExtension());
+   if (format != nullptr)
+   {
+      ScopedPointer<MemoryMappedAudioFormatReader> mapped(format->createMemoryMappedReader(file));
+      if (mapped != nullptr && mapped->mapEntireFile())
+      {
+         mReader = mapped.release();
+         mIsMemoryMapped = true;
+      }
+   }
+   if (mReader == nullptr)
+      mReader = formats.createReaderFor(file);
+   if (mReader == nullptr)
+      return false;
+
+   mLength = (int)mReader->lengthInSamples;
+   mNumChannels = MIN((int)mReader->numChannels, ChannelBuffer::kMaxNumChannels);
+   mSampleRateRatio = float(mReader->sampleRate) / gSampleRate;
+   int fileSampleRate = (int)mReader->sampleRate;
+
+   mHeadLength = MIN(mLength, kHeadSeconds * fileSampleRate);
+   mHead.Resize(mHeadLength);
+   mHead.SetNumActiveChannels(mNumChannels);
+   float* head[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<mNumChannels; ++ch)
+      head[ch] = mHead.GetChannel(ch);
+   {
+      const ScopedLock lock(mReaderLock);
+      ReadFromReader(0, mHeadLength, head);
+   }
+
+   //touch every channel now, so the audio thread never ends up allocating one
+   mRing.Resize(nextPowerOfTwo(kRingSeconds * fileSampleRate));
+   mRing.SetNumActiveChannels(mNumChannels);
+   mChunk.Resize(SampleStreamer::kChunkSize);
+   mChunk.SetNumActiveChannels(mNumChannels);
+   for (int ch=0; ch<mNumChannels; ++ch)
+   {
+      mRing.GetChannel(ch);
+      mChunk.GetChannel(ch);
+   }
+   mRingMask = mRing.BufferSize() - 1;
+   mRingStart = mHeadLength;
+   mRingEnd = mHeadLength;
+   mWantedPosition = mHeadLength;
+
+   BuildOverview();
+
+   TheSynth->GetSampleStreamer()->Add(this);
+   return true;
+}
+
+void SampleStream::ReadFromReader(int start, int length, float** channels)
+{
+   AudioSampleBuffer buffer(channels, mNumChannels, length);
+   mReader->read(&buffer, 0, length, start, true, true);
+}
+
+void SampleStream::BuildOverview()
+{
+   int overviewLength = MIN(mLength, kOverviewLength);
+   mOverview.Resize(overviewLength);
+   mOverview.SetNumActiveChannels(mNumChannels);
+   if (overviewLength == 0)
+      return;
+
+   float* chunk[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<mNumChannels; ++ch)
+      chunk[ch] = mChunk.GetChannel(ch);
+
+   //each point is the loudest sample in its stretch of the file, sign and all
+   float pointsPerFrame = float(overviewLength) / mLength;
+   for (int pos=0; pos<mLength; pos += SampleStreamer::kChunkSize)
+   {
+      int length = MIN(SampleStreamer::kChunkSize, mLength - pos);
+      {
+         const ScopedLock lock(mReaderLock);
+         ReadFromReader(pos, length, chunk);
+      }
+      for (int ch=0; ch<mNumChannels; ++ch)
+      {
+         float* overview = mOverview.GetChannel(ch);
+         for (int i=0; i<length; ++i)
+         {
+            int point = MIN(int((pos + i) * pointsPerFrame), overviewLength - 1);
+            if (fabsf(chunk[ch][i]) > fabsf(overview[point]))
+               overview[point] = chunk[ch][i];
+         }
+      }
+   }
+}
+
+void SampleStream::Read(int position, ChannelBuffer* out, int numSamples, int outOffset /*= 0*/)
+{
+   int outChannels = out->NumActiveChannels();
+   float* dest[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<outChannels; ++ch)
+      dest[ch] = out->GetChannel(ch) + outOffset;
+   
+   int done = CLAMP(-position, 0, numSamples);   //before the start is silence
+   for (int ch=0; ch<outChannels; ++ch)
+      ::Clear(dest[ch], done);
+   int pos = position + done;
+
+   if (done < numSamples && pos < mHeadLength)
+   {
+      int length = MIN(numSamples - done, mHeadLength - pos);
+      for (int ch=0; ch<outChannels; ++ch)
+         BufferCopy(dest[ch] + done, mHead.GetChannel(MIN(ch, mNumChannels-1)) + pos, length);
+      done += length;
+      pos += length;
+   }
+
+   if (done < numSamples && pos < mLength)
+   {
+      int wanted = MIN(numSamples - done, mLength - pos);
+      int generation = mRingGeneration.load(std::memory_order_acquire);
+      int ringStart = mRingStart.load(std::memory_order_acquire);
+      int ringEnd = mRingEnd.load(std::memory_order_acquire);
+      int available = (pos >= ringStart && pos < ringEnd) ? MIN(wanted, ringEnd - pos) : 0;
+
+      int slot = pos & mRingMask;
+      int first = MIN(available, mRingMask + 1 - slot);
+      for (int ch=0; ch<outChannels; ++ch)
+      {
+         const float* ring = mRing.GetChannel(MIN(ch, mNumChannels-1));
+         BufferCopy(dest[ch] + done, ring + slot, first);
+         BufferCopy(dest[ch] + done + first, ring, available - first);
+      }
+
+      //if the streamer started overwriting those frames while we copied them, we can't trust any of it
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (mRingGeneration.load(std::memory_order_relaxed) != generation ||
+          mRingStart.load(std::memory_order_relaxed) > pos ||
+          mRingEnd.load(std::memory_order_relaxed) < pos + available)
+         available = 0;
+
+      if (available < wanted && TheSynth->IsHeadless())
+      {
+         //rendering offline runs faster than the streamer can keep up, and can afford to wait on the disk instead
+         ReadDirect(pos + available, dest, outChannels, done + available, wanted - available);
+         available = wanted;
+      }
+      if (available < wanted)
+         mUnderruns.fetch_add(1, std::memory_order_relaxed);
+      done += available;
+   }
+
+   for (int ch=0; ch<outChannels; ++ch)
+      ::Clear(dest[ch] + done, numSamples - done);
+
+   //a small step is playback moving along, which way it went is which way to read ahead. a big one is a jump, which tells us nothing
+   int step = position - mLastReadPosition;
+   if (step != 0 && abs(step) <= numSamples * 4)
+      mDirection.store(step > 0 ? 1 : -1, std::memory_order_relaxed);
+   mLastReadPosition = position;
+
+   mWantedPosition.store(MAX(position + numSamples, mHeadLength), std::memory_order_release);
+}
+
+void SampleStream::ReadDirect(int start, float** dest, int outChannels, int destOffset, int length)
+{
+   ScratchArena::Scope scratch;
+   ChannelBuffer* chunk = scratch.GetChannelBuffer();
+   chunk->SetNumActiveChannels(mNumChannels);
+   float* channels[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<mNumChannels; ++ch)
+      channels[ch] = chunk->GetChannel(ch);
+
+   for (int done=0; done<length; done += chunk->BufferSize())
+   {
+      int chunkLength = MIN(chunk->BufferSize(), length - done);
+      {
+         const ScopedLock lock(mReaderLock);
+         ReadFromReader(start + done, chunkLength, channels);
+      }
+      for (int ch=0; ch<outChannels; ++ch)
+         BufferCopy(dest[ch] + destOffset + done, channels[MIN(ch, mNumChannels-1)], chunkLength);
+   }
+}
+
+bool SampleStream::ReadWindow(int start, int length, ChannelBuffer* out)
+{
+   assert(length <= out->BufferSize());
+   out->SetNumActiveChannels(mNumChannels);
+
+   int from = MAX(0, start);
+   int to = MIN(mLength, start + length);
+   float* channels[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<mNumChannels; ++ch)
+   {
+      channels[ch] = out->GetChannel(ch);
+      ::Clear(channels[ch], length);
+      channels[ch] += from - start;
+   }
+
+   if (from < to)
+   {
+      const ScopedLock lock(mReaderLock);
+      ReadFromReader(from, to - from, channels);
+   }
+
+   return from == start && to == start + length;
+}
+
+bool SampleStream::Service()
+{
+   int wanted = MIN(mWantedPosition.load(std::memory_order_acquire), mLength);
+   bool backward = mDirection.load(std::memory_order_relaxed) < 0;
+   int ringStart = mRingStart.load(std::memory_order_relaxed);
+   int ringEnd = mRingEnd.load(std::memory_order_relaxed);
+   int ringSize = mRingMask + 1;
+
+   if (wanted < ringStart || wanted > ringEnd)
+   {
+      //playback jumped somewhere we don't have, start over from there
+      mRingGeneration.fetch_add(1);
+      ringStart = ringEnd = wanted;
+      mRingStart.store(ringStart);
+      mRingEnd.store(ringEnd);
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+
+   if (backward)
+      return ServiceBackward(wanted, ringStart, ringEnd);
+
+   //stop a little short of a full ring, so the frames just before wanted stay around.
+   //playback interpolates, so each block's read starts a frame or two before where the last one ended
+   int fillTo = MIN(mLength, wanted + ringSize - kKeepBehind);
+   if (ringEnd >= fillTo)
+      return false;
+   int length = MIN(fillTo - ringEnd, SampleStreamer::kChunkSize);
+
+   //give up the oldest frames before their slots get overwritten
+   int newStart = MAX(ringStart, ringEnd + length - ringSize);
+   if (newStart != ringStart)
+   {
+      mRingStart.store(newStart);
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+
+   ReadIntoRing(ringEnd, length);
+
+   mRingEnd.store(ringEnd + length, std::memory_order_release);
+   return true;
+}
+
+bool SampleStream::ServiceBackward(int wanted, int ringStart, int ringEnd)
+{
+   //the mirror image of reading ahead: fill below mRingStart, keeping the frames just after wanted.
+   //nothing below the head, the audio thread reads that from mHead
+   int ringSize = mRingMask + 1;
+   int fillFrom = MAX(mHeadLength, wanted - (ringSize - kKeepBehind));
+   if (ringStart <= fillFrom)
+      return false;
+   int length = MIN(ringStart - fillFrom, SampleStreamer::kChunkSize);
+
+   //give up the newest frames before their slots get overwritten
+   int newEnd = MIN(ringEnd, ringStart - length + ringSize);
+   if (newEnd != ringEnd)
+   {
+      mRingEnd.store(newEnd);
+      std::atomic_thread_fence(std::memory_order_release);
+   }
+
+   ReadIntoRing(ringStart - length, length);
+
+   mRingStart.store(ringStart - length, std::memory_order_release);
+   return true;
+}
+
+void SampleStream::ReadIntoRing(int start, int length)
+{
+   int ringSize = mRingMask + 1;
+   float* chunk[ChannelBuffer::kMaxNumChannels];
+   for (int ch=0; ch<mNumChannels; ++ch)
+      chunk[ch] = mChunk.GetChannel(ch);
+   {
+      const ScopedLock lock(mReaderLock);
+      ReadFromReader(start, length, chunk);
+   }
+
+   int slot = start & mRingMask;
+   int first = MIN(length, ringSize - slot);
+   for (int ch=0; ch<mNumChannels; ++ch)
+   {
+      float* ring = mRing.GetChannel(ch);
+      BufferCopy(ring + slot, chunk[ch], first);
+      BufferCopy(ring, chunk[ch] + first, length - first);
+   }
+}
+
+SampleStreamer::SampleStreamer()
+: Thread("sample streamer")
+{
+}
+
+SampleStreamer::~SampleStreamer()
+{
+   stopThread(1000);
+}
+
+void SampleStreamer::Add(SampleStream* stream)
+{
+   const ScopedLock lock(mLock);
+   mStreams.push_back(stream);
+}
+
+void SampleStreamer::Remove(SampleStream* stream)
+{
+   const ScopedLock lock(mLock);
+   mStreams.erase(std::remove(mStreams.begin(), mStreams.end(), stream), mStreams.end());
+}
+
+void SampleStreamer::run()
+{
+   while (!threadShouldExit())
+   {
+      bool busy = false;
+      {
+         const ScopedLock lock(mLock);
+         for (auto* stream : mStreams)
+            busy = stream->Service() || busy;
+      }
+      //when every ring is full, check back a bit more often than once per buffer
+      if (!busy)
+         wait(5);
+   }
+}
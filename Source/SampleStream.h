@@ -0,0 +1,105 @@
+/*
+  ==============================================================================
+
+    SampleStream.h
+    Created: 17 Oct 2026 10:02:51pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OpenFrameworksPort.h"
+#include "ChannelBuffer.h"
+#include <atomic>
+
+class SampleStreamer;
+
+//plays a sample file from disk instead of holding all of it in memory, for stems and field recordings too long to load.
+//the first few seconds are decoded up front so playback starts instantly, the rest is read ahead of the play position
+//by the SampleStreamer thread into a ring that the audio thread reads without locking.
+//wav and aiff files are memory mapped rather than decoded through a stream, so random access into them is cheap.
+class SampleStream
+{
+public:
+   SampleStream();
+   ~SampleStream();
+
+   //not the audio thread. also reads through the whole file once to build the overview
+   bool Open(string path);
+
+   int LengthInSamples() const { return mLength; }
+   int NumChannels() const { return mNumChannels; }
+   float GetSampleRateRatio() const { return mSampleRateRatio; }
+   bool IsMemoryMapped() const { return mIsMemoryMapped; }
+   //peak of each stretch of the file, for drawing it without reading it
+   ChannelBuffer* GetOverview() { return &mOverview; }
+   int GetUnderrunCount() const { return mUnderruns; }
+
+   //audio thread. writes frames [position, position+numSamples) into out, from outOffset on.
+   //anything the streamer hasn't read yet comes out silent, and the streamer moves on to wherever playback went.
+   //headless, it's read straight from the file instead, since an offline render has no deadline to miss
+   void Read(int position, ChannelBuffer* out, int numSamples, int outOffset = 0);
+   //any thread but the audio thread. reads [start, start+length) into out for random access, waiting on the disk if it has to
+   bool ReadWindow(int start, int length, ChannelBuffer* out);
+
+   static const int kHeadSeconds = 3;
+   static const int kRingSeconds = 4;
+   static const int kOverviewLength = 8192;
+   static const int kKeepBehind = 4096;
+
+private:
+   friend class SampleStreamer;
+
+   bool Service();   //streamer thread. reads one chunk ahead of playback, false if there was nothing to do
+   bool ServiceBackward(int wanted, int ringStart, int ringEnd);   //Service() for playback going backward
+   void ReadIntoRing(int start, int length);
+   void ReadDirect(int start, float** dest, int outChannels, int destOffset, int length);   //Read() when headless, waits on the disk   //streamer thread. the slots for [start, start+length) must be free
+   void ReadFromReader(int start, int length, float** channels);   //with mReaderLock held
+   void BuildOverview();
+
+   ScopedPointer<AudioFormatReader> mReader;
+   CriticalSection mReaderLock;
+   bool mIsMemoryMapped;
+   int mLength;
+   int mNumChannels;
+   float mSampleRateRatio;
+
+   ChannelBuffer mHead;
+   int mHeadLength;
+   ChannelBuffer mOverview;
+
+   //ring of the frames [mRingStart, mRingEnd), frame i lives at i & mRingMask.
+   //only the streamer moves the ends. playing forward it fills past mRingEnd, and moves mRingStart past anything before
+   //overwriting it. playing backward it fills below mRingStart and pulls mRingEnd in first. either way a reader can tell it was too slow
+   ChannelBuffer mRing;
+   int mRingMask;
+   std::atomic<int> mRingStart;
+   std::atomic<int> mRingEnd;
+   std::atomic<int> mRingGeneration;   //bumped whenever the ring starts over somewhere else
+   std::atomic<int> mWantedPosition;   //where the audio thread expects to read next
+   std::atomic<int> mDirection;   //1 when playback is moving forward through the file, -1 backward. the ring fills that way
+   int mLastReadPosition;   //audio thread
+   std::atomic<int> mUnderruns;
+   ChannelBuffer mChunk;
+};
+
+//the thread that keeps every open SampleStream's ring topped up
+class SampleStreamer : public Thread
+{
+public:
+   SampleStreamer();
+   ~SampleStreamer();
+
+   void Add(SampleStream* stream);
+   void Remove(SampleStream* stream);   //waits until the streamer is done with it
+
+   void run() override;
+
+   static const int kChunkSize = 16384;
+
+private:
+   CriticalSection mLock;
+   vector<SampleStream*> mStreams;
+};
@@ -12,6 +12,8 @@
 #include "Scale.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "ScratchArena.h"
+#include "SampleStorage.h"
 
 SampleVoice::SampleVoice(IDrawableModule* owner)
 : mPos(0)
@@ -28,6 +30,11 @@ bool SampleVoice::IsDone(double time)
    return mAdsr.IsDone(time);
 }
 
+float SampleVoice::GetLevel(double time)
+{
+   return mAdsr.Value(time);
+}
+
 bool SampleVoice::Process(double time, ChannelBuffer* out)
 {
    PROFILER(SampleVoice);
@@ -39,6 +46,14 @@ bool SampleVoice::Process(double time, ChannelBuffer* out)
    
    float volSq = mVoiceParams->mVol * mVoiceParams->mVol;
    
+   ScratchArena::Scope scratch;
+   float* adsr = scratch.GetBuffer();
+   bool running = mAdsr.Process(time, adsr, out->BufferSize());
+   
+   //work out where every sample reads from first, so the stretch of sample the block covers can be decoded in one go
+   float* positions = scratch.GetBuffer();
+   float* pans = scratch.GetBuffer();
+   int numPlaying = 0;
    for (int pos=0; pos<out->BufferSize(); ++pos)
    {
       if (mOwner)
@@ -53,25 +68,81 @@ bool SampleVoice::Process(double time, ChannelBuffer* out)
          else
             speed = freq/TheScale->PitchToFreq(TheScale->ScaleRoot()+48);
          
-         float sample = GetInterpolatedSample(mPos, mVoiceParams->mSampleData, mVoiceParams->mSampleLength) * mAdsr.Value(time) * volSq;
-         
-         if (out->NumActiveChannels() == 1)
-         {
-            out->GetChannel(0)[pos] += sample;
-         }
-         else
-         {
-            out->GetChannel(0)[pos] += sample * GetLeftPanGain(GetPan());
-            out->GetChannel(1)[pos] += sample * GetRightPanGain(GetPan());
-         }
+         positions[numPlaying] = mPos;
+         pans[numPlaying] = GetPan();
+         ++numPlaying;
          
          mPos += speed;
       }
+   }
+   
+   //once the end is passed it stays passed, so what's playing is always the start of the block
+   float* samples = scratch.GetBuffer();
+   ReadSamples(positions, samples, numPlaying);
+   for (int pos=0; pos<numPlaying; ++pos)
+   {
+      float sample = samples[pos] * adsr[pos] * volSq;
       
-      time += gInvSampleRateMs;
+      if (out->NumActiveChannels() == 1)
+      {
+         out->GetChannel(0)[pos] += sample;
+      }
+      else
+      {
+         out->GetChannel(0)[pos] += sample * GetLeftPanGain(pans[pos]);
+         out->GetChannel(1)[pos] += sample * GetRightPanGain(pans[pos]);
+      }
    }
    
-   return true;
+   return running;
+}
+
+void SampleVoice::ReadSamples(const float* positions, float* samples, int numSamples)
+{
+   if (numSamples == 0)
+      return;
+   
+   const SampleStorage* data = mVoiceParams->mSampleData;
+   int length = mVoiceParams->mSampleLength;
+   
+   //decoding a whole stretch at once converts int16 and half samples with SIMD, and interpolates out of plain floats.
+   //usually the block is one stretch. looping around the end, or pitched up too far for one window, it takes a few
+   ScratchArena::Scope scratch;
+   float* wrapped = scratch.GetBuffer();
+   float* window = scratch.GetBuffer();
+   for (int i=0; i<numSamples; ++i)
+   {
+      wrapped[i] = positions[i];
+      FloatWrap(wrapped[i], length);
+   }
+   
+   int i = 0;
+   while (i < numSamples)
+   {
+      int windowStart = int(wrapped[i]);
+      if (windowStart + 1 >= length)   //interpolates with the first frame, the one case that can't come out of a window
+      {
+         samples[i] = GetInterpolatedSample(wrapped[i], data, 0, length);
+         ++i;
+         continue;
+      }
+      
+      //as far as positions keep moving forward and fit in a window, stopping short of the last frame
+      int windowEnd = windowStart + 2;
+      int runEnd = i + 1;
+      for (; runEnd < numSamples; ++runEnd)
+      {
+         int needed = int(wrapped[runEnd]) + 2;
+         if (wrapped[runEnd] < wrapped[runEnd-1] || needed > length || needed - windowStart > kWorkBufferSize)
+            break;
+         windowEnd = MAX(windowEnd, needed);
+      }
+      
+      int windowLength = windowEnd - windowStart;
+      data->Decode(0, windowStart, window, windowLength);
+      for (; i<runEnd; ++i)
+         samples[i] = GetInterpolatedSample(wrapped[i] - windowStart, window, windowLength);
+   }
 }
 
 void SampleVoice::Start(double time, float target)
@@ -17,13 +17,14 @@
 #include "EnvOscillator.h"
 
 class IDrawableModule;
+class SampleStorage;
 
 class SampleVoiceParams : public IVoiceParams
 {
 public:
    ::ADSR mAdsr;
    float mVol;
-   float* mSampleData;
+   SampleStorage* mSampleData;
    int mSampleLength;
    float mDetectedFreq;
    bool mLoop;
@@ -42,7 +43,10 @@ public:
    bool Process(double time, ChannelBuffer* out) override;
    void SetVoiceParams(IVoiceParams* params) override;
    bool IsDone(double time) override;
+   float GetLevel(double time) override;
 private:
+   void ReadSamples(const float* positions, float* samples, int numSamples);
+   
    ::ADSR mAdsr;
    SampleVoiceParams* mVoiceParams;
    float mPos;
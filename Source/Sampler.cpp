@@ -16,6 +16,7 @@
 #include "Profiler.h"
 #include "EnvOscillator.h"
 #include "Scale.h"
+#include "ScratchArena.h"
 
 Sampler::Sampler()
 : IAudioProcessor(gBufferSize)
@@ -35,12 +36,11 @@ Sampler::Sampler()
 , mPassthroughCheckbox(nullptr)
 , mWriteBuffer(gBufferSize)
 {
-   mSampleData = new float[MAX_SAMPLER_LENGTH];   //store up to 2 seconds
-   Clear(mSampleData, MAX_SAMPLER_LENGTH);
+   mSampleData.Reset(kSampleFormat_Float, 1, MAX_SAMPLER_LENGTH);   //store up to 2 seconds
    
    mVoiceParams.mVol = .05f;
    mVoiceParams.mAdsr.Set(10,0,1,10);
-   mVoiceParams.mSampleData = mSampleData;
+   mVoiceParams.mSampleData = &mSampleData;
    mVoiceParams.mSampleLength = 0;
    mVoiceParams.mDetectedFreq = -1;
    mVoiceParams.mLoop = false;
@@ -65,7 +65,6 @@ void Sampler::CreateUIControls()
 
 Sampler::~Sampler()
 {
-   delete[] mSampleData;
 }
 
 void Sampler::Poll()
@@ -100,11 +99,12 @@ void Sampler::Process(double time)
          //if we've already started recording, or if it's a new recording and there's sound
          if (mRecordPos > 0 || fabsf(GetBuffer()->GetChannel(0)[i]) > mThresh )
          {
-            mSampleData[mRecordPos] = GetBuffer()->GetChannel(0)[i];
+            float input = GetBuffer()->GetChannel(0)[i];
+            mSampleData.SetSample(0, mRecordPos, input);
             if (mPassthrough)
             {
                for (int ch=0; ch<mWriteBuffer.NumActiveChannels(); ++ch)
-                  mWriteBuffer.GetChannel(ch)[i] += mSampleData[mRecordPos];
+                  mWriteBuffer.GetChannel(ch)[i] += input;
             }
             ++mRecordPos;
          }
@@ -168,7 +168,13 @@ void Sampler::DrawModule()
    
    ofPushMatrix();
    ofTranslate(100,15);
-   DrawAudioBuffer(100, 50, mSampleData, 0, mVoiceParams.mSampleLength, -1);
+   {
+      ScratchArena::Scope scratch;
+      float* peaks = scratch.GetBuffer();
+      int numPoints = MIN(mVoiceParams.mSampleLength, kWorkBufferSize);
+      mSampleData.GetPeaks(0, 0, mVoiceParams.mSampleLength, peaks, numPoints);
+      DrawAudioBuffer(100, 50, peaks, 0, numPoints, -1);
+   }
    ofPushStyle();
    ofNoFill();
    ofSetColor(255,0,0);
@@ -203,7 +209,9 @@ float Sampler::DetectSampleFrequency()
       time += gInvSampleRateMs;
    }*/
    
-   float pitch = mPitchDetector.DetectPitch(mSampleData, MAX_SAMPLER_LENGTH);
+   vector<float> data(MAX_SAMPLER_LENGTH);
+   mSampleData.Decode(0, 0, data.data(), MAX_SAMPLER_LENGTH);
+   float pitch = mPitchDetector.DetectPitch(data.data(), MAX_SAMPLER_LENGTH);
    float freq = TheScale->PitchToFreq(pitch);
    ofLog() << "Detected frequency: " << freq;
    return freq;
@@ -233,16 +241,17 @@ void Sampler::SampleDropped(int x, int y, Sample* sample)
       return;
    
    mVoiceParams.mSampleLength = MIN(MAX_SAMPLER_LENGTH, numSamples);
-   Clear(mSampleData, MAX_SAMPLER_LENGTH);
-   
-   for (int i=0; i<mVoiceParams.mSampleLength; ++i)
-      mSampleData[i] = data[i];
+   mSampleData.Clear();
+   mSampleData.Write(0, 0, data, mVoiceParams.mSampleLength);
 }
 
 void Sampler::LoadLayout(const ofxJSONElement& moduleInfo)
 {
    mModuleSaveData.LoadString("target", moduleInfo);
    mModuleSaveData.LoadBool("loop", moduleInfo, false);
+   mModuleSaveData.LoadInt("voicelimit", moduleInfo, -1, -1, kMaxVoicePoolSize);
+   EnumMap formatMap = GetSampleFormatEnumMap();
+   mModuleSaveData.LoadEnum<SampleFormat>("sampleformat", moduleInfo, kSampleFormat_Default, nullptr, &formatMap);
    
    SetUpFromSaveData();
 }
@@ -251,6 +260,15 @@ void Sampler::SetUpFromSaveData()
 {
    SetTarget(TheSynth->FindModule(mModuleSaveData.GetString("target")));
    mVoiceParams.mLoop = mModuleSaveData.GetBool("loop");
+   int voiceLimit = mModuleSaveData.GetInt("voicelimit");
+   if (voiceLimit > 0)
+      mPolyMgr.SetVoiceLimit(voiceLimit);
+   SampleFormat format = ResolveSampleFormat(mModuleSaveData.GetEnum<SampleFormat>("sampleformat"));
+   if (format != mSampleData.GetFormat())
+   {
+      ScopedMutex mutex(TheSynth->GetAudioMutex(), "Sampler::SetUpFromSaveData()");
+      mSampleData.SetFormat(format);
+   }
 }
 
 
@@ -277,7 +295,7 @@ void Sampler::CheckboxUpdated(Checkbox* checkbox)
       {
          mRecordPos = 0;
          mVoiceParams.mSampleLength = 0;
-         Clear(mSampleData, MAX_SAMPLER_LENGTH);
+         mSampleData.Clear();
       }
       else
       {
@@ -304,7 +322,9 @@ void Sampler::SaveState(FileStreamOut& out)
    
    out << kSaveStateRev;
    
-   out.Write(mSampleData, MAX_SAMPLER_LENGTH);
+   vector<float> data(MAX_SAMPLER_LENGTH);   //saved as floats whatever the format
+   mSampleData.Decode(0, 0, data.data(), MAX_SAMPLER_LENGTH);
+   out.Write(data.data(), MAX_SAMPLER_LENGTH);
    out << mVoiceParams.mSampleLength;
 }
 
@@ -316,7 +336,9 @@ void Sampler::LoadState(FileStreamIn& in)
    in >> rev;
    LoadStateValidate(rev == kSaveStateRev);
    
-   in.Read(mSampleData, MAX_SAMPLER_LENGTH);
+   vector<float> data(MAX_SAMPLER_LENGTH);
+   in.Read(data.data(), MAX_SAMPLER_LENGTH);
+   mSampleData.Write(0, 0, data.data(), MAX_SAMPLER_LENGTH);
    
    if (rev >= 1)
       in >> mVoiceParams.mSampleLength;
@@ -21,6 +21,7 @@
 #include "ADSRDisplay.h"
 #include "Checkbox.h"
 #include "PitchDetector.h"
+#include "SampleStorage.h"
 
 class ofxJSONElement;
 
@@ -80,7 +81,7 @@ private:
    float mThresh;
    FloatSlider* mThreshSlider;
 
-   float* mSampleData;
+   SampleStorage mSampleData;
    int mRecordPos;
    bool mRecording;
    Checkbox* mRecordCheckbox;
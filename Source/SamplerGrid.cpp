@@ -16,6 +16,7 @@
 #include "Profiler.h"
 #include "EnvOscillator.h"
 #include "MidiController.h"
+#include "ScratchArena.h"
 
 SamplerGrid::SamplerGrid()
 : IAudioProcessor(gBufferSize)
@@ -93,7 +94,9 @@ void SamplerGrid::Process(double time)
    
    int bufferSize = GetBuffer()->BufferSize();
    
-   Clear(gWorkBuffer, gBufferSize);
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
+   Clear(workBuffer, gBufferSize);
    
    float volSq = mVolume * mVolume;
    
@@ -105,7 +108,7 @@ void SamplerGrid::Process(double time)
          float rampVal = sample.mRamp.Value(time);
          if (rampVal > 0 && sample.mPlayhead < sample.mSampleEnd)
          {
-            gWorkBuffer[i] += sample.mSampleData[sample.mPlayhead] * rampVal * volSq;
+            workBuffer[i] += sample.mSampleData[sample.mPlayhead] * rampVal * volSq;
             ++sample.mPlayhead;
             if (sample.mRamp.Target() == 1 &&
                 sample.mPlayhead + SAMPLE_RAMP_MS/gInvSampleRateMs >= sample.mSampleEnd)
@@ -124,7 +127,7 @@ void SamplerGrid::Process(double time)
             sample.mHasSample = true;
          if (sample.mPlayhead < MAX_SAMPLER_GRID_LENGTH && sample.mHasSample)
          {
-            sample.mSampleData[sample.mPlayhead] = GetBuffer()->GetChannel(0)[i];// + gWorkBuffer[i];
+            sample.mSampleData[sample.mPlayhead] = GetBuffer()->GetChannel(0)[i];// + workBuffer[i];
             ++sample.mPlayhead;
             sample.mSampleLength = sample.mPlayhead;
             sample.mSampleStart = 0;
@@ -136,12 +139,12 @@ void SamplerGrid::Process(double time)
    if (mPassthrough)
    {
       for (int i=0; i<gBufferSize; ++i)
-         gWorkBuffer[i] += GetBuffer()->GetChannel(0)[i];
+         workBuffer[i] += GetBuffer()->GetChannel(0)[i];
    }
    
-   GetVizBuffer()->WriteChunk(gWorkBuffer, bufferSize, 0);
+   GetVizBuffer()->WriteChunk(workBuffer, bufferSize, 0);
    
-   Add(GetTarget()->GetBuffer()->GetChannel(0), gWorkBuffer, bufferSize);
+   Add(GetTarget()->GetBuffer()->GetChannel(0), workBuffer, bufferSize);
    
    GetBuffer()->Reset();
 }
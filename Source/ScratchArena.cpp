@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    ScratchArena.cpp
+    Created: 17 Oct 2026 2:31:08pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "ScratchArena.h"
+#include "ChannelBuffer.h"
+
+namespace
+{
+   const int kFloatsPerBuffer = kWorkBufferSize;
+   const int kNumChannelBufferFloats = ScratchArena::kNumChannelBuffers * ChannelBuffer::kMaxNumChannels * kFloatsPerBuffer;
+   const int kTotalFloats = ScratchArena::kNumBuffers * kFloatsPerBuffer + kNumChannelBufferFloats;
+}
+
+ScratchArena::ScratchArena()
+: mNumBuffersUsed(0)
+, mNumChannelBuffersUsed(0)
+{
+   //one block for everything, aligned so vectorized loops can use aligned loads
+   mMemory = new char[kTotalFloats * sizeof(float) + kAlignment];
+   float* aligned = (float*)(((uintptr_t)mMemory + kAlignment - 1) & ~(uintptr_t)(kAlignment - 1));
+   ::Clear(aligned, kTotalFloats);
+
+   for (int i=0; i<kNumBuffers; ++i)
+   {
+      mBuffers[i] = aligned;
+      aligned += kFloatsPerBuffer;
+   }
+
+   for (int i=0; i<kNumChannelBuffers; ++i)
+   {
+      float* channels[ChannelBuffer::kMaxNumChannels];
+      for (int ch=0; ch<ChannelBuffer::kMaxNumChannels; ++ch)
+      {
+         channels[ch] = aligned;
+         aligned += kFloatsPerBuffer;
+      }
+      mChannelBuffers[i] = new ChannelBuffer(channels, ChannelBuffer::kMaxNumChannels, kFloatsPerBuffer);
+   }
+}
+
+ScratchArena::~ScratchArena()
+{
+   for (int i=0; i<kNumChannelBuffers; ++i)
+      delete mChannelBuffers[i];
+   delete[] mMemory;
+}
+
+//static
+ScratchArena& ScratchArena::ForThisThread()
+{
+   static thread_local ScratchArena sArena;
+   return sArena;
+}
+
+void ScratchArena::Reset()
+{
+   mNumBuffersUsed = 0;
+   mNumChannelBuffersUsed = 0;
+}
+
+float* ScratchArena::AllocBuffer()
+{
+   assert(mNumBuffersUsed < kNumBuffers);
+   if (mNumBuffersUsed >= kNumBuffers)
+   {
+      ofLog() << "scratch arena out of buffers";
+      return mBuffers[kNumBuffers - 1];
+   }
+   return mBuffers[mNumBuffersUsed++];
+}
+
+double* ScratchArena::AllocDoubleBuffer()
+{
+   //the float buffers sit back to back, so two neighbours hold kWorkBufferSize doubles
+   assert(mNumBuffersUsed + 2 <= kNumBuffers);
+   if (mNumBuffersUsed + 2 > kNumBuffers)
+   {
+      ofLog() << "scratch arena out of buffers";
+      return (double*)mBuffers[kNumBuffers - 2];
+   }
+   double* buffer = (double*)mBuffers[mNumBuffersUsed];
+   mNumBuffersUsed += 2;
+   return buffer;
+}
+
+ChannelBuffer* ScratchArena::AllocChannelBuffer()
+{
+   assert(mNumChannelBuffersUsed < kNumChannelBuffers);
+   if (mNumChannelBuffersUsed >= kNumChannelBuffers)
+   {
+      ofLog() << "scratch arena out of channel buffers";
+      return mChannelBuffers[kNumChannelBuffers - 1];
+   }
+   ChannelBuffer* buffer = mChannelBuffers[mNumChannelBuffersUsed++];
+   buffer->SetNumActiveChannels(1);
+   return buffer;
+}
+
+ScratchArena::Scope::Scope()
+: mArena(ScratchArena::ForThisThread())
+{
+   mBufferMark = mArena.mNumBuffersUsed;
+   mChannelBufferMark = mArena.mNumChannelBuffersUsed;
+}
+
+ScratchArena::Scope::~Scope()
+{
+   mArena.mNumBuffersUsed = mBufferMark;
+   mArena.mNumChannelBuffersUsed = mChannelBufferMark;
+}
+
+float* ScratchArena::Scope::GetBuffer()
+{
+   return mArena.AllocBuffer();
+}
+
+double* ScratchArena::Scope::GetDoubleBuffer()
+{
+   return mArena.AllocDoubleBuffer();
+}
+
+ChannelBuffer* ScratchArena::Scope::GetChannelBuffer()
+{
+   return mArena.AllocChannelBuffer();
+}
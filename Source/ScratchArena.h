@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    ScratchArena.h
+    Created: 17 Oct 2026 2:31:08pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "SynthGlobals.h"
+
+class ChannelBuffer;
+
+//per-thread scratch memory for audio processing.
+//each thread that processes audio has its own arena, so modules can run on any audio graph worker.
+//hand out buffers through a Scope, which gives everything back when it goes out of scope:
+//
+//   ScratchArena::Scope scratch;
+//   float* work = scratch.GetBuffer();
+//   ChannelBuffer* workChannels = scratch.GetChannelBuffer();
+//
+//buffers are kWorkBufferSize floats (or doubles, from GetDoubleBuffer()) long, 64-byte aligned, and are not cleared.
+class ScratchArena
+{
+public:
+   ScratchArena();
+   ~ScratchArena();
+
+   static ScratchArena& ForThisThread();
+
+   //called at the start of every audio block, in case something leaked out of a scope
+   void Reset();
+
+   class Scope
+   {
+   public:
+      Scope();
+      ~Scope();
+      float* GetBuffer();
+      double* GetDoubleBuffer();
+      ChannelBuffer* GetChannelBuffer();
+   private:
+      ScratchArena& mArena;
+      int mBufferMark;
+      int mChannelBufferMark;
+   };
+
+   static const int kNumBuffers = 32;
+   static const int kNumChannelBuffers = 8;
+   static const int kAlignment = 64;
+
+private:
+   float* AllocBuffer();
+   double* AllocDoubleBuffer();
+   ChannelBuffer* AllocChannelBuffer();
+
+   char* mMemory;
+   float* mBuffers[kNumBuffers];
+   ChannelBuffer* mChannelBuffers[kNumChannelBuffers];
+   int mNumBuffersUsed;
+   int mNumChannelBuffersUsed;
+};
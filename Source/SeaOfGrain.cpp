@@ -13,16 +13,26 @@
 #include "ModularSynth.h"
 #include "Profiler.h"
 #include "ModulationChain.h"
+#include "ScratchArena.h"
 
 const float mBufferX = 5;
 const float mBufferY = 100;
 const float mBufferW = 800;
 const float mBufferH = 200;
 
+namespace
+{
+   const float kStreamWindowMarginSeconds = 2;   //covers the grain length and position randomization either side of the display
+   const float kMaxStreamedDisplaySeconds = 30;   //the window around the display is read into memory, so it can't be the whole file
+}
+
 SeaOfGrain::SeaOfGrain()
 : mVolume(.6f)
 , mVolumeSlider(nullptr)
 , mSample(nullptr)
+, mStreamWindow(0)
+, mStreamWindowStart(0)
+, mStreamWindowLength(0)
 , mLoading(false)
 , mDisplayOffset(0)
 , mDisplayOffsetSlider(nullptr)
@@ -73,7 +83,8 @@ void SeaOfGrain::CreateUIControls()
       float x = 10 + i * 100;
       mManualVoices[i].mGainSlider = new FloatSlider(this,("gain "+ofToString(i+1)).c_str(),x,mBufferY+mBufferH+10,90,15,&mManualVoices[i].mGain,0,1);
       mManualVoices[i].mPositionSlider = new FloatSlider(this,("pos "+ofToString(i+1)).c_str(),mManualVoices[i].mGainSlider,kAnchor_Below,90,15,&mManualVoices[i].mPosition,0,1);
-      mManualVoices[i].mOverlapSlider = new FloatSlider(this,("overlap "+ofToString(i+1)).c_str(),mManualVoices[i].mPositionSlider,kAnchor_Below,90,15,&mManualVoices[i].mGranulator.mGrainOverlap,.25,MAX_GRAINS);
+      mManualVoices[i].mOverlapSlider = new FloatSlider(this,("overlap "+ofToString(i+1)).c_str(),mManualVoices[i].mPositionSlider,kAnchor_Below,90,15,&mManualVoices[i].mGranulator.mGrainOverlap,.25,MAX_GRAIN_OVERLAP);
+      mManualVoices[i].mOverlapSlider->SetMode(FloatSlider::kSquare);
       mManualVoices[i].mSpeedSlider = new FloatSlider(this,("speed "+ofToString(i+1)).c_str(),mManualVoices[i].mOverlapSlider,kAnchor_Below,90,15,&mManualVoices[i].mGranulator.mSpeed,-3,3);
       mManualVoices[i].mLengthMsSlider = new FloatSlider(this,("len ms "+ofToString(i+1)).c_str(),mManualVoices[i].mSpeedSlider,kAnchor_Below,90,15,&mManualVoices[i].mGranulator.mGrainLengthMs,1,500);
       mManualVoices[i].mPosRandomizeSlider = new FloatSlider(this,("pos r "+ofToString(i+1)).c_str(),mManualVoices[i].mLengthMsSlider,kAnchor_Below,90,15,&mManualVoices[i].mGranulator.mPosRandomizeMs,0,200);
@@ -89,6 +100,7 @@ SeaOfGrain::~SeaOfGrain()
 
 void SeaOfGrain::Poll()
 {
+   UpdateStreamWindow();
 }
 
 void SeaOfGrain::Process(double time)
@@ -104,11 +116,29 @@ void SeaOfGrain::Process(double time)
    float* out = GetTarget()->GetBuffer()->GetChannel(0);
    assert(bufferSize == gBufferSize);
    
+   bool streaming = mSample->IsStreaming();
+   const float* sample;
+   int sampleLength;
+   if (streaming)
+   {
+      mSample->LockDataMutex(true);
+      sampleLength = mStreamWindowLength;
+      sample = sampleLength > 0 ? mStreamWindow.GetChannel(0) : nullptr;
+   }
+   else
+   {
+      sample = mSample->Data()->GetChannel(0);
+      sampleLength = mSample->LengthInSamples();
+   }
+   
    Clear(mWriteBuffer, bufferSize);
    for (int i=0; i<kNumMPEVoices; ++i)
-      mMPEVoices[i].Process(mWriteBuffer, bufferSize, mSample->Data()->GetChannel(0), mSample->LengthInSamples());
+      mMPEVoices[i].Process(mWriteBuffer, bufferSize, sample, sampleLength);
    for (int i=0; i<kNumManualVoices; ++i)
-      mManualVoices[i].Process(mWriteBuffer, bufferSize, mSample->Data()->GetChannel(0), mSample->LengthInSamples());
+      mManualVoices[i].Process(mWriteBuffer, bufferSize, sample, sampleLength);
+   
+   if (streaming)
+      mSample->LockDataMutex(false);
    Mult(mWriteBuffer, mVolume, bufferSize);
    GetVizBuffer()->WriteChunk(mWriteBuffer, bufferSize, 0);
    
@@ -144,7 +174,10 @@ void SeaOfGrain::DrawModule()
       ofPushStyle();
       
       mSample->LockDataMutex(true);
-      DrawAudioBuffer(mBufferW, mBufferH, mSample->Data(), mDisplayStartSamples, mDisplayEndSamples, 0);
+      if (mSample->IsStreaming())
+         DrawAudioBuffer(mBufferW, mBufferH, &mStreamWindow, mDisplayStartSamples - mStreamWindowStart, mDisplayEndSamples - mStreamWindowStart, -mStreamWindowStart);
+      else
+         DrawAudioBuffer(mBufferW, mBufferH, mSample->Data(), mDisplayStartSamples, mDisplayEndSamples, 0);
       mSample->LockDataMutex(false);
       
       ofPushStyle();
@@ -172,7 +205,7 @@ void SeaOfGrain::FilesDropped(vector<string> files, int x, int y)
    
    mSample->Reset();
    
-   mSample->Read(files[0].c_str());
+   mSample->Read(files[0].c_str(), false, true);
    UpdateSample();
    
    mLoading = false;
@@ -200,12 +233,64 @@ void SeaOfGrain::UpdateSample()
 {
    float sampleLengthSeconds = mSample->LengthInSamples() / mSample->GetSampleRateRatio() / gSampleRate;
    mDisplayLength = MIN(mDisplayLength,MIN(10, sampleLengthSeconds));
-   mDisplayLengthSlider->SetExtents(0, sampleLengthSeconds);
+   if (mSample->IsStreaming())   //long enough to stream, so let the display roam all of it, a bounded stretch at a time
+   {
+      mDisplayLengthSlider->SetExtents(0, MIN(sampleLengthSeconds, kMaxStreamedDisplaySeconds));
+      mDisplayOffsetSlider->SetExtents(0, sampleLengthSeconds);
+   }
+   else
+   {
+      mDisplayLengthSlider->SetExtents(0, sampleLengthSeconds);
+   }
    UpdateDisplaySamples();
+   
+   mSample->LockDataMutex(true);
+   mStreamWindow.Resize(0);
+   mStreamWindowStart = 0;
+   mStreamWindowLength = 0;
+   for (int i=0; i<kNumMPEVoices; ++i)
+      mMPEVoices[i].mGranulator.ClearGrains();
+   for (int i=0; i<kNumManualVoices; ++i)
+      mManualVoices[i].mGranulator.ClearGrains();
+   mSample->LockDataMutex(false);
+   UpdateStreamWindow();
+}
+
+void SeaOfGrain::UpdateStreamWindow()
+{
+   if (!mSample->IsStreaming())
+      return;
+   
+   //read a new window once the display gets within half a margin of the edge of this one
+   int margin = int(kStreamWindowMarginSeconds * gSampleRate * mSample->GetSampleRateRatio());
+   int neededStart = MAX(0, mDisplayStartSamples - margin / 2);
+   int neededEnd = MIN(mSample->LengthInSamples(), mDisplayEndSamples + margin / 2);
+   if (mStreamWindowLength > 0 && neededStart >= mStreamWindowStart && neededEnd <= mStreamWindowStart + mStreamWindowLength)
+      return;
+   
+   int start = MAX(0, mDisplayStartSamples - margin);
+   int end = MIN(mSample->LengthInSamples(), mDisplayEndSamples + margin);
+   if (end <= start)
+      return;
+   ChannelBuffer window(end - start);
+   mSample->ReadWindow(start, end - start, &window);
+   
+   //grains keep playing through the swap, from the same place in the file
+   mSample->LockDataMutex(true);
+   mStreamWindow.Swap(window);
+   for (int i=0; i<kNumMPEVoices; ++i)
+      mMPEVoices[i].mGranulator.ShiftGrains(mStreamWindowStart - start);
+   for (int i=0; i<kNumManualVoices; ++i)
+      mManualVoices[i].mGranulator.ShiftGrains(mStreamWindowStart - start);
+   mStreamWindowStart = start;
+   mStreamWindowLength = end - start;
+   mSample->LockDataMutex(false);
 }
 
 void SeaOfGrain::UpdateDisplaySamples()
 {
+   if (mSample->IsStreaming())
+      mDisplayLength = MIN(mDisplayLength, kMaxStreamedDisplaySeconds);   //a saved length might be longer
    mDisplayStartSamples = mDisplayOffset * gSampleRate * mSample->GetSampleRateRatio();
    mDisplayEndSamples = mDisplayLength * gSampleRate * mSample->GetSampleRateRatio() + mDisplayStartSamples;
 }
@@ -316,37 +401,48 @@ SeaOfGrain::GrainMPEVoice::GrainMPEVoice()
    mGranulator.mGrainLengthMs = 150;
 }
 
-void SeaOfGrain::GrainMPEVoice::Process(float* out, int outLength, float* sample, int sampleLength)
+void SeaOfGrain::GrainMPEVoice::Process(float* out, int outLength, const float* sample, int sampleLength)
 {
    if (!mADSR.IsDone(gTime) && sampleLength > 0)
    {
+      const float kMaxPressureOverlap = 32;
+      
+      //the granulator reads its params once per block, so take them from the start of the block
+      float pressure = mPressure ? mPressure->GetValue(0) : 0;
+      float modwheel = mModWheel ? mModWheel->GetValue(0) : 0;
+      if (pressure > 0)
+      {
+         mGranulator.mGrainOverlap = ofMap(pressure * pressure, 0, 1, 3, kMaxPressureOverlap);
+         mGranulator.mPosRandomizeMs = ofMap(pressure * pressure, 0, 1, 100, .03f);
+      }
+      mGranulator.mGrainLengthMs = ofMap(modwheel, -1, 1, 150-140, 150+140);
+      
+      ScratchArena::Scope scratch;
+      double* offsets = scratch.GetDoubleBuffer();
+      float* gain = scratch.GetBuffer();
+      
       double time = gTime;
       for (int i=0; i<outLength; ++i)
       {
          float pitchBend = mPitchBend ? mPitchBend->GetValue(i) : 0;
-         float pressure = mPressure ? mPressure->GetValue(i) : 0;
-         float modwheel = mModWheel ? mModWheel->GetValue(i) : 0;
-         if (pressure > 0)
-         {
-            mGranulator.mGrainOverlap = ofMap(pressure * pressure, 0, 1, 3, MAX_GRAINS);
-            mGranulator.mPosRandomizeMs = ofMap(pressure * pressure, 0, 1, 100, .03f);
-         }
-         mGranulator.mGrainLengthMs = ofMap(modwheel, -1, 1, 150-140, 150+140);
-         
          float blend = .0005f;
-         mGain = mGain * (1-blend) + pressure * blend;
+         mGain = mGain * (1-blend) + (mPressure ? mPressure->GetValue(i) : 0) * blend;
          
-         ChannelBuffer temp(sample, sampleLength);
-         float outSample[1];
-         outSample[0] = 0;
          float pos = (mPitch + pitchBend + MIN(.125f, mPlay) - mOwner->mKeyboardBasePitch) / mOwner->mKeyboardNumPitches;
-         mGranulator.Process(time, &temp, sampleLength, ofLerp(mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples, pos), outSample);
-         outSample[0] *= sqrtf(mGain);
-         outSample[0] *= mADSR.Value(time);
-         out[i] += outSample[0];
+         offsets[i] = ofLerp(mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples, pos) - mOwner->mStreamWindowStart;
+         gain[i] = sqrtf(mGain) * mADSR.Value(time);
          time += gInvSampleRateMs;
          mPlay += .001f;
       }
+      
+      const ChannelBuffer temp(const_cast<float*>(sample), sampleLength);   //just a view, the granulator only reads it
+      ChannelBuffer* grains = scratch.GetChannelBuffer();
+      ::Clear(grains->GetChannel(0), outLength);
+      mGranulator.Process(gTime, &temp, sampleLength, offsets, grains, outLength);
+      
+      const float* grainOut = grains->GetChannel(0);
+      for (int i=0; i<outLength; ++i)
+         out[i] += grainOut[i] * gain[i];
    }
    else
    {
@@ -376,7 +472,7 @@ void SeaOfGrain::GrainMPEVoice::Draw(float w, float h)
          ofPopStyle();
       }
       
-      mGranulator.Draw(0, 0, w, h, mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples - mOwner->mDisplayStartSamples, false);
+      mGranulator.Draw(0, 0, w, h, mOwner->mDisplayStartSamples - mOwner->mStreamWindowStart, mOwner->mDisplayEndSamples - mOwner->mDisplayStartSamples, false);
    }
 }
 
@@ -388,21 +484,24 @@ SeaOfGrain::GrainManualVoice::GrainManualVoice()
    mGranulator.mGrainLengthMs = 150;
 }
 
-void SeaOfGrain::GrainManualVoice::Process(float* out, int outLength, float* sample, int sampleLength)
+void SeaOfGrain::GrainManualVoice::Process(float* out, int outLength, const float* sample, int sampleLength)
 {
    if (mGain > 0 && sampleLength > 0)
    {
-      double time = gTime;
+      ScratchArena::Scope scratch;
+      double* offsets = scratch.GetDoubleBuffer();
+      double offset = ofLerp(mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples, mPosition) - mOwner->mStreamWindowStart;
       for (int i=0; i<outLength; ++i)
-      {
-         ChannelBuffer temp(sample, sampleLength);
-         float outSample[1];
-         outSample[0] = 0;
-         mGranulator.Process(time, &temp, sampleLength, ofLerp(mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples, mPosition), outSample);
-         outSample[0] *= mGain;
-         out[i] += outSample[0];
-         time += gInvSampleRateMs;
-      }
+         offsets[i] = offset;
+      
+      const ChannelBuffer temp(const_cast<float*>(sample), sampleLength);   //just a view, the granulator only reads it
+      ChannelBuffer* grains = scratch.GetChannelBuffer();
+      ::Clear(grains->GetChannel(0), outLength);
+      mGranulator.Process(gTime, &temp, sampleLength, offsets, grains, outLength);
+      
+      const float* grainOut = grains->GetChannel(0);
+      for (int i=0; i<outLength; ++i)
+         out[i] += grainOut[i] * mGain;
    }
    else
    {
@@ -421,7 +520,7 @@ void SeaOfGrain::GrainManualVoice::Draw(float w, float h)
       ofLine(x, y, x, h);
       ofRect(x-5, y-5, 10, 10);
       ofPopStyle();
-      mGranulator.Draw(0, 0, w, h, mOwner->mDisplayStartSamples, mOwner->mDisplayEndSamples - mOwner->mDisplayStartSamples, false);
+      mGranulator.Draw(0, 0, w, h, mOwner->mDisplayStartSamples - mOwner->mStreamWindowStart, mOwner->mDisplayEndSamples - mOwner->mDisplayStartSamples, false);
    }
 }
 
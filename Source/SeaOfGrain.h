@@ -20,6 +20,7 @@
 #include "INoteReceiver.h"
 #include "Granulator.h"
 #include "ADSR.h"
+#include "ChannelBuffer.h"
 
 class Sample;
 
@@ -81,7 +82,7 @@ private:
    struct GrainMPEVoice
    {
       GrainMPEVoice();
-      void Process(float* out, int outLength, float* sample, int sampleLength);
+      void Process(float* out, int outLength, const float* sample, int sampleLength);
       void Draw(float w, float h);
       
       float mPlay;
@@ -100,7 +101,7 @@ private:
    struct GrainManualVoice
    {
       GrainManualVoice();
-      void Process(float* out, int outLength, float* sample, int sampleLength);
+      void Process(float* out, int outLength, const float* sample, int sampleLength);
       void Draw(float w, float h);
       
       float mGain;
@@ -123,7 +124,14 @@ private:
    static const int kNumManualVoices = 4;
    GrainManualVoice mManualVoices[kNumManualVoices];
    
+   void UpdateStreamWindow();
+   
    Sample* mSample;
+   //for a streamed sample, the stretch around the display that grains can reach. grain positions are relative to mStreamWindowStart,
+   //which stays 0 for samples in memory
+   ChannelBuffer mStreamWindow;
+   int mStreamWindowStart;
+   int mStreamWindowLength;
    
    float mVolume;
    FloatSlider* mVolumeSlider;
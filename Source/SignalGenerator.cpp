@@ -14,6 +14,7 @@
 #include "Profiler.h"
 #include "Scale.h"
 #include "FloatSliderLFOControl.h"
+#include "ScratchArena.h"
 
 SignalGenerator::SignalGenerator()
 : mOsc(kOsc_Sin)
@@ -125,8 +126,14 @@ void SignalGenerator::Process(double time)
    float* out = GetTarget()->GetBuffer()->GetChannel(0);
    assert(bufferSize == gBufferSize);
    
-   Clear(mWriteBuffer, gBufferSize);
    float syncPhaseInc = GetPhaseInc(mSyncFreq);
+   
+   //gather the oscillator's phases and gains, then render it for the whole block
+   ScratchArena::Scope scratch;
+   float* phases = scratch.GetBuffer();
+   float* phaseIncs = scratch.GetBuffer();
+   float* gains = scratch.GetBuffer();
+   
    for (int pos=0; pos<bufferSize; ++pos)
    {
       ComputeSliders(pos);
@@ -171,12 +178,23 @@ void SignalGenerator::Process(double time)
       mSyncPhase += syncPhaseInc;
       
       if (mSync)
-         mWriteBuffer[pos] += mOsc.Audio(time, mSyncPhase) * volSq;
+      {
+         phases[pos] = mSyncPhase;
+         phaseIncs[pos] = syncPhaseInc;
+      }
       else
-         mWriteBuffer[pos] += mOsc.Audio(time, mPhase + mPhaseOffset*FTWO_PI) * volSq;
+      {
+         phases[pos] = mPhase + mPhaseOffset*FTWO_PI;
+         phaseIncs[pos] = phaseInc;
+      }
+      gains[pos] = mOsc.GetADSR()->Value(time) * volSq;
       
       time += gInvSampleRateMs;
    }
+   
+   mOsc.mOsc.Process(phases, phaseIncs, mWriteBuffer, bufferSize);
+   for (int pos=0; pos<bufferSize; ++pos)
+      mWriteBuffer[pos] *= gains[pos];
    GetVizBuffer()->WriteChunk(mWriteBuffer, bufferSize, 0);
    
    Add(out, mWriteBuffer, bufferSize);
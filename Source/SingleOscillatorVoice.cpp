@@ -12,6 +12,82 @@
 #include "Scale.h"
 #include "Profiler.h"
 #include "ChannelBuffer.h"
+#include "ScratchArena.h"
+#include "Float4.h"
+
+namespace
+{
+   //per-sample control values for one block, padded with silence up to a multiple of four
+   struct VoiceBlock
+   {
+      float* mGain;
+      float* mPhaseInc;
+      float* mDetune;
+      float* mPhaseOffset;
+      float* mPulseWidth;
+      float* mUnisonWidth;
+      int mPaddedSize;
+   };
+   
+   //phase01 is the position in the cycle, [0, 1)
+   template<OscillatorType kType>
+   inline Float4 WaveformValue(Float4 phase01, Float4 pulseWidth)
+   {
+      const Float4 one = Float4::Set(1);
+      const Float4 two = Float4::Set(2);
+      switch (kType)
+      {
+         case kOsc_Sin:
+            //sin(x) == -sin(x - pi), which puts us in the range Float4::Sin() wants
+            return -Float4::Sin(phase01 * Float4::Set(FTWO_PI) - Float4::Set(FPI));
+         case kOsc_Saw:
+            return phase01 * two - one;
+         case kOsc_NegSaw:
+            return one - phase01 * two;
+         case kOsc_Square:
+            return Float4::Select(Float4::GreaterThan(phase01, pulseWidth), -one, one);
+         case kOsc_Tri:
+         default:
+            return Float4::Abs(phase01 - Float4::Set(.5f)) * Float4::Set(4) - one;
+      }
+   }
+   
+   //renders one unison voice four samples at a time and adds it into left/right (right is null for mono)
+   template<OscillatorType kType>
+   void RenderUnisonVoice(const VoiceBlock& block, float& phase, float detuneFactor, float voiceGain, float pan, float unisonPan, float* left, float* right)
+   {
+      const Float4 wrap = Float4::Set(FTWO_PI * 2);
+      const Float4 invWrap = Float4::Set(1 / (FTWO_PI * 2));
+      const Float4 invCycle = Float4::Set(1 / FTWO_PI);
+      const Float4 one = Float4::Set(1);
+      
+      Float4 carry = Float4::Set(phase);
+      for (int pos=0; pos<block.mPaddedSize; pos += 4)
+      {
+         Float4 detune = Float4::Load(block.mDetune + pos) * Float4::Set(detuneFactor) + one;
+         Float4 phases = carry + (Float4::Load(block.mPhaseInc + pos) * detune).PrefixSum();
+         phases = phases - wrap * Float4::Floor(phases * invWrap);
+         carry = Float4::Set(phases.Last());
+         
+         Float4 cycles = (phases + Float4::Load(block.mPhaseOffset + pos)) * invCycle;
+         Float4 sample = WaveformValue<kType>(cycles - Float4::Floor(cycles), Float4::Load(block.mPulseWidth + pos));
+         sample = sample * Float4::Load(block.mGain + pos) * Float4::Set(voiceGain);
+         
+         if (right == nullptr)
+         {
+            (Float4::Load(left + pos) + sample).Store(left + pos);
+         }
+         else
+         {
+            Float4 panned = Float4::Set(pan) + Float4::Set(unisonPan) * Float4::Load(block.mUnisonWidth + pos);
+            panned = Float4::Clamp(panned, -one, one);
+            (Float4::Load(left + pos) + sample * (one - panned)).Store(left + pos);
+            (Float4::Load(right + pos) + sample * (panned + one)).Store(right + pos);
+         }
+      }
+      phase = carry.Last();
+   }
+}
 
 SingleOscillatorVoice::SingleOscillatorVoice(IDrawableModule* owner)
 : mUseFilter(false)
@@ -28,6 +104,11 @@ bool SingleOscillatorVoice::IsDone(double time)
    return mAdsr.IsDone(time);
 }
 
+float SingleOscillatorVoice::GetLevel(double time)
+{
+   return mAdsr.Value(time);
+}
+
 bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out)
 {
    PROFILER(SingleOscillatorVoice);
@@ -35,6 +116,150 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out)
    if (IsDone(time))
       return false;
    
+   ScratchArena::Scope scratch;
+   float* adsr = scratch.GetBuffer();
+   float* filterAdsr = scratch.GetBuffer();
+   bool running = mAdsr.Process(time, adsr, out->BufferSize());
+   if (mUseFilter)
+      mFilterAdsr.Process(time, filterAdsr, out->BufferSize());
+   
+   if (CanUseVectorPath())
+      ProcessVector(out, adsr, filterAdsr);
+   else
+      ProcessScalar(out, adsr, filterAdsr);
+   
+   return running;
+}
+
+bool SingleOscillatorVoice::CanUseVectorPath() const
+{
+   //sync, shuffle, random shapes and biased non-square shapes stay on the scalar path.
+   //checked once per block, so modulating into one of those takes effect at the next block
+   switch (mVoiceParams->mOscType)
+   {
+      case kOsc_Sin:
+      case kOsc_Saw:
+      case kOsc_NegSaw:
+      case kOsc_Tri:
+         if (mVoiceParams->mPulseWidth != .5f)
+            return false;
+         break;
+      case kOsc_Square:
+         break;
+      default:
+         return false;
+   }
+   return !mVoiceParams->mSync && mVoiceParams->mShuffle <= 0;
+}
+
+void SingleOscillatorVoice::ProcessVector(ChannelBuffer* out, const float* adsr, const float* filterAdsr)
+{
+   bool mono = (out->NumActiveChannels() == 1);
+   int bufferSize = out->BufferSize();
+   
+   ScratchArena::Scope scratch;
+   VoiceBlock block;
+   block.mGain = scratch.GetBuffer();
+   block.mPhaseInc = scratch.GetBuffer();
+   block.mDetune = scratch.GetBuffer();
+   block.mPhaseOffset = scratch.GetBuffer();
+   block.mPulseWidth = scratch.GetBuffer();
+   block.mUnisonWidth = scratch.GetBuffer();
+   block.mPaddedSize = (bufferSize + 3) & ~3;
+   float* summedLeft = scratch.GetBuffer();
+   float* summedRight = scratch.GetBuffer();
+   float* filterCutoff = scratch.GetBuffer();
+   float* filterQ = scratch.GetBuffer();
+   
+   //gather the control values a sample at a time, the sliders are still scalar
+   float lastPitch = -1;
+   float pitchPhaseInc = 0;
+   for (int pos=0; pos<bufferSize; ++pos)
+   {
+      if (mOwner)
+         mOwner->ComputeSliders(pos);
+      
+      float pitch = GetPitch(pos);
+      if (pitch != lastPitch) //the pitch only moves with bends, don't pay for PitchToFreq() every sample
+      {
+         lastPitch = pitch;
+         pitchPhaseInc = TheScale->PitchToFreq(pitch) * gTwoPiOverSampleRate;
+      }
+      
+      block.mGain[pos] = adsr[pos] * mVoiceParams->mVol * .4f / mVoiceParams->mUnison;
+      block.mPhaseInc[pos] = pitchPhaseInc * mVoiceParams->mMult;
+      block.mDetune[pos] = mVoiceParams->mDetune - 1;
+      block.mPhaseOffset[pos] = mVoiceParams->mPhaseOffset;
+      block.mPulseWidth[pos] = mVoiceParams->mPulseWidth;
+      block.mUnisonWidth[pos] = mVoiceParams->mUnisonWidth;
+      if (mUseFilter)
+      {
+         filterCutoff[pos] = filterAdsr[pos] * mVoiceParams->mFilterCutoff;
+         filterQ[pos] = mVoiceParams->mFilterQ;
+      }
+   }
+   for (int pos=bufferSize; pos<block.mPaddedSize; ++pos)
+   {
+      block.mGain[pos] = 0;
+      block.mPhaseInc[pos] = 0;  //keeps the padding from advancing the phase
+      block.mDetune[pos] = 0;
+      block.mPhaseOffset[pos] = 0;
+      block.mPulseWidth[pos] = .5f;
+      block.mUnisonWidth[pos] = 0;
+   }
+   
+   Clear(summedLeft, block.mPaddedSize);
+   if (!mono)
+      Clear(summedRight, block.mPaddedSize);
+   
+   int unison = MIN(mVoiceParams->mUnison, kMaxUnison);
+   for (int u=0; u<unison; ++u)
+   {
+      float unisonPan;
+      if (unison == 1)
+         unisonPan = 0;
+      else if (u == 0)
+         unisonPan = -1;
+      else if (u == 1)
+         unisonPan = 1;
+      else
+         unisonPan = mOscData[u].mDetuneFactor;
+      float voiceGain = (u >= 2) ? 1 - (mOscData[u].mDetuneFactor * .5f) : 1;
+      float* right = mono ? nullptr : summedRight;
+      
+      OscData& osc = mOscData[u];
+      switch (mVoiceParams->mOscType)
+      {
+         case kOsc_Sin: RenderUnisonVoice<kOsc_Sin>(block, osc.mPhase, osc.mDetuneFactor, voiceGain, GetPan(), unisonPan, summedLeft, right); break;
+         case kOsc_Saw: RenderUnisonVoice<kOsc_Saw>(block, osc.mPhase, osc.mDetuneFactor, voiceGain, GetPan(), unisonPan, summedLeft, right); break;
+         case kOsc_NegSaw: RenderUnisonVoice<kOsc_NegSaw>(block, osc.mPhase, osc.mDetuneFactor, voiceGain, GetPan(), unisonPan, summedLeft, right); break;
+         case kOsc_Square: RenderUnisonVoice<kOsc_Square>(block, osc.mPhase, osc.mDetuneFactor, voiceGain, GetPan(), unisonPan, summedLeft, right); break;
+         case kOsc_Tri: RenderUnisonVoice<kOsc_Tri>(block, osc.mPhase, osc.mDetuneFactor, voiceGain, GetPan(), unisonPan, summedLeft, right); break;
+         default: assert(false); break;
+      }
+   }
+   
+   if (mUseFilter)
+   {
+      for (int pos=0; pos<bufferSize; ++pos)
+      {
+         mFilterLeft.SetFilterParams(filterCutoff[pos], filterQ[pos]);
+         summedLeft[pos] = mFilterLeft.Filter(summedLeft[pos]);
+         if (!mono)
+         {
+            mFilterRight.SetFilterParams(filterCutoff[pos], filterQ[pos]);
+            summedRight[pos] = mFilterRight.Filter(summedRight[pos]);
+         }
+      }
+   }
+   
+   Add(out->GetChannel(0), summedLeft, bufferSize);
+   if (!mono)
+      Add(out->GetChannel(1), summedRight, bufferSize);
+}
+
+void SingleOscillatorVoice::ProcessScalar(ChannelBuffer* out, const float* adsr, const float* filterAdsr)
+{
    for (int u=0; u<mVoiceParams->mUnison && u<kMaxUnison; ++u)
       mOscData[u].mOsc.SetType(mVoiceParams->mOscType);
    
@@ -51,7 +276,7 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out)
             mOwner->ComputeSliders(pos);
       }
       
-      float adsrVal = mAdsr.Value(time);
+      float adsrVal = adsr[pos];
       float pitch = GetPitch(pos);
       float freq = TheScale->PitchToFreq(pitch) * mVoiceParams->mMult;
       float vol = mVoiceParams->mVol * .4f / mVoiceParams->mUnison;
@@ -122,7 +347,7 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out)
       if (mUseFilter)
       {
          //PROFILER(SingleOscillatorVoice_filter);
-         float f = mFilterAdsr.Value(time) * mVoiceParams->mFilterCutoff;
+         float f = filterAdsr[pos] * mVoiceParams->mFilterCutoff;
          float q = mVoiceParams->mFilterQ;
          mFilterLeft.SetFilterParams(f, q);
          summedLeft = mFilterLeft.Filter(summedLeft);
@@ -145,10 +370,7 @@ bool SingleOscillatorVoice::Process(double time, ChannelBuffer* out)
             out->GetChannel(1)[pos] += summedRight;
          }
       }
-      time += gInvSampleRateMs;
    }
-   
-   return true;
 }
 
 void SingleOscillatorVoice::Start(double time, float target)
@@ -54,9 +54,15 @@ public:
    bool Process(double time, ChannelBuffer* out) override;
    void SetVoiceParams(IVoiceParams* params) override;
    bool IsDone(double time) override;
+   float GetLevel(double time) override;
    
    static const int kMaxUnison = 8;
 private:
+   bool CanUseVectorPath() const;
+   //adsr and filterAdsr are the envelopes already rendered for the block (filterAdsr only when mUseFilter)
+   void ProcessVector(ChannelBuffer* out, const float* adsr, const float* filterAdsr);
+   void ProcessScalar(ChannelBuffer* out, const float* adsr, const float* filterAdsr);
+   
    struct OscData
    {
       OscData() : mPhase(0), mSyncPhase(0), mOsc(kOsc_Square), mDetuneFactor(0) {}
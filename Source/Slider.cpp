@@ -17,6 +17,8 @@
 #include "Push2Control.h"
 #include "Profiler.h"
 
+Atomic<int> FloatSlider::sModulationGeneration(0);
+
 FloatSlider::FloatSlider(IFloatSliderListener* owner, const char* label, int x, int y, int w, int h, float* var, float min, float max, int digits /* = -1 */)
 : mVar(var)
 , mWidth(w)
@@ -48,6 +50,7 @@ FloatSlider::FloatSlider(IFloatSliderListener* owner, const char* label, int x,
 , mComputeHasBeenCalledOnce(false)
 , mLastComputeTime(0)
 , mLastComputeSamplesIn(0)
+, mSampleAccurate(false)
 , mLastDisplayedValue(FLT_MAX)
 , mFloatEntry(nullptr)
 , mAllowMinMaxAdjustment(true)
@@ -93,12 +96,14 @@ void FloatSlider::SetLFO(FloatSliderLFOControl* lfo)
 {
    mLFOControl = lfo;
    mModulator = lfo;
+   ++sModulationGeneration;
 }
 
 void FloatSlider::SetModulator(IModulator* modulator)
 {
    mModulator = modulator;
    mLFOControl = nullptr;
+   ++sModulationGeneration;
 }
 
 void FloatSlider::SetLabel(const char* label)
@@ -385,6 +390,8 @@ void FloatSlider::SmoothUpdated()
    }
    if (mSmooth <= 0 && mIsSmoothing)
       TheTransport->RemoveAudioPoller(this);
+   if (mIsSmoothing != (mSmooth > 0))
+      ++sModulationGeneration;
    mIsSmoothing = mSmooth > 0;
 }
 
@@ -561,7 +568,7 @@ void FloatSlider::Compute(int samplesIn /*= 0*/)
    {
       float* var = mIsSmoothing ? &mSmoothTarget : mVar;
       float oldVal = *var;
-      *var = mModulator->Value(samplesIn);
+      *var = mModulator->GetBlockValue(samplesIn, mSampleAccurate);
       if (oldVal != *var && !mIsSmoothing)
       {
          //PROFILER(FloatSlider_Compute_UpdateSlider);
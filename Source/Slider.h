@@ -58,6 +58,11 @@ public:
    float& GetModulatorMin() { return mModulatorMin; }
    float& GetModulatorMax() { return mModulatorMax; }
    void OnTransportAdvanced(float amount) override;
+   //modulators are read through a per-block buffer, ramped between control points unless the module needs every sample
+   void SetSampleAccurate(bool sampleAccurate) { mSampleAccurate = sampleAccurate; }
+   bool IsModulated() const { return mModulator != nullptr || mIsSmoothing; }
+   void SetComputedByOwner() { mComputeHasBeenCalledOnce = true; }
+   static int GetModulationGeneration() { return sModulationGeneration.get(); }
    
    void Init() override;
    
@@ -133,6 +138,8 @@ private:
    bool mComputeHasBeenCalledOnce;
    double mLastComputeTime;
    int mLastComputeSamplesIn;
+   bool mSampleAccurate;
+   static Atomic<int> sModulationGeneration;   //bumped whenever any slider gains or loses a modulator
    
    float mLastDisplayedValue;
    
@@ -11,25 +11,21 @@
 #include "SpectralDisplay.h"
 #include "ModularSynth.h"
 #include "Profiler.h"
+#include "ScratchArena.h"
 
 namespace
 {
    const int kNumFFTBins = 1024;
    const int kBinIgnore = 2;
+   const int kOverlap = 4;
 };
 
 SpectralDisplay::SpectralDisplay()
 : IAudioProcessor(gBufferSize)
 , mWidth(400)
 , mHeight(100)
-, mFFT(kNumFFTBins)
-, mFFTData(kNumFFTBins, kNumFFTBins/2+1)
-, mRollingInputBuffer(kNumFFTBins)
+, mAnalyzer(kNumFFTBins, kOverlap)
 {
-   // Generate a window with a single raised cosine from N/4 to 3N/4
-   mWindower = new float[kNumFFTBins];
-   for (int i=0; i<kNumFFTBins; ++i)
-      mWindower[i] = -.5f*cos(FTWO_PI*i/kNumFFTBins)+.5f;
    mSmoother = new float[kNumFFTBins/2+1-kBinIgnore];
    for (int i=0; i<kNumFFTBins/2+1-kBinIgnore; ++i)
       mSmoother[i] = 0;
@@ -42,7 +38,6 @@ void SpectralDisplay::CreateUIControls()
 
 SpectralDisplay::~SpectralDisplay()
 {
-   delete[] mWindower;
    delete[] mSmoother;
 }
 
@@ -57,29 +52,27 @@ void SpectralDisplay::Process(double time)
    
    SyncBuffers();
    
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
    if (GetTarget())
    {
       ChannelBuffer* out = GetTarget()->GetBuffer();
       for (int ch=0; ch<GetBuffer()->NumActiveChannels(); ++ch)
       {
          if (ch == 0)
-            BufferCopy(gWorkBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
+            BufferCopy(workBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
          else
-            Add(gWorkBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
+            Add(workBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
          Add(out->GetChannel(ch), GetBuffer()->GetChannel(ch), out->BufferSize());
          GetVizBuffer()->WriteChunk(GetBuffer()->GetChannel(ch),GetBuffer()->BufferSize(), ch);
       }
    }
    
-   mRollingInputBuffer.WriteChunk(gWorkBuffer, GetBuffer()->BufferSize(), 0);
+   mAnalyzer.Write(workBuffer, GetBuffer()->BufferSize());
    
-   //copy rolling input buffer into working buffer and window it
-   mRollingInputBuffer.ReadChunk(mFFTData.mTimeDomain, kNumFFTBins, 0, 0);
-   Mult(mFFTData.mTimeDomain, mWindower, kNumFFTBins);
-   
-   mFFT.Forward(mFFTData.mTimeDomain,
-                mFFTData.mRealValues,
-                mFFTData.mImaginaryValues);
+   //nothing to analyze if nobody can see it
+   if (IsVisible() && !Minimized())
+      mAnalyzer.GetFrame();
       
    GetBuffer()->Reset();
 }
@@ -99,12 +92,13 @@ void SpectralDisplay::DrawModule()
    ofSetLineWidth(1);
 
    //raw
+   const STFTFrame& frame = mAnalyzer.GetLastFrame();
    int end = kNumFFTBins/2+1;
    ofBeginShape();
    for (int i=kBinIgnore; i<end; i++)
    {
       float x = sqrtf(float(i-kBinIgnore)/(end-kBinIgnore-1)) * w;
-      float samp = sqrtf(fabsf(mFFTData.mRealValues[i]) / end) * 3;
+      float samp = sqrtf(fabsf(frame.mRealValues[i]) / end) * 3;
       float y = ofClamp(samp, 0, 1) * h;
       ofVertex(x, h-y);
       
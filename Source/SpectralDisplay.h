@@ -14,8 +14,7 @@
 #include "IAudioProcessor.h"
 #include "IDrawableModule.h"
 #include "Slider.h"
-#include "FFT.h"
-#include "RollingBuffer.h"
+#include "STFTAnalyzer.h"
 
 class SpectralDisplay : public IAudioProcessor, public IDrawableModule, public IFloatSliderListener
 {
@@ -49,11 +48,8 @@ private:
    float mWidth;
    float mHeight;
    
-   float* mWindower;
    float* mSmoother;
 
-   ::FFT mFFT;
-   FFTData mFFTData;
-   RollingBuffer mRollingInputBuffer;
+   STFTAnalyzer mAnalyzer;
 };
 
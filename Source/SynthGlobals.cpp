@@ -19,6 +19,7 @@
 #include "PatchCable.h"
 #include "PatchCableSource.h"
 #include "ChannelBuffer.h"
+#include "SampleStorage.h"
 #include "IPulseReceiver.h"
 #include "exprtk/exprtk.hpp"
 
@@ -46,8 +47,6 @@ RetinaTrueTypeFont gFontFixedWidth;
 float gModuleDrawAlpha = 255;
 float gNullBuffer[kWorkBufferSize];
 float gZeroBuffer[kWorkBufferSize];
-float gWorkBuffer[kWorkBufferSize];
-ChannelBuffer gWorkChannelBuffer(kWorkBufferSize);
 IDrawableModule* gHoveredModule = nullptr;
 IUIControl* gHoveredUIControl = nullptr;
 IUIControl* gHotBindUIControl[10];
@@ -96,7 +95,7 @@ void SetGlobalSampleRate(int rate)
    gNyquistLimit = gSampleRate / 2.0f;
 }
 
-void DrawAudioBuffer(float width, float height, ChannelBuffer* buffer, float start, float end, float pos, float vol /*=1*/, ofColor color /*=ofColor::black*/)
+void DrawAudioBuffer(float width, float height, const ChannelBuffer* buffer, float start, float end, float pos, float vol /*=1*/, ofColor color /*=ofColor::black*/)
 {
    ofPushMatrix();
    if (buffer != nullptr)
@@ -362,7 +361,7 @@ float GetInterpolatedSample(double offset, const float* buffer, int bufferSize)
    return output;
 }
 
-float GetInterpolatedSample(double offset, ChannelBuffer* buffer, int bufferSize, float channelBlend)
+float GetInterpolatedSample(double offset, const ChannelBuffer* buffer, int bufferSize, float channelBlend)
 {
    assert(channelBlend <= buffer->NumActiveChannels());
    
@@ -378,6 +377,19 @@ float GetInterpolatedSample(double offset, ChannelBuffer* buffer, int bufferSize
           (channelBlend - channelA) * GetInterpolatedSample(offset, buffer->GetChannel(channelB), bufferSize);
 }
 
+float GetInterpolatedSample(double offset, const SampleStorage* buffer, int channel, int bufferSize)
+{
+   //just the two samples we need get converted. to read a whole block, SampleStorage::Decode() it first
+   FloatWrap(offset, bufferSize);
+   int pos = int(offset);
+   int posNext = int(offset+1) % bufferSize;
+   
+   float sample = buffer->GetSample(channel, pos);
+   float nextSample = buffer->GetSample(channel, posNext);
+   float a = offset - pos;
+   return (1-a)*sample + a*nextSample;
+}
+
 void WriteInterpolatedSample(double offset, float* buffer, int bufferSize, float sample)
 {
    FloatWrap(offset, bufferSize);
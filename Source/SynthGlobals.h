@@ -64,6 +64,7 @@ class IUIControl;
 class IDrawableModule;
 class RollingBuffer;
 class ChannelBuffer;
+class SampleStorage;
 
 typedef map<string,int> EnumMap;
 
@@ -88,8 +89,6 @@ extern RetinaTrueTypeFont gFontFixedWidth;
 extern float gModuleDrawAlpha;
 extern float gNullBuffer[4096];
 extern float gZeroBuffer[4096];
-extern float gWorkBuffer[4096];  //scratch buffer for doing work in
-extern ChannelBuffer gWorkChannelBuffer;
 extern IDrawableModule* gHoveredModule;
 extern IUIControl* gHoveredUIControl;
 extern IUIControl* gHotBindUIControl[10];
@@ -144,7 +143,7 @@ void LoadGlobalResources();
 
 void SetGlobalBufferSize(int size);
 void SetGlobalSampleRate(int rate);
-void DrawAudioBuffer(float width, float height, ChannelBuffer* buffer, float start, float end, float pos, float vol=1, ofColor color=ofColor::black);
+void DrawAudioBuffer(float width, float height, const ChannelBuffer* buffer, float start, float end, float pos, float vol=1, ofColor color=ofColor::black);
 void DrawAudioBuffer(float width, float height, const float* buffer, float start, float end, float pos, float vol=1, ofColor color=ofColor::black);
 void Add(float* buff1, const float* buff2, int bufferSize);
 void Mult(float* buff, float val, int bufferSize);
@@ -163,7 +162,8 @@ void DrawTextBold(string text, int x, int y, float size = 15);
 float GetStringWidth(string text, float size = 15);
 void AssertIfDenormal(float input);
 float GetInterpolatedSample(double offset, const float* buffer, int bufferSize);
-float GetInterpolatedSample(double offset, ChannelBuffer* buffer, int bufferSize, float channelBlend);
+float GetInterpolatedSample(double offset, const ChannelBuffer* buffer, int bufferSize, float channelBlend);
+float GetInterpolatedSample(double offset, const SampleStorage* buffer, int channel, int bufferSize);
 void WriteInterpolatedSample(double offset, float* buffer, int bufferSize, float sample);
 string GetRomanNumeralForDegree(int degree);
 void UpdateTarget(IDrawableModule* module);
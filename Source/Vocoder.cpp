@@ -15,8 +15,8 @@
 
 Vocoder::Vocoder()
 : IAudioProcessor(gBufferSize)
+, mAnalyzer(VOCODER_WINDOW_SIZE, STFTAnalyzer::kOverlapPerBlock)
 , mFFT(VOCODER_WINDOW_SIZE)
-, mRollingInputBuffer(VOCODER_WINDOW_SIZE)
 , mRollingOutputBuffer(VOCODER_WINDOW_SIZE)
 , mFFTData(VOCODER_WINDOW_SIZE, FFT_FREQDOMAIN_SIZE)
 , mRollingCarrierBuffer(VOCODER_WINDOW_SIZE)
@@ -39,11 +39,6 @@ Vocoder::Vocoder()
 , mCut(1)
 , mCutSlider(nullptr)
 {
-   // Generate a window with a single raised cosine from N/4 to 3N/4
-   mWindower = new float[VOCODER_WINDOW_SIZE];
-   for (int i=0; i<VOCODER_WINDOW_SIZE; ++i)
-      mWindower[i] = -.5*cos(FTWO_PI*i/VOCODER_WINDOW_SIZE)+.5;
-
    mCarrierInputBuffer = new float[GetBuffer()->BufferSize()];
    Clear(mCarrierInputBuffer, GetBuffer()->BufferSize());
 
@@ -69,7 +64,6 @@ void Vocoder::CreateUIControls()
 
 Vocoder::~Vocoder()
 {
-   delete[] mWindower;
    delete[] mCarrierInputBuffer;
 }
 
@@ -112,16 +106,8 @@ void Vocoder::Process(double time)
 
    mGate.ProcessAudio(time, GetBuffer());
 
-   mRollingInputBuffer.WriteChunk(GetBuffer()->GetChannel(0), bufferSize, 0);
-   
-   //copy rolling input buffer into working buffer and window it
-   mRollingInputBuffer.ReadChunk(mFFTData.mTimeDomain, VOCODER_WINDOW_SIZE, 0, 0);
-   Mult(mFFTData.mTimeDomain, mWindower, VOCODER_WINDOW_SIZE);
-   Mult(mFFTData.mTimeDomain, inputPreampSq, VOCODER_WINDOW_SIZE);
-
-   mFFT.Forward(mFFTData.mTimeDomain,
-                mFFTData.mRealValues,
-                mFFTData.mImaginaryValues);
+   mAnalyzer.Write(GetBuffer()->GetChannel(0), bufferSize);
+   const STFTFrame& frame = mAnalyzer.GetFrame();
 
    if (!fricative)
    {
@@ -137,7 +123,7 @@ void Vocoder::Process(double time)
 
    //copy rolling carrier buffer into working buffer and window it
    mRollingCarrierBuffer.ReadChunk(mCarrierFFTData.mTimeDomain, VOCODER_WINDOW_SIZE, 0, 0);
-   Mult(mCarrierFFTData.mTimeDomain, mWindower, VOCODER_WINDOW_SIZE);
+   Mult(mCarrierFFTData.mTimeDomain, mAnalyzer.GetWindow(), VOCODER_WINDOW_SIZE);
    Mult(mCarrierFFTData.mTimeDomain, carrierPreampSq, VOCODER_WINDOW_SIZE);
 
    mFFT.Forward(mCarrierFFTData.mTimeDomain,
@@ -146,8 +132,8 @@ void Vocoder::Process(double time)
 
    for (int i=0; i<FFT_FREQDOMAIN_SIZE; ++i)
    {
-      float real = mFFTData.mRealValues[i];
-      float imag = mFFTData.mImaginaryValues[i];
+      float real = frame.mRealValues[i] * inputPreampSq;
+      float imag = frame.mImaginaryValues[i] * inputPreampSq;
 
       //cartesian to polar
       float amp = 2.*sqrtf(real*real + imag*imag);
@@ -188,7 +174,7 @@ void Vocoder::Process(double time)
 
    //copy rolling input buffer into working buffer and window it
    for (int i=0; i<VOCODER_WINDOW_SIZE; ++i)
-      mRollingOutputBuffer.Accum(VOCODER_WINDOW_SIZE-i-1, mFFTData.mTimeDomain[i] * mWindower[i] * .0001f, 0);
+      mRollingOutputBuffer.Accum(VOCODER_WINDOW_SIZE-i-1, mFFTData.mTimeDomain[i] * mAnalyzer.GetWindow()[i] * .0001f, 0);
 
    Mult(GetBuffer()->GetChannel(0), (1-mDryWet)*inputPreampSq, GetBuffer()->BufferSize());
 
@@ -9,6 +9,7 @@
 #include "WaveformViewer.h"
 #include "ModularSynth.h"
 #include "Profiler.h"
+#include "ScratchArena.h"
 
 WaveformViewer::WaveformViewer()
 : IAudioProcessor(gBufferSize)
@@ -64,22 +65,24 @@ void WaveformViewer::Process(double time)
    SyncBuffers();
    
    int bufferSize = GetBuffer()->BufferSize();
+   ScratchArena::Scope scratch;
+   float* workBuffer = scratch.GetBuffer();
    if (GetTarget())
    {
       ChannelBuffer* out = GetTarget()->GetBuffer();
       for (int ch=0; ch<GetBuffer()->NumActiveChannels(); ++ch)
       {
          if (ch == 0)
-            BufferCopy(gWorkBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
+            BufferCopy(workBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
          else
-            Add(gWorkBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
+            Add(workBuffer, GetBuffer()->GetChannel(ch), GetBuffer()->BufferSize());
          Add(out->GetChannel(ch), GetBuffer()->GetChannel(ch), out->BufferSize());
          GetVizBuffer()->WriteChunk(GetBuffer()->GetChannel(ch),GetBuffer()->BufferSize(), ch);
       }
    }
    
    for (int i=0; i<bufferSize; ++i)
-      mAudioView[(i+mBufferVizOffset[!mDoubleBufferFlip]) % BUFFER_VIZ_SIZE][!mDoubleBufferFlip] = gWorkBuffer[i];
+      mAudioView[(i+mBufferVizOffset[!mDoubleBufferFlip]) % BUFFER_VIZ_SIZE][!mDoubleBufferFlip] = workBuffer[i];
       
    GetBuffer()->Reset();
    
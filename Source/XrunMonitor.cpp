@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    XrunMonitor.cpp
+    Created: 17 Oct 2026 2:41:05pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#include "XrunMonitor.h"
+#include "SynthGlobals.h"
+
+namespace
+{
+   const int kMaxGraphChanges = 16;
+}
+
+XrunMonitor::XrunMonitor()
+: mBlockStart(0)
+, mNumBlocks(0)
+, mNumMisses(0)
+, mNumReportedMisses(0)
+, mNumLostMisses(0)
+, mNumGraphChanges(0)
+{
+}
+
+void XrunMonitor::BeginBlock()
+{
+   mBlockStart = Time::getHighResolutionTicks();
+}
+
+void XrunMonitor::EndBlock(int bufferSize, const char* skippedBecause)
+{
+   int64 blockEnd = Time::getHighResolutionTicks();
+   int sequence = mNumBlocks.get();
+   
+   BlockInfo& block = mHistory[sequence % kHistoryLength];
+   block.mSequence = sequence;
+   block.mTime = gTime;
+   block.mWallMs = Time::getMillisecondCounterHiRes();
+   block.mDurationUs = Time::highResolutionTicksToSeconds(blockEnd - mBlockStart) * 1000000;
+   block.mBudgetUs = bufferSize / double(gSampleRate) * 1000000;
+   block.mSkippedBecause = skippedBecause;
+   block.mMissed = skippedBecause != nullptr || block.mDurationUs > block.mBudgetUs;
+   //module costs are only there while the profiler is running
+   block.mNumTopModules = Profiler::GetTopModuleCosts(block.mTopModules, kNumTopModules);
+   
+   if (block.mMissed)
+   {
+      int missIdx = mNumMisses.get();
+      mMisses[missIdx % kHistoryLength] = block;
+      ++mNumMisses;
+   }
+   ++mNumBlocks;
+}
+
+void XrunMonitor::NoteGraphChanged()
+{
+   if (mNumGraphChanges == kMaxGraphChanges)
+   {
+      for (int i=1; i<kMaxGraphChanges; ++i)
+         mGraphChanges[i-1] = mGraphChanges[i];
+      --mNumGraphChanges;
+   }
+   mGraphChanges[mNumGraphChanges++] = Time::getMillisecondCounterHiRes();
+}
+
+double XrunMonitor::GetLastGraphChangeBefore(double wallMs) const
+{
+   for (int i=mNumGraphChanges-1; i>=0; --i)
+   {
+      if (mGraphChanges[i] <= wallMs)
+         return mGraphChanges[i];
+   }
+   return -1;
+}
+
+void XrunMonitor::Poll()
+{
+   int numMisses = mNumMisses.get();
+   if (numMisses == mNumReportedMisses)
+      return;
+   
+   if (numMisses - mNumReportedMisses > kHistoryLength)
+   {
+      mNumLostMisses += numMisses - mNumReportedMisses - kHistoryLength;
+      mNumReportedMisses = numMisses - kHistoryLength;
+   }
+   
+   int numNew = numMisses - mNumReportedMisses;
+   for (; mNumReportedMisses < numMisses; ++mNumReportedMisses)
+      WriteReport(mMisses[mNumReportedMisses % kHistoryLength]);
+   
+   ofLog() << numNew << " audio deadline miss" << (numNew == 1 ? "" : "es") << ", see " << mReportPath;
+}
+
+void XrunMonitor::WriteReport(const BlockInfo& block)
+{
+   if (mReportPath.empty())
+   {
+      juce::File(ofToDataPath("recordings")).createDirectory();
+      mReportPath = ofToDataPath(ofGetTimestampString("recordings/xruns_%Y-%m-%d_%H-%M.txt"));
+   }
+   
+   //the block's wall clock time, from how long ago it happened
+   double ageMs = Time::getMillisecondCounterHiRes() - block.mWallMs;
+   Time when(Time::currentTimeMillis() - (int64)ageMs);
+   
+   string line = (when.formatted("%Y-%m-%d %H:%M:%S.") + String((int)(when.toMilliseconds() % 1000)).paddedLeft('0', 3)).toStdString() +
+                 "  block " + ofToString(block.mSequence) + "  " + ofToString(block.mDurationUs, 0) + "us / " + ofToString(block.mBudgetUs, 0) + "us";
+   if (block.mSkippedBecause)
+      line += string("  skipped, lock held by ") + block.mSkippedBecause;
+   
+   double graphChange = GetLastGraphChangeBefore(block.mWallMs);
+   if (graphChange >= 0)
+      line += "  graph changed " + ofToString((block.mWallMs - graphChange) / 1000, 2) + "s earlier";
+   
+   if (block.mNumTopModules > 0)
+   {
+      line += "  top:";
+      for (int i=0; i<block.mNumTopModules; ++i)
+         line += string(" ") + block.mTopModules[i].mName + " " + ofToString(block.mTopModules[i].mUs, 0) + "us";
+   }
+   
+   juce::File(mReportPath).appendText(line + "\n");
+}
+
+string XrunMonitor::GetSummary() const
+{
+   int numBlocks = mNumBlocks.get();
+   int numMisses = mNumMisses.get();
+   string summary = ofToString(numMisses) + " deadline misses in " + ofToString(numBlocks) + " blocks (" +
+                    ofToString(numBlocks > 0 ? numMisses * 100.0f / numBlocks : 0, 3) + "%)";
+   
+   const BlockInfo* worst = nullptr;
+   for (int i=MAX(0, numBlocks - kHistoryLength); i<numBlocks; ++i)
+   {
+      const BlockInfo& block = mHistory[i % kHistoryLength];
+      if (worst == nullptr || block.mDurationUs / block.mBudgetUs > worst->mDurationUs / worst->mBudgetUs)
+         worst = &block;
+   }
+   if (worst)
+      summary += ", worst recent block " + ofToString(worst->mDurationUs, 0) + "us / " + ofToString(worst->mBudgetUs, 0) + "us";
+   if (mNumLostMisses > 0)
+      summary += ", " + ofToString(mNumLostMisses) + " not logged";
+   if (!mReportPath.empty())
+      summary += ", report: " + mReportPath;
+   if (!Profiler::IsEnabled())
+      summary += " (enable the profiler to log module costs)";
+   return summary;
+}
@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    XrunMonitor.h
+    Created: 17 Oct 2026 2:41:05pm
+    Author:  Ryan Challinor
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "OpenFrameworksPort.h"
+#include "Profiler.h"
+
+//times every audio block against its real-time budget (buffer size / sample rate).
+//blocks that run over, or that get skipped because the audio thread couldn't get the lock,
+//are counted as misses and appended to a report in recordings/ from the ui thread.
+class XrunMonitor
+{
+public:
+   XrunMonitor();
+   
+   //audio thread
+   void BeginBlock();
+   void EndBlock(int bufferSize, const char* skippedBecause = nullptr);
+   
+   //ui thread
+   void Poll();
+   void NoteGraphChanged();
+   string GetSummary() const;
+   
+   static const int kHistoryLength = 256;
+   static const int kNumTopModules = 3;
+   
+   struct BlockInfo
+   {
+      int mSequence;
+      double mTime;           //gTime at the end of the block
+      double mWallMs;         //Time::getMillisecondCounterHiRes()
+      double mDurationUs;
+      double mBudgetUs;
+      bool mMissed;
+      const char* mSkippedBecause;  //who was holding the lock, if the block was skipped
+      int mNumTopModules;
+      Profiler::ModuleCost mTopModules[kNumTopModules];
+   };
+   
+private:
+   void WriteReport(const BlockInfo& block);
+   double GetLastGraphChangeBefore(double wallMs) const;
+   
+   int64 mBlockStart;
+   
+   //last kHistoryLength blocks, and separately the last kHistoryLength misses so a slow ui frame doesn't lose them
+   BlockInfo mHistory[kHistoryLength];
+   BlockInfo mMisses[kHistoryLength];
+   Atomic<int> mNumBlocks;
+   Atomic<int> mNumMisses;
+   
+   int mNumReportedMisses;
+   int mNumLostMisses;
+   string mReportPath;
+   double mGraphChanges[16];
+   int mNumGraphChanges;
+};